@@ -8,5 +8,9 @@ in vec4 colour;
 out vec4 out_FragColor;
 
 void main() {
-		out_FragColor = vec4( texture( u_Texture, texCoord ).r );
+	// signed distance field, the glyph's edge is at 0.5
+	// smooth over roughly one screen pixel, so any size is drawn crisply from the same atlas
+	float distance = texture( u_Texture, texCoord ).r;
+	float width = max( fwidth( distance ) * 0.7, 0.001 );
+	out_FragColor = vec4( smoothstep( 0.5 - width, 0.5 + width, distance ) );
 }
@@ -0,0 +1,29 @@
+#version 140
+
+#define NUM_TILE_STATES 7
+
+uniform sampler2D u_Texture;
+uniform vec4 u_Palette[NUM_TILE_STATES];
+
+in vec2 texCoord;
+in vec4 colour;
+
+out vec4 out_FragColor;
+
+void main() {
+	// one texel per tile, holding its state
+	vec2 cell = texCoord * vec2( textureSize( u_Texture, 0 ) );
+	ivec2 texel = min( ivec2( cell ), textureSize( u_Texture, 0 ) - ivec2( 1 ) );
+	int state = int( texelFetch( u_Texture, texel, 0 ).r * 255.0 + 0.5 );
+
+	// keep a pixel gap around each tile while they're big enough to see it
+	vec2 pixel = fwidth( cell );
+	vec2 edge = fract( cell );
+	if ( all( lessThan( pixel, vec2( 0.25 ) ) )
+		&& (any( lessThan( edge, pixel ) ) || any( greaterThan( edge, vec2( 1.0 ) - pixel ) )) )
+	{
+		discard;
+	}
+
+	out_FragColor = u_Palette[min( state, NUM_TILE_STATES - 1 )] * colour;
+}
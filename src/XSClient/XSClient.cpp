@@ -3,6 +3,7 @@
 #include "XSCommon/XSString.h"
 #include "XSCommon/XSCvar.h"
 #include "XSCommon/XSConsole.h"
+#include "XSCommon/XSFramePacer.h"
 #include "XSCommon/XSVector.h"
 #include "XSCommon/XSTimer.h"
 #include "XSCommon/XSGlobals.h"
@@ -10,6 +11,8 @@
 #include "XSClient/XSClientGame.h"
 #include "XSClient/XSClientConsole.h"
 #include "XSRenderer/XSFont.h"
+#include "XSRenderer/XSRenderer.h"
+#include "XSRenderer/XSTextMesh.h"
 #include "XSRenderer/XSView.h"
 
 namespace XS {
@@ -19,12 +22,18 @@ namespace XS {
 		uint64_t frameNum = 0u;
 
 		static Renderer::View *hudView = nullptr;
+		static Renderer::TextMesh *fpsMesh = nullptr;
+		static Renderer::TextMesh *speedsMesh = nullptr;
 		static Cvar *cl_drawFPS = nullptr;
 
 		ClientConsole *clientConsole = nullptr;
 
 		void Cmd_ToggleConsole( const commandContext_t * const context ) {
 			if ( !clientConsole ) {
+				if ( Renderer::IsHeadless() ) {
+					console.Print( "There's no client console with the null renderer\n" );
+					return;
+				}
 				throw XSError( "Tried to toggle client console without a valid instance" );
 			}
 
@@ -36,15 +45,28 @@ namespace XS {
 
 			ClientGame::Init();
 
+			// nothing is drawn headless, console output goes to stdout instead
+			if ( Renderer::IsHeadless() ) {
+				return;
+			}
+
 			// hud
-			const uint32_t width = Cvar::Get( "vid_width" )->GetInt();
-			const uint32_t height = Cvar::Get( "vid_height" )->GetInt();
-			hudView = new Renderer::View( width, height );
+			hudView = new Renderer::View( Renderer::vid_width->GetInt(), Renderer::vid_height->GetInt() );
+			fpsMesh = new Renderer::TextMesh();
+			speedsMesh = new Renderer::TextMesh();
 
 			clientConsole = new ClientConsole( &console );
 		}
 
 		void Shutdown( void ) {
+			delete clientConsole;
+			clientConsole = nullptr;
+			delete speedsMesh;
+			speedsMesh = nullptr;
+			delete fpsMesh;
+			fpsMesh = nullptr;
+
+			ClientGame::Shutdown();
 		}
 
 		void NetworkPump( void ) {
@@ -52,19 +74,15 @@ namespace XS {
 		}
 
 		void RunFrame( double dt ) {
-			static double stepTime = 0.0;
 			frameNum++;
 
-			// previousState = currentState;
-			// integrate( currentState, stepTime, dt );
-			stepTime += dt;
-
 			// process server updates
 			// simulate local entities
 			//	predict entities whose state is not managed by the server, created by either the client or server
 			//	e.g. client may create its own projectiles until the server overrides it
 			// movement prediction (movement commands have been generated by input poll)
-			ClientGame::RunFrame();
+			// the ClientGame publishes a snapshot at the end of the tick, drawing never touches the simulation
+			ClientGame::RunFrame( dt );
 		}
 
 		double GetElapsedTime( Timer::Resolution resolution ) {
@@ -120,14 +138,29 @@ namespace XS {
 				avg += samples[i];
 			}
 			avg /= (double)numSamples;
+			vector2 linePos = pos;
 			if ( cl_drawFPS->GetBool() ) {
-				font->Draw( pos, String::Format( "FPS:%.3f", 1000.0 / avg ) );
+				const Renderer::frameStats_t &frameStats = Renderer::GetFrameStats();
+				real64_t jitterUsec, maxJitterUsec;
+				Common::framePacer->GetJitter( &jitterUsec, &maxJitterUsec );
+				fpsMesh->Set( font, linePos, String::FormatTemp(
+					"FPS:%.3f frontend:%.2fms backend:%.2fms jitter:%.0fus (max %.0fus)", 1000.0 / avg,
+					frameStats.frontendMsec, frameStats.backendMsec, jitterUsec, maxJitterUsec ) );
+				fpsMesh->Draw();
+				linePos.y += font->lineHeight;
+			}
+			if ( Renderer::r_speeds->GetBool() ) {
+				const Renderer::frameStats_t &frameStats = Renderer::GetFrameStats();
+				speedsMesh->Set( font, linePos, String::FormatTemp( "quads:%u batches:%u draws:%u binds:%u skipped:%u",
+					frameStats.quads, frameStats.batches, frameStats.drawCalls, frameStats.bindsIssued,
+					frameStats.bindsSkipped ) );
+				speedsMesh->Draw();
 			}
 		}
 
-		void DrawFrame( double frametime ) {
+		void DrawFrame( double frametime, double alpha ) {
 			// draw game view
-			ClientGame::DrawFrame();
+			ClientGame::DrawFrame( alpha );
 
 			// draw HUD
 			DrawHUD( frametime );
@@ -45,8 +45,10 @@ namespace XS {
 		);
 
 		// draw a client frame and pass control to the ClientGame
+		// alpha is the fraction of a tick that has passed since the last RunFrame
 		void DrawFrame(
-			double frametime
+			double frametime,
+			double alpha
 		);
 
 	} // namespace Client
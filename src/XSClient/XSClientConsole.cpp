@@ -9,6 +9,7 @@
 #include "XSClient/XSClient.h"
 #include "XSClient/XSClientConsole.h"
 #include "XSRenderer/XSFont.h"
+#include "XSRenderer/XSTextMesh.h"
 #include "XSRenderer/XSView.h"
 #include "XSRenderer/XSRenderer.h"
 
@@ -16,6 +17,8 @@ namespace XS {
 
 	namespace Client {
 
+		#define WRAP_COUNT_UNKNOWN (UINT32_MAX)
+
 		static void InputCallback( const char *text ) {
 			Command::Append( text );
 		}
@@ -67,23 +70,77 @@ namespace XS {
 		}
 
 		ClientConsole::ClientConsole( Console *consoleInstance )
-		: console( consoleInstance ), visible( false ), scrollAmount( 0 ), lineCount( 24u ), font( nullptr )
+		: console( consoleInstance ), visible( false ), scrollAmount( 0 ), lineCount( 24u ), font( nullptr ),
+			fontSizeCount( 0u ), scrollbackLayout(), inputLinePos( 0.0f ), wrapCountsFirst( 0u )
 		{
-			const uint32_t width = Cvar::Get( "vid_width" )->GetInt();
-			const uint32_t height = Cvar::Get( "vid_height" )->GetInt();
+			width = Renderer::vid_width->GetInt();
+			height = Renderer::vid_height->GetInt();
 
 			con_fontSize = Cvar::Create( "con_fontSize", "12", "Size of the console font", CVAR_ARCHIVE );
+			con_scrollback = Cvar::Create( "con_scrollback", "1024", "Number of lines the console keeps",
+				CVAR_ARCHIVE );
+			console->buffer->Resize( con_scrollback->GetInt() );
+
+			// keep the sizes the console is drawn at in step with the cvars, rather than looking them up every frame
+			widthCallback = Renderer::vid_width->AddCallback( [this]( const Cvar *cvar ) {
+				width = cvar->GetInt();
+			} );
+			heightCallback = Renderer::vid_height->AddCallback( [this]( const Cvar *cvar ) {
+				height = cvar->GetInt();
+				Resize();
+			} );
+			scrollbackCallback = con_scrollback->AddCallback( [this]( const Cvar *cvar ) {
+				console->buffer->Resize( cvar->GetInt() );
+			} );
+
 			input = new InputField( InputCallback, InputAutoComplete );
 			view = new Renderer::View( width, height );
+			scrollbackMesh = new Renderer::TextMesh();
+			inputMesh = new Renderer::TextMesh();
+		}
+
+		ClientConsole::~ClientConsole() {
+			con_scrollback->RemoveCallback( scrollbackCallback );
+			Renderer::vid_height->RemoveCallback( heightCallback );
+			Renderer::vid_width->RemoveCallback( widthCallback );
+
+			delete inputMesh;
+			delete scrollbackMesh;
 		}
 
 		void ClientConsole::Resize( void ) {
 			if ( font ) {
-				const uint32_t height = Cvar::Get( "vid_height" )->GetInt();
 				lineCount = ((height / 2) / std::floor( font->lineHeight )) - 1;
 			}
 		}
 
+		uint32_t ClientConsole::GetWrapCount( uint32_t line ) {
+			// forget lines that have been dropped from the console
+			const uint32_t firstLine = console->buffer->GetFirstLine();
+			while ( !wrapCounts.empty() && wrapCountsFirst < firstLine ) {
+				wrapCounts.pop_front();
+				wrapCountsFirst++;
+			}
+			if ( wrapCounts.empty() ) {
+				wrapCountsFirst = line;
+			}
+
+			while ( line < wrapCountsFirst ) {
+				wrapCounts.push_front( WRAP_COUNT_UNKNOWN );
+				wrapCountsFirst--;
+			}
+			while ( line >= wrapCountsFirst + wrapCounts.size() ) {
+				wrapCounts.push_back( WRAP_COUNT_UNKNOWN );
+			}
+
+			uint32_t &count = wrapCounts[line - wrapCountsFirst];
+			if ( count == WRAP_COUNT_UNKNOWN ) {
+				const messageLine_t text = console->buffer->GetLine( line );
+				count = font->GetTextLineCount( vector2( 0.0f, 0.0f ), text.text, text.length );
+			}
+			return count;
+		}
+
 		void ClientConsole::Draw( void ) {
 			if ( !visible ) {
 				return;
@@ -91,49 +148,68 @@ namespace XS {
 
 			view->Bind();
 
-			// have to register it each frame so we can change the font size at runtime
-			font = Renderer::Font::Register( "console", static_cast<uint16_t>( con_fontSize->GetInt() ) );
+			// registering is a lookup, so con_fontSize can change at runtime without rasterising anything
+			if ( con_fontSize->GetModificationCount() != fontSizeCount ) {
+				font = Renderer::Font::Register( "console", static_cast<uint16_t>( con_fontSize->GetInt() ) );
+				fontSizeCount = con_fontSize->GetModificationCount();
+				Resize();
+			}
 
-			const uint32_t width = Cvar::Get( "vid_width" )->GetInt();
-			const uint32_t height = Cvar::Get( "vid_height" )->GetInt();
 			static const vector4 colour( 0.5f, 0.5f, 0.5f, 1.0f );
 			Renderer::DrawQuad( 0, 0, width, height / 2, 0.0f, 0.0f, 1.0f, 1.0f, &colour, nullptr );
 
-			Resize();
+			// the background and text are both opaque, so they're sorted by state unless the text is on top
+			Renderer::SetLayer( 1u );
 
-			// draw the console text
-			const uint32_t numLines = console->buffer->GetNumLines();
-			const uint32_t start = std::max(
-				0,
-				static_cast<int32_t>( numLines ) - scrollAmount - static_cast<int32_t>( lineCount )
-			);
-			std::vector<std::string> lines = console->buffer->FetchLines( start, lineCount );
+			MessageBuffer *buffer = console->buffer;
 
-			// TODO: might have to draw lines in reverse to compensate for one buffer element spanning multiple lines
+			// lay out the console text if anything it depends on has changed
+			const scrollbackLayout_t layout = { font, buffer->GetEndLine(), scrollAmount, lineCount, width };
 			const float x = 0.0f;
-			vector2 pos( x, 0.0f );
-			uint32_t drawn = 0u;
-			for ( const auto &it : lines ) {
-				const uint32_t linesToDraw = font->GetTextLineCount( pos, it );
-				drawn += linesToDraw;
-				if ( drawn > lineCount ) {
-					break;
+			if ( !(layout == scrollbackLayout) ) {
+				// wrapping depends on the font and width, so the cached counts do too
+				if ( font != scrollbackLayout.font || width != scrollbackLayout.width ) {
+					wrapCounts.clear();
+				}
+				scrollbackLayout = layout;
+				scrollbackMesh->Clear( font );
+
+				const uint32_t numLines = buffer->GetNumLines();
+				const uint32_t start = buffer->GetFirstLine() + std::max(
+					0,
+					static_cast<int32_t>( numLines ) - scrollAmount - static_cast<int32_t>( lineCount )
+				);
+				const uint32_t end = std::min( start + lineCount, buffer->GetEndLine() );
+
+				// TODO: might have to draw lines in reverse to compensate for one buffer element spanning multiple
+				//	lines
+				vector2 pos( x, 0.0f );
+				uint32_t drawn = 0u;
+				for ( uint32_t line = start; line != end; line++ ) {
+					const uint32_t linesToDraw = GetWrapCount( line );
+					drawn += linesToDraw;
+					if ( drawn > lineCount ) {
+						break;
+					}
+					const messageLine_t text = buffer->GetLine( line );
+					scrollbackMesh->Add( pos, text.text, text.length );
+					pos.y += linesToDraw * font->lineHeight;
 				}
-				font->Draw( pos, it );
-				pos.y += linesToDraw * font->lineHeight;
+				inputLinePos = pos.y;
 			}
+			scrollbackMesh->Draw();
 
 			// draw the input line
-			font->Draw( pos, String::Format( ">%s", input->GetLine() ) );
+			vector2 pos( x, inputLinePos );
+			inputMesh->Set( font, pos, String::FormatTemp( ">%s", input->GetLine() ) );
+			inputMesh->Draw();
 
 			// and now the cursor
 			const char *line = input->GetLine();
+			const char *cursor = line + input->GetCursorPos();
 			pos.x = font->GetGlyphWidth( '>' );
-			for ( const char *p = line; *p; p++ ) {
-				if ( p - line >= input->GetCursorPos() ) {
-					break;
-				}
-				pos.x += font->GetGlyphWidth( *p );
+			for ( const char *p = line; *p && p < cursor; ) {
+				pos.x += font->GetGlyphWidth( String::DecodeUTF8( &p, cursor ) );
 			}
 			//TODO: overstrike mode
 			if ( static_cast<uint32_t>( GetElapsedTime() ) & 256 ) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <deque>
+
 #include <SDL2/SDL_keycode.h>
 
 #include "XSCommon/XSCommand.h"
@@ -13,6 +15,7 @@ namespace XS {
 	namespace Renderer {
 		struct View;
 		class Font;
+		class TextMesh;
 	} // namespace Renderer
 
 	namespace Client {
@@ -20,14 +23,43 @@ namespace XS {
 		// driver for global Console instance to handle client interaction/rendering
 		extern class ClientConsole {
 		private:
-			Console			*console;
-			bool			 visible;
-			int32_t			 scrollAmount;
-			uint32_t		 lineCount;
-			Cvar 			*con_fontSize;
-			InputField		*input;
-			Renderer::View	*view;
-			Renderer::Font	*font;
+			// everything the scrollback's layout depends on, it's only laid out again when one of these changes
+			struct scrollbackLayout_t {
+				const Renderer::Font	*font;
+				uint32_t				 endLine; // changes whenever a line is printed
+				int32_t					 scrollAmount;
+				uint32_t				 lineCount;
+				uint32_t				 width;
+
+				inline bool operator==( const scrollbackLayout_t &rhs ) const {
+					return font == rhs.font && endLine == rhs.endLine && scrollAmount == rhs.scrollAmount
+						&& lineCount == rhs.lineCount && width == rhs.width;
+				}
+			};
+
+			Console				*console;
+			bool				 visible;
+			int32_t				 scrollAmount;
+			uint32_t			 lineCount;
+			Cvar 				*con_fontSize;
+			Cvar				*con_scrollback;
+			InputField			*input;
+			Renderer::View		*view;
+			Renderer::Font		*font;
+			uint32_t			 fontSizeCount; // con_fontSize's modification count when font was registered
+			uint32_t			 width, height; // vid_width and vid_height, updated when they change
+			uint32_t			 widthCallback, heightCallback, scrollbackCallback;
+			Renderer::TextMesh	*scrollbackMesh;
+			Renderer::TextMesh	*inputMesh;
+			scrollbackLayout_t	 scrollbackLayout;
+			real32_t			 inputLinePos; // where the scrollback ends
+			std::deque<uint32_t> wrapCounts; // by console line, for the scrollback's font and width
+			uint32_t			 wrapCountsFirst; // console line of wrapCounts.front()
+
+			// number of extra lines a console line takes to draw when it wraps, measured once and cached
+			uint32_t GetWrapCount(
+				uint32_t line
+			);
 
 		public:
 			// instantiate the ClientConsole for a specified Console object
@@ -40,7 +72,10 @@ namespace XS {
 			ClientConsole( const ClientConsole& ) = delete;
 			ClientConsole& operator=( const ClientConsole& ) = delete;
 
+			~ClientConsole();
+
 			// draw the console background, text and input field
+			// the text is laid out into meshes that are only rebuilt when it changes
 			void Draw(
 				void
 			);
@@ -1,17 +1,26 @@
 #include <list>
 #include <map>
+#include <memory>
 #include <queue>
 #include <algorithm>
 
 #include "XSClient/XSClient.h"
+#include "XSClient/XSClientGridTexture.h"
+#include "XSClient/XSClientPath.h"
+#include "XSClient/XSClientPathDatabase.h"
+#include "XSClient/XSClientPathMap.h"
 #include "XSCommon/XSCommon.h"
+#include "XSCommon/XSCommand.h"
 #include "XSCommon/XSConsole.h"
 #include "XSCommon/XSCvar.h"
 #include "XSCommon/XSFile.h"
 #include "XSCommon/XSString.h"
 #include "XSCommon/XSColours.h"
+#include "XSCommon/XSTripleBuffer.h"
+#include "XSCommon/XSVector.h"
 #include "XSRenderer/XSInternalFormat.h"
 #include "XSRenderer/XSMaterial.h"
+#include "XSRenderer/XSRenderer.h"
 #include "XSRenderer/XSShaderProgram.h"
 #include "XSRenderer/XSTexture.h"
 #include "XSRenderer/XSVertexAttributes.h"
@@ -22,99 +31,65 @@ namespace XS {
 	namespace ClientGame {
 
 		static Renderer::View *sceneView = nullptr;
+		static GridTexture *gridTexture = nullptr;
 		static constexpr size_t dimensions[2] = { 32u, 18u };
 
-		// each tile acts as a node in the graph to search
-		// a tile has a specific type (e.g. start, goal, wall)
-		// the only identifying property of a tile is the position, which is inferred by the tilemap
-
 		// references for A* pathfinding:
 		//	https://en.wikipedia.org/wiki/A*_search_algorithm#Pseudocode
 		//	http://www.policyalmanac.org/games/aStarTutorial.htm
 		//	http://theory.stanford.edu/~amitp/GameProgramming/Heuristics.html
 		//	http://code.activestate.com/recipes/577457-a-star-shortest-path-algorithm/
 
-		enum class TileType {
-			Blank,
-			Wall,
-			Start,
-			Goal
-		};
-
-		enum Direction {
-			NorthWest,
-			North,
-			NorthEast,
-			East,
-			SouthEast,
-			South,
-			SouthWest,
-			West,
-			NUM_DIRECTIONS
-		};
+		static Cvar *path_algorithm = nullptr;
+		static Cvar *path_agentSpeed = nullptr;
 
-		struct Tile {
-			int32_t		x, y;
+		// recalculated when vid_width or vid_height change
+		static real32_t tileWidth = 0.0f;
+		static real32_t tileHeight = 0.0f;
+		static uint32_t tileSizeWidthCount = 0u; // vid_width's modification count when the tile size was calculated
+		static uint32_t tileSizeHeightCount = 0u;
 
-			// a cost of -1 means it is an unmoveable direction (i.e. off the map)
-			// the lower the cost, the better the move
-			int16_t		cost[NUM_DIRECTIONS];
-			Tile		*neighbours[NUM_DIRECTIONS];
-			TileType	type;
+		#define PATH_STEP_MSEC (150.0)
 
-			// the only unique element for a tile is the coordinate, so use this for comparison
-			inline bool operator==( const Tile &rhs ) const {
-				if ( x == rhs.x && y == rhs.y ) {
-					return true;
-				}
-				return false;
-			}
+		// walks the route once the search has found one
+		struct agent_t {
+			vector2	position, previous; // in tiles, previous is where the last tick left it
+			size_t	nextTile; // index into the route
 		};
-		typedef std::vector<Tile *> nodeList;
-
-		struct Path {
-			enum class Algorithm {
-				AStar,
-				DStar, //TODO
-				Dijkstra, //TODO
-				BFS, //TODO
+
+		// everything the simulation owns, only touched by RunFrame and console commands
+		static struct GameState {
+			Tile										 tiles[dimensions[0]][dimensions[1]];
+			Grid										 grid;
+			Path										 path;
+			nodeList									 route;
+			Tile										*start, *goal;
+			std::map<const Tile*, int16_t>				 fScore;
+			std::map<const Tile*, int16_t>				 gScore;
+			std::vector<agent_t>						 agents;
+			std::vector<uint8_t>						 tileStates; // row-major TileState per tile
+			bool										 tileStatesChanged;
+			std::shared_ptr<const std::vector<uint8_t>>	 publishedStates;
+			real64_t									 stepTime; // simulated msec since the last search step
+			uint64_t									 tick;
+		} state = {};
+
+		// what DrawFrame gets to see of a tick, never changed once published
+		struct snapshot_t {
+			struct agent_t {
+				vector2	previous, current;
 			};
 
-			// tiles are added to the open list if it's to be explored
-			// when a tile is determined to be unsuitable, it's moved to the closed list and never checked again
-			nodeList				openList, closedList;
-			nodeList				result;
-			std::map<Tile*, Tile*>	cameFrom;
-			Algorithm				algorithm;
-
-			// calculate the H cost of moving from t1 to t2
-			int16_t HeuristicCost(
-				const Tile *t1,
-				const Tile *t2
-			);
-
-			// we've reached the goal, so backtrack to the start node and return that path
-			void Backtrack(
-				Tile *tile,
-				nodeList &route
-			);
-
-			// construct a path from current tile to goal tile
-			bool Find(
-				Tile *current,
-				Tile *goal,
-				nodeList &route
-			);
+			uint64_t									tick;
+			std::vector<agent_t>						agents;
+			// shared between snapshots until the search state changes
+			std::shared_ptr<const std::vector<uint8_t>>	tileStates;
 		};
 
-		static struct GameState {
-			Tile							 tiles[dimensions[0]][dimensions[1]];
-			Path							 path;
-			nodeList						 route;
-			Tile							*start, *goal;
-			std::map<const Tile*, int16_t>	 fScore;
-			std::map<const Tile*, int16_t>	 gScore;
-		} state = {};
+		// published at the end of every tick, DrawFrame interpolates within the latest one
+		static TripleBuffer<snapshot_t> snapshots;
+		// the tile states last given to the grid texture
+		static std::shared_ptr<const std::vector<uint8_t>> drawnStates;
 
 		static Tile *GetTile( uint32_t x, uint32_t y ) {
 			if ( x < dimensions[0] && y < dimensions[1] ) {
@@ -127,6 +102,51 @@ namespace XS {
 			return state.tiles[x][y].type;
 		}
 
+		static void SetTileState( const Tile *tile, TileState tileState ) {
+			uint8_t &value = state.tileStates[(tile->y * dimensions[0]) + tile->x];
+			if ( value != static_cast<uint8_t>( tileState ) ) {
+				value = static_cast<uint8_t>( tileState );
+				state.tileStatesChanged = true;
+			}
+		}
+
+		// derive every tile's state from its type, forgetting any search progress
+		static void ResetTileStates( void ) {
+			state.tileStates.assign( state.grid.Size(), static_cast<uint8_t>( TileState::Blank ) );
+			state.tileStatesChanged = true;
+			for ( uint32_t x = 0u; x < dimensions[0]; x++ ) {
+				for ( uint32_t y = 0u; y < dimensions[1]; y++ ) {
+					const Tile *tile = state.grid.Get( x, y );
+					switch ( tile->type ) {
+
+					case TileType::Blank: {
+						SetTileState( tile, TileState::Blank );
+					} break;
+
+					case TileType::Wall: {
+						SetTileState( tile, TileState::Wall );
+					} break;
+
+					case TileType::Start: {
+						SetTileState( tile, TileState::Start );
+					} break;
+
+					case TileType::Goal: {
+						SetTileState( tile, TileState::Goal );
+					} break;
+
+					}
+				}
+			}
+		}
+
+		// show search progress on blank tiles, start/goal/walls keep their own colour
+		static void MarkTile( const Tile *tile, TileState tileState ) {
+			if ( tile->type == TileType::Blank ) {
+				SetTileState( tile, tileState );
+			}
+		}
+
 		int16_t Path::HeuristicCost( const Tile *t1, const Tile *t2 ) {
 			switch( algorithm ) {
 
@@ -160,6 +180,7 @@ namespace XS {
 			//	nodes
 			while ( tile ) {
 				route.insert( route.begin(), tile );
+				MarkTile( tile, TileState::Route );
 				tile = cameFrom[tile];
 			}
 			//TODO: smooth the path
@@ -168,6 +189,10 @@ namespace XS {
 		bool Path::Find( Tile *current, Tile *goal, nodeList &route ) {
 			bool finished = false;
 
+			if ( complete ) {
+				return true;
+			}
+
 			switch( algorithm ) {
 
 				case Algorithm::AStar: {
@@ -190,7 +215,7 @@ namespace XS {
 						if ( current == goal ) {
 							//openList.clear();
 							Backtrack( current, route );
-							finished = true;
+							finished = complete = true;
 							break;
 						}
 
@@ -199,6 +224,7 @@ namespace XS {
 						if ( it != openList.end() ) {
 							openList.erase( it );
 							closedList.push_back( current );
+							MarkTile( current, TileState::Closed );
 						}
 
 						// then look at its neighbours
@@ -229,6 +255,7 @@ namespace XS {
 								// if neighbour is not in the open set
 								if ( std::find( openList.begin(), openList.end(), neighbour ) == openList.end() ) {
 									openList.push_back( neighbour );
+									MarkTile( neighbour, TileState::Open );
 									openList = std::vector<Tile *>( openList.begin(), openList.end() );
 								}
 							}
@@ -236,6 +263,33 @@ namespace XS {
 					}
 				} break;
 
+				// the remaining algorithms run a complete query in one step
+				case Algorithm::IDAStar:
+				case Algorithm::Fringe:
+				case Algorithm::SMAStar:
+				case Algorithm::HDAStar:
+				case Algorithm::BidirectionalAStar:
+				case Algorithm::BidirectionalDijkstra: {
+					searchStats_t stats;
+					finished = complete = true;
+					if ( Search( algorithm, state.grid, current, goal, route, &stats ) ) {
+						for ( const auto &tile : route ) {
+							MarkTile( tile, TileState::Route );
+						}
+						console.Print( "%s: route cost %i, %u expanded, peak %.1f KiB, %.3f ms\n",
+							GetAlgorithmName( algorithm ), stats.cost, stats.expanded, stats.peakBytes / 1024.0,
+							stats.msec );
+					}
+					else if ( stats.exhausted ) {
+						console.Print( "%s: node budget exhausted after %u expanded, %.3f ms, raise path_smaNodes\n",
+							GetAlgorithmName( algorithm ), stats.expanded, stats.msec );
+					}
+					else {
+						console.Print( "%s: no route found, %u expanded, peak %.1f KiB, %.3f ms\n",
+							GetAlgorithmName( algorithm ), stats.expanded, stats.peakBytes / 1024.0, stats.msec );
+					}
+				} break;
+
 				default: {
 					//TODO: handle other algo's
 				} break;
@@ -251,22 +305,8 @@ namespace XS {
 
 		static void GenerateMaze( void ) {
 			// initialise the tiles
-			for ( size_t x = 0u; x < dimensions[0]; x++ ) {
-				for ( size_t y = 0u; y < dimensions[1]; y++ ) {
-					state.tiles[x][y].x = x;
-					state.tiles[x][y].y = y;
-					state.tiles[x][y].type = TileType::Blank;
-
-					state.tiles[x][y].neighbours[NorthWest]	= GetTile( x - 1, y - 1 );
-					state.tiles[x][y].neighbours[North]		= GetTile( x    , y - 1 );
-					state.tiles[x][y].neighbours[NorthEast]	= GetTile( x + 1, y - 1 );
-					state.tiles[x][y].neighbours[East]			= GetTile( x + 1, y     );
-					state.tiles[x][y].neighbours[SouthEast]	= GetTile( x + 1, y + 1 );
-					state.tiles[x][y].neighbours[South]		= GetTile( x    , y + 1 );
-					state.tiles[x][y].neighbours[SouthWest]	= GetTile( x - 1, y + 1 );
-					state.tiles[x][y].neighbours[West]			= GetTile( x - 1, y     );
-				}
-			}
+			state.grid = { &state.tiles[0][0], dimensions[0], dimensions[1] };
+			InitGrid( state.grid );
 
 			// surround the map in a box
 			for ( size_t x = 0u; x < dimensions[0]; x++ ) {
@@ -346,13 +386,151 @@ namespace XS {
 			//	5 iterations?
 		}
 
+		// toggle a wall on the demo map, resident Dijkstra maps are repaired incrementally
+		//	pathwall <x> <y>
+		static void Cmd_PathWall( const commandContext_t * const context ) {
+			if ( context->size() < 2 ) {
+				console.Print( "usage: pathwall <x> <y>\n" );
+				return;
+			}
+
+			Tile *tile = state.grid.Get( atoi( (*context)[0].c_str() ), atoi( (*context)[1].c_str() ) );
+			if ( !tile || tile->type == TileType::Start || tile->type == TileType::Goal ) {
+				console.Print( "pathwall: can't change that tile\n" );
+				return;
+			}
+
+			tile->type = (tile->type == TileType::Wall) ? TileType::Blank : TileType::Wall;
+			SetTileState( tile, (tile->type == TileType::Wall) ? TileState::Wall : TileState::Blank );
+			DijkstraMapsTileChanged( state.grid, tile );
+
+			const DijkstraMap *goalMap = GetDijkstraMap( "goal" );
+			if ( goalMap ) {
+				const int32_t distance = goalMap->Distance( state.start );
+				if ( distance == PATH_COST_INFINITE ) {
+					console.Print( "pathwall: goal is unreachable from the start\n" );
+				}
+				else {
+					console.Print( "pathwall: distance from start to goal is now %i\n", distance );
+				}
+			}
+		}
+
+		// build a compressed path database for the demo map, or map a previously written one, and route start to goal
+		//	pathcpd [file]
+		static void Cmd_PathCPD( const commandContext_t * const context ) {
+			const char *gamePath = context->size() ? (*context)[0].c_str() : "cache/demo.cpd";
+
+			const PathDatabase *database = new PathDatabase( state.grid, gamePath );
+			if ( !database->IsValid() ) {
+				// missing, or written for a different map
+				delete database;
+				database = new PathDatabase( state.grid );
+				if ( !database->Write( gamePath ) ) {
+					console.Print( "pathcpd: couldn't write %s\n", gamePath );
+				}
+			}
+
+			nodeList route;
+			searchStats_t stats = {};
+			if ( database->Extract( state.start, state.goal, route, &stats ) ) {
+				console.Print( "pathcpd: route cost %i, %u tiles, database %.1f KiB\n", stats.cost,
+					static_cast<uint32_t>( route.size() ), database->Bytes() / 1024.0 );
+			}
+			else {
+				console.Print( "pathcpd: no route found\n" );
+			}
+			delete database;
+		}
+
+		// walk each agent along the route at path_agentSpeed, starting over from the beginning once it's done
+		static void MoveAgents( real64_t dt ) {
+			if ( state.route.empty() ) {
+				return;
+			}
+			if ( state.agents.empty() ) {
+				const vector2 start( state.route.front()->x, state.route.front()->y );
+				state.agents.push_back( { start, start, 1u } );
+			}
+
+			const real32_t stepSize = path_agentSpeed->GetFloat() * static_cast<real32_t>( dt * 0.001 );
+			for ( auto &agent : state.agents ) {
+				agent.previous = agent.position;
+				real32_t remaining = stepSize;
+				while ( remaining > 0.0f ) {
+					if ( agent.nextTile >= state.route.size() ) {
+						// teleport, there's nothing to interpolate back across the map
+						const Tile *tile = state.route.front();
+						agent.position = agent.previous = vector2( tile->x, tile->y );
+						agent.nextTile = 1u;
+						break;
+					}
+
+					const Tile *tile = state.route[agent.nextTile];
+					const vector2 delta = vector2( tile->x, tile->y ) - agent.position;
+					const real32_t distance = std::sqrt( (delta.x * delta.x) + (delta.y * delta.y) );
+					if ( distance > remaining ) {
+						agent.position += delta * (remaining / distance);
+						break;
+					}
+					agent.position = vector2( tile->x, tile->y );
+					remaining -= distance;
+					agent.nextTile++;
+				}
+			}
+		}
+
+		// copy out what DrawFrame needs, the tile states are only copied when they've changed
+		static void PublishSnapshot( void ) {
+			snapshot_t &snapshot = snapshots.Back();
+			snapshot.tick = state.tick;
+			snapshot.agents.clear();
+			for ( const auto &agent : state.agents ) {
+				snapshot.agents.push_back( { agent.previous, agent.position } );
+			}
+			if ( state.tileStatesChanged ) {
+				state.publishedStates = std::make_shared<const std::vector<uint8_t>>( state.tileStates );
+				state.tileStatesChanged = false;
+			}
+			snapshot.tileStates = state.publishedStates;
+			snapshots.Publish();
+		}
+
 		void Init( void ) {
-			const uint32_t width = Cvar::Get( "vid_width" )->GetInt();
-			const uint32_t height = Cvar::Get( "vid_height" )->GetInt();
-			sceneView = new Renderer::View( width, height, RenderScene );
+			const bool headless = Renderer::IsHeadless();
+			if ( !headless ) {
+				sceneView = new Renderer::View( Renderer::vid_width->GetInt(), Renderer::vid_height->GetInt(),
+					RenderScene );
+			}
+
+			path_algorithm = Cvar::Create( "path_algorithm", "astar",
+				"Search used for the demo map (astar, idastar, fringe, smastar, hdastar, bidastar, bidijkstra)",
+				CVAR_ARCHIVE );
+			path_agentSpeed = Cvar::Create( "path_agentSpeed", "4",
+				"Tiles per second the agent walks along the route once it has been found", CVAR_ARCHIVE );
+			InitSearch();
+			Command::AddCommand( "pathbench", Cmd_PathBench );
+			Command::AddCommand( "pathscale", Cmd_PathScale );
+			Command::AddCommand( "pathmaps", Cmd_PathMaps );
+			Command::AddCommand( "pathnearest", Cmd_PathNearest );
+			Command::AddCommand( "pathcpd", Cmd_PathCPD );
+			Command::AddCommand( "pathcpdbench", Cmd_PathCPDBench );
+			Command::AddCommand( "pathwall", Cmd_PathWall );
 
 			GenerateMaze();
+			ResetTileStates();
+			if ( !headless ) {
+				gridTexture = new GridTexture( dimensions[0], dimensions[1] );
+			}
+
+			// every tile's distance to the goal stays resident
+			CreateDijkstraMap( "goal", state.grid )->AddSeed( state.goal );
+
 			state.path.algorithm = Path::Algorithm::AStar;
+			if ( !GetAlgorithm( path_algorithm->GetCString(), &state.path.algorithm ) ) {
+				console.Print( "Unknown path_algorithm \"%s\", using astar\n", path_algorithm->GetCString() );
+			}
+			state.path.complete = false;
 			state.path.closedList.clear();
 			// populate the open list with the start position
 			state.path.openList.push_back( state.start );
@@ -361,70 +539,64 @@ namespace XS {
 			state.gScore[state.start] = 0;
 			state.fScore[state.start] = state.gScore[state.start]
 				+ state.path.HeuristicCost( state.start, state.goal );
-		}
 
-		void RunFrame( void ) {
-			static double lastTime = 0.0;
-			const double currentTime = Client::GetElapsedTime();
-			if ( lastTime < currentTime - 150 ) {
-				// step every 150ms
-				state.path.Find( state.start, state.goal, state.route );
-				lastTime = currentTime;
-			}
+			// so the first frame has something to draw
+			PublishSnapshot();
 		}
 
-		void DrawFrame( void ) {
-			sceneView->Bind();
-
-			const uint32_t screenWidth = Cvar::Get( "vid_width" )->GetInt();
-			const uint32_t screenHeight = Cvar::Get( "vid_height" )->GetInt();
-
-			const real32_t tileWidth = screenWidth / dimensions[0];
-			const real32_t tileHeight = screenHeight / dimensions[1];
+		void Shutdown( void ) {
+			DeleteAllDijkstraMaps();
+			delete gridTexture;
+			gridTexture = nullptr;
+			drawnStates.reset();
+		}
 
-			for ( size_t x = 0u; x < dimensions[0]; x++ ) {
-				for ( size_t y = 0u; y < dimensions[1]; y++ ) {
-					const Tile *tile = GetTile( x, y );
-					const vector4 *colour = nullptr;
-					switch( tile->type ) {
+		void RunFrame( real64_t dt ) {
+			state.tick++;
 
-					case TileType::Blank: {
-						if ( std::find( state.path.openList.begin(), state.path.openList.end(), tile )
-							!= state.path.openList.end() )
-						{
-							colour = &colourTable[ColourIndex( COLOUR_YELLOW )];
-						}
-						if ( std::find( state.path.closedList.begin(), state.path.closedList.end(), tile )
-							!= state.path.closedList.end() )
-						{
-							colour = &colourTable[ColourIndex( COLOUR_ORANGE )];
-						}
-						if ( std::find( state.route.begin(), state.route.end(), tile ) != state.route.end() ) {
-							colour = &colourTable[ColourIndex( COLOUR_BLUE )];
-						}
-					} break;
+			// step the search on simulated time, so it runs at the same pace whatever the tick rate is
+			state.stepTime += dt;
+			while ( state.stepTime >= PATH_STEP_MSEC ) {
+				state.path.Find( state.start, state.goal, state.route );
+				state.stepTime -= PATH_STEP_MSEC;
+			}
 
-					case TileType::Wall: {
-						colour = &colourTable[ColourIndex( COLOUR_GREY )];
-					} break;
+			MoveAgents( dt );
+			PublishSnapshot();
+		}
 
-					case TileType::Start: {
-						colour = &colourTable[ColourIndex( COLOUR_GREEN )];
-					} break;
+		void DrawFrame( real64_t alpha ) {
+			// keep drawing the last snapshot if there was no tick since the last frame
+			snapshots.Acquire();
+			const snapshot_t &snapshot = snapshots.Front();
 
-					case TileType::Goal: {
-						colour = &colourTable[ColourIndex( COLOUR_RED )];
-					} break;
+			sceneView->Bind();
 
-					}
+			if ( Renderer::vid_width->GetModificationCount() != tileSizeWidthCount
+				|| Renderer::vid_height->GetModificationCount() != tileSizeHeightCount )
+			{
+				const uint32_t screenWidth = Renderer::vid_width->GetInt();
+				const uint32_t screenHeight = Renderer::vid_height->GetInt();
+				tileWidth = screenWidth / dimensions[0];
+				tileHeight = screenHeight / dimensions[1];
+				tileSizeWidthCount = Renderer::vid_width->GetModificationCount();
+				tileSizeHeightCount = Renderer::vid_height->GetModificationCount();
+			}
 
-					Renderer::DrawQuad(
-						(x * tileWidth) + 1.0f,
-						(y * tileHeight) + 1.0f,
-						tileWidth - 2.0f,
-						tileHeight - 2.0f,
-						0.0f, 0.0f, 1.0f, 1.0f, colour, nullptr );
-				}
+			// the whole grid is one quad, only uploading rows that changed since the last snapshot we drew
+			if ( snapshot.tileStates && snapshot.tileStates != drawnStates ) {
+				gridTexture->SetStates( *snapshot.tileStates );
+				drawnStates = snapshot.tileStates;
+			}
+			gridTexture->Draw( 0.0f, 0.0f, tileWidth * dimensions[0], tileHeight * dimensions[1] );
+
+			// agents are drawn between where the last two ticks left them
+			Renderer::SetLayer( 1u );
+			const vector4 &agentColour = colourTable[ColourIndex( COLOUR_PURPLE )];
+			for ( const auto &agent : snapshot.agents ) {
+				const vector2 position = vector2::lerp( agent.previous, static_cast<real32_t>( alpha ), agent.current );
+				Renderer::DrawQuad( (position.x + 0.25f) * tileWidth, (position.y + 0.25f) * tileHeight,
+					tileWidth * 0.5f, tileHeight * 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, &agentColour, nullptr );
 			}
 		}
 
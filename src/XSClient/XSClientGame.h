@@ -9,14 +9,20 @@ namespace XS {
 			void
 		);
 
-		// run a frame, simulate entities
-		void RunFrame(
+		// free anything allocated by the ClientGame
+		void Shutdown(
 			void
 		);
 
+		// run a tick of dt msec, simulate entities and publish a snapshot of the result
+		void RunFrame(
+			real64_t dt
+		);
+
 		// prepare the scene for rendering, adding renderable objects to the view
+		// alpha is how far into the next tick this frame is, positions are interpolated from the latest snapshot
 		void DrawFrame(
-			void
+			real64_t alpha
 		);
 
 	} // namespace ClientGame
@@ -0,0 +1,103 @@
+#include "XSCommon/XSCommon.h"
+#include "XSCommon/XSColours.h"
+#include "XSCommon/XSVector.h"
+#include "XSClient/XSClientGridTexture.h"
+#include "XSRenderer/XSInternalFormat.h"
+#include "XSRenderer/XSMaterial.h"
+#include "XSRenderer/XSRenderer.h"
+#include "XSRenderer/XSShaderProgram.h"
+#include "XSRenderer/XSTexture.h"
+#include "XSRenderer/XSVertexAttributes.h"
+
+namespace XS {
+
+	namespace ClientGame {
+
+		// uniform names are kept by the shader program, so they can't be formatted on the fly
+		static const struct {
+			const char	*uniform;
+			char		 colour;
+		} palette[] = {
+			{ "u_Palette[0]", COLOUR_WHITE }, // TileState::Blank
+			{ "u_Palette[1]", COLOUR_GREY }, // TileState::Wall
+			{ "u_Palette[2]", COLOUR_GREEN }, // TileState::Start
+			{ "u_Palette[3]", COLOUR_RED }, // TileState::Goal
+			{ "u_Palette[4]", COLOUR_YELLOW }, // TileState::Open
+			{ "u_Palette[5]", COLOUR_ORANGE }, // TileState::Closed
+			{ "u_Palette[6]", COLOUR_BLUE }, // TileState::Route
+		};
+		static_assert( ARRAY_LEN( palette ) == static_cast<size_t>( TileState::NUM_TILE_STATES ),
+			"GridTexture palette does not match TileState" );
+
+		GridTexture::GridTexture( uint32_t width, uint32_t height )
+		: width( width ), height( height ), states( width * height, 0u ), dirtyRows( height, 0u ), dirty( false )
+		{
+			texture = new Renderer::Texture( width, height, Renderer::InternalFormat::R8, states.data() );
+
+			static const Renderer::VertexAttribute attributes[] = {
+				{ 0, "in_Position" },
+				{ 1, "in_TexCoord" },
+				{ 2, "in_Colour" }
+			};
+			program = new Renderer::ShaderProgram( "quad", "tilemap", attributes, ARRAY_LEN( attributes ) );
+			for ( const auto &entry : palette ) {
+				const vector4 &colour = colourTable[ColourIndex( entry.colour )];
+				program->SetUniform4( entry.uniform, colour.r, colour.g, colour.b, colour.a );
+			}
+
+			material = new Renderer::Material();
+			Renderer::Material::SamplerBinding samplerBinding;
+			samplerBinding.unit = 0;
+			samplerBinding.texture = texture;
+			material->samplerBindings.push_back( samplerBinding );
+			material->shaderProgram = program;
+			material->opaque = true;
+		}
+
+		GridTexture::~GridTexture() {
+			delete material;
+			delete program;
+			delete texture;
+		}
+
+		void GridTexture::SetStates( const std::vector<uint8_t> &newStates ) {
+			SDL_assert( newStates.size() == states.size() );
+
+			for ( uint32_t y = 0u; y < height; y++ ) {
+				const size_t offset = y * width;
+				if ( std::memcmp( &states[offset], &newStates[offset], width ) ) {
+					std::memcpy( &states[offset], &newStates[offset], width );
+					dirtyRows[y] = 1u;
+					dirty = true;
+				}
+			}
+		}
+
+		void GridTexture::Upload( void ) {
+			uint32_t y = 0u;
+			while ( y < height ) {
+				if ( !dirtyRows[y] ) {
+					y++;
+					continue;
+				}
+
+				const uint32_t first = y;
+				while ( y < height && dirtyRows[y] ) {
+					dirtyRows[y++] = 0u;
+				}
+				Renderer::UpdateTexture( texture, 0u, first, width, y - first, &states[first * width] );
+			}
+			dirty = false;
+		}
+
+		void GridTexture::Draw( real32_t x, real32_t y, real32_t w, real32_t h ) {
+			if ( dirty ) {
+				Upload();
+			}
+
+			Renderer::DrawQuad( x, y, w, h, 0.0f, 0.0f, 1.0f, 1.0f, nullptr, material );
+		}
+
+	} // namespace ClientGame
+
+} // namespace XS
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+
+#include "XSClient/XSClientPath.h"
+
+namespace XS {
+
+	namespace Renderer {
+		class ShaderProgram;
+		class Texture;
+		struct Material;
+	} // namespace Renderer
+
+	namespace ClientGame {
+
+		// what a tile looks like, written by the pathfinder as it goes
+		enum class TileState : uint8_t {
+			Blank = 0,
+			Wall,
+			Start,
+			Goal,
+			Open,
+			Closed,
+			Route,
+			NUM_TILE_STATES
+		};
+
+		// the whole grid drawn as a single quad, sampling one texel per tile
+		// keeps its own copy of the tile states, only the rows that changed are uploaded before the next draw
+		class GridTexture {
+		private:
+			uint32_t				 width, height;
+			std::vector<uint8_t>	 states; // row-major, i.e. states[y * width + x]
+			std::vector<uint8_t>	 dirtyRows;
+			bool					 dirty;
+			Renderer::Texture		*texture;
+			Renderer::ShaderProgram	*program;
+			Renderer::Material		*material;
+
+			// queue an upload for each run of consecutive dirty rows, the current view must be bound
+			void Upload(
+				void
+			);
+
+		public:
+			// don't allow default instantiation
+			GridTexture() = delete;
+			GridTexture( const GridTexture& ) = delete;
+			GridTexture& operator=( const GridTexture& ) = delete;
+
+			GridTexture(
+				uint32_t width,
+				uint32_t height
+			);
+
+			~GridTexture();
+
+			// take a copy of every tile's state, row-major, and mark the rows that differ for upload
+			void SetStates(
+				const std::vector<uint8_t> &newStates
+			);
+
+			// upload any changes and draw the grid stretched over the specified rectangle
+			void Draw(
+				real32_t x,
+				real32_t y,
+				real32_t w,
+				real32_t h
+			);
+		};
+
+	} // namespace ClientGame
+
+} // namespace XS
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <thread>
+
+#include "XSCommon/XSCommon.h"
+#include "XSCommon/XSCvar.h"
+#include "XSCommon/XSString.h"
+#include "XSCommon/XSTimer.h"
+#include "XSClient/XSClientPath.h"
+
+namespace XS {
+
+	namespace ClientGame {
+
+		static Cvar *path_idaTableSize = nullptr;
+		static Cvar *path_smaNodes = nullptr;
+		static Cvar *path_threads = nullptr;
+		static Cvar *path_bidirectionalThreads = nullptr;
+
+		static const struct {
+			const char		*name;
+			Path::Algorithm	 algorithm;
+		} algorithmTable[] = {
+			{ "astar",		Path::Algorithm::AStar },
+			{ "idastar",	Path::Algorithm::IDAStar },
+			{ "fringe",		Path::Algorithm::Fringe },
+			{ "smastar",	Path::Algorithm::SMAStar },
+			{ "hdastar",	Path::Algorithm::HDAStar },
+			{ "bidastar",	Path::Algorithm::BidirectionalAStar },
+			{ "bidijkstra",	Path::Algorithm::BidirectionalDijkstra },
+		};
+
+		void InitSearch( void ) {
+			path_idaTableSize = Cvar::Create( "path_idaTableSize", "65536",
+				"Number of transposition table entries for IDA*", CVAR_ARCHIVE );
+			path_smaNodes = Cvar::Create( "path_smaNodes", "8192", "Maximum number of nodes held by SMA*",
+				CVAR_ARCHIVE );
+			path_threads = Cvar::Create( "path_threads", "0", "Number of threads used by HDA*, 0 for one per core",
+				CVAR_ARCHIVE );
+			path_bidirectionalThreads = Cvar::Create( "path_bidirectionalThreads", "0",
+				"Run the forward and backward frontiers of bidirectional searches on separate threads", CVAR_ARCHIVE );
+		}
+
+		uint32_t GetSearchThreads( void ) {
+			if ( path_threads->GetInt() > 0 ) {
+				return static_cast<uint32_t>( path_threads->GetInt() );
+			}
+			return std::max( std::thread::hardware_concurrency(), 1u );
+		}
+
+		void InitGrid( Grid &grid ) {
+			static const int32_t offsets[NUM_DIRECTIONS][2] = {
+				{ -1, -1 }, // NorthWest
+				{  0, -1 }, // North
+				{  1, -1 }, // NorthEast
+				{  1,  0 }, // East
+				{  1,  1 }, // SouthEast
+				{  0,  1 }, // South
+				{ -1,  1 }, // SouthWest
+				{ -1,  0 }, // West
+			};
+
+			for ( uint32_t x = 0u; x < grid.width; x++ ) {
+				for ( uint32_t y = 0u; y < grid.height; y++ ) {
+					Tile *tile = grid.Get( x, y );
+					tile->x = x;
+					tile->y = y;
+					tile->type = TileType::Blank;
+
+					for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+						Tile *neighbour = grid.Get( x + offsets[dir][0], y + offsets[dir][1] );
+						tile->neighbours[dir] = neighbour;
+						if ( !neighbour ) {
+							tile->cost[dir] = -1;
+						}
+						else {
+							tile->cost[dir] = (offsets[dir][0] && offsets[dir][1])
+								? PATH_COST_DIAGONAL
+								: PATH_COST_STRAIGHT;
+						}
+					}
+				}
+			}
+		}
+
+		int32_t OctileDistance( const Tile *t1, const Tile *t2 ) {
+			const int32_t dx = std::abs( t2->x - t1->x );
+			const int32_t dy = std::abs( t2->y - t1->y );
+
+			// move diagonally for the shorter axis, then straight for the remainder
+			return (PATH_COST_DIAGONAL * std::min( dx, dy ))
+				+ (PATH_COST_STRAIGHT * (std::max( dx, dy ) - std::min( dx, dy )));
+		}
+
+		bool GetAlgorithm( const char *name, Path::Algorithm *outAlgorithm ) {
+			for ( const auto &it : algorithmTable ) {
+				if ( !String::Compare( name, it.name ) ) {
+					*outAlgorithm = it.algorithm;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		const char *GetAlgorithmName( Path::Algorithm algorithm ) {
+			for ( const auto &it : algorithmTable ) {
+				if ( it.algorithm == algorithm ) {
+					return it.name;
+				}
+			}
+			return "unknown";
+		}
+
+		bool Search( Path::Algorithm algorithm, const Grid &grid, Tile *start, Tile *goal, nodeList &route,
+			searchStats_t *stats )
+		{
+			Timer timer;
+			bool found = false;
+
+			route.clear();
+			*stats = {};
+			stats->cost = -1;
+
+			switch ( algorithm ) {
+
+			case Path::Algorithm::AStar: {
+				found = SearchAStar( grid, start, goal, route, stats );
+			} break;
+
+			case Path::Algorithm::IDAStar: {
+				found = SearchIDAStar( grid, start, goal, route, stats,
+					static_cast<size_t>( std::max( 1, path_idaTableSize->GetInt() ) ) );
+			} break;
+
+			case Path::Algorithm::Fringe: {
+				found = SearchFringe( grid, start, goal, route, stats );
+			} break;
+
+			case Path::Algorithm::SMAStar: {
+				found = SearchSMAStar( grid, start, goal, route, stats,
+					static_cast<size_t>( std::max( 2, path_smaNodes->GetInt() ) ) );
+			} break;
+
+			case Path::Algorithm::HDAStar: {
+				found = SearchHDAStar( grid, start, goal, route, stats, GetSearchThreads() );
+			} break;
+
+			case Path::Algorithm::BidirectionalAStar:
+			case Path::Algorithm::BidirectionalDijkstra: {
+				found = SearchBidirectional( grid, start, goal, route, stats,
+					algorithm == Path::Algorithm::BidirectionalAStar, path_bidirectionalThreads->GetBool() );
+			} break;
+
+			default: {
+				//TODO: handle other algo's
+			} break;
+
+			}
+
+			stats->msec = timer.GetTiming( false, Timer::Resolution::MILLISECONDS );
+			return found;
+		}
+
+		//
+		// reference A*
+		//
+
+		#define NO_PARENT (UINT32_MAX)
+
+		struct aStarRecord_t {
+			int32_t		g;
+			uint32_t	parent;
+			bool		closed;
+		};
+
+		struct aStarOpen_t {
+			int32_t		f, g;
+			uint32_t	index;
+
+			// ordered for a min-heap on f, preferring deeper nodes on ties
+			inline bool operator<( const aStarOpen_t &rhs ) const {
+				if ( f != rhs.f ) {
+					return f > rhs.f;
+				}
+				return g < rhs.g;
+			}
+		};
+
+		bool SearchAStar( const Grid &grid, Tile *start, Tile *goal, nodeList &route, searchStats_t *stats ) {
+			std::vector<aStarRecord_t> records( grid.Size(), { PATH_COST_INFINITE, NO_PARENT, false } );
+			std::vector<aStarOpen_t> open;
+			size_t peakOpen = 0u;
+
+			const uint32_t startIndex = grid.Index( start );
+			const uint32_t goalIndex = grid.Index( goal );
+			records[startIndex].g = 0;
+			open.push_back( { OctileDistance( start, goal ), 0, startIndex } );
+			stats->iterations = 1u;
+
+			bool found = false;
+			while ( !open.empty() ) {
+				std::pop_heap( open.begin(), open.end() );
+				const aStarOpen_t current = open.back();
+				open.pop_back();
+
+				aStarRecord_t &record = records[current.index];
+				// stale entry, a cheaper route was pushed after this one
+				if ( record.closed || current.g != record.g ) {
+					continue;
+				}
+				record.closed = true;
+
+				if ( current.index == goalIndex ) {
+					found = true;
+					break;
+				}
+
+				stats->expanded++;
+				const Tile *tile = &grid.tiles[current.index];
+				for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+					const Tile *neighbour = tile->neighbours[dir];
+					if ( !neighbour || neighbour->type == TileType::Wall ) {
+						continue;
+					}
+
+					const uint32_t index = grid.Index( neighbour );
+					const int32_t g = current.g + tile->cost[dir];
+					if ( records[index].closed || g >= records[index].g ) {
+						continue;
+					}
+
+					records[index].g = g;
+					records[index].parent = current.index;
+					open.push_back( { g + OctileDistance( neighbour, goal ), g, index } );
+					std::push_heap( open.begin(), open.end() );
+				}
+				peakOpen = std::max( peakOpen, open.size() );
+			}
+
+			stats->peakNodes = records.size();
+			stats->peakBytes = (records.size() * sizeof(aStarRecord_t)) + (peakOpen * sizeof(aStarOpen_t));
+
+			if ( !found ) {
+				return false;
+			}
+
+			stats->cost = records[goalIndex].g;
+			for ( uint32_t index = goalIndex; index != NO_PARENT; index = records[index].parent ) {
+				route.push_back( &grid.tiles[index] );
+			}
+			std::reverse( route.begin(), route.end() );
+
+			return true;
+		}
+
+	} // namespace ClientGame
+
+} // namespace XS
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "XSCommon/XSCommon.h"
+#include "XSCommon/XSCommand.h"
+
+namespace XS {
+
+	namespace ClientGame {
+
+		// each tile acts as a node in the graph to search
+		// a tile has a specific type (e.g. start, goal, wall)
+		// the only identifying property of a tile is the position, which is inferred by the tilemap
+
+		enum class TileType {
+			Blank,
+			Wall,
+			Start,
+			Goal
+		};
+
+		enum Direction {
+			NorthWest,
+			North,
+			NorthEast,
+			East,
+			SouthEast,
+			South,
+			SouthWest,
+			West,
+			NUM_DIRECTIONS
+		};
+
+		// movement costs are integral, diagonal moves approximate sqrt(2) as 1.5
+		#define PATH_COST_STRAIGHT	(2)
+		#define PATH_COST_DIAGONAL	(3)
+		#define PATH_COST_INFINITE	(INT32_MAX)
+
+		struct Tile {
+			int32_t		x, y;
+
+			// a cost of -1 means it is an unmoveable direction (i.e. off the map)
+			// the lower the cost, the better the move
+			int16_t		cost[NUM_DIRECTIONS];
+			Tile		*neighbours[NUM_DIRECTIONS];
+			TileType	type;
+
+			// the only unique element for a tile is the coordinate, so use this for comparison
+			inline bool operator==( const Tile &rhs ) const {
+				if ( x == rhs.x && y == rhs.y ) {
+					return true;
+				}
+				return false;
+			}
+		};
+		typedef std::vector<Tile *> nodeList;
+
+		// a view over a column-major block of tiles, i.e. tiles[x * height + y]
+		// the grid does not own the tiles
+		struct Grid {
+			Tile		*tiles;
+			uint32_t	 width, height;
+
+			inline Tile *Get( uint32_t x, uint32_t y ) const {
+				if ( x < width && y < height ) {
+					return &tiles[x * height + y];
+				}
+				return nullptr;
+			}
+
+			// unique index of a tile within this grid, suitable for flat node-record arrays
+			inline size_t Index( const Tile *tile ) const {
+				return static_cast<size_t>( tile - tiles );
+			}
+
+			inline size_t Size( void ) const {
+				return static_cast<size_t>( width ) * height;
+			}
+		};
+
+		// results of a single query, filled in by every search function
+		struct searchStats_t {
+			int32_t		cost; // -1 if no route was found
+			uint32_t	expanded; // nodes whose successors were generated
+			uint32_t	iterations; // threshold iterations for IDA*/Fringe, 1 otherwise
+			size_t		peakNodes; // most node records held at once
+			size_t		peakBytes; // approximate peak memory held by the search structures
+			real64_t	msec; // filled in by Search()
+			bool		exhausted; // SMA* gave up within its node budget, a route may still exist
+		};
+
+		struct Path {
+			enum class Algorithm {
+				AStar,
+				IDAStar,
+				Fringe,
+				SMAStar,
+				HDAStar,
+				BidirectionalAStar,
+				BidirectionalDijkstra,
+				DStar, //TODO
+				Dijkstra, //TODO
+				BFS, //TODO
+			};
+
+			// tiles are added to the open list if it's to be explored
+			// when a tile is determined to be unsuitable, it's moved to the closed list and never checked again
+			nodeList				openList, closedList;
+			nodeList				result;
+			std::map<Tile*, Tile*>	cameFrom;
+			Algorithm				algorithm;
+			bool					complete;
+
+			// calculate the H cost of moving from t1 to t2
+			int16_t HeuristicCost(
+				const Tile *t1,
+				const Tile *t2
+			);
+
+			// we've reached the goal, so backtrack to the start node and return that path
+			void Backtrack(
+				Tile *tile,
+				nodeList &route
+			);
+
+			// construct a path from current tile to goal tile
+			bool Find(
+				Tile *current,
+				Tile *goal,
+				nodeList &route
+			);
+		};
+
+		// register the cvars used to tune the searches
+		void InitSearch(
+			void
+		);
+
+		// number of threads parallel searches should use, from path_threads
+		uint32_t GetSearchThreads(
+			void
+		);
+
+		// reset every tile to a blank, coordinate-addressed tile and link up its neighbours and move costs
+		void InitGrid(
+			Grid &grid
+		);
+
+		// admissible and consistent octile distance for PATH_COST_STRAIGHT/PATH_COST_DIAGONAL moves
+		int32_t OctileDistance(
+			const Tile *t1,
+			const Tile *t2
+		);
+
+		// look up an algorithm by console name (e.g. "idastar"), returns false if unknown
+		bool GetAlgorithm(
+			const char *name,
+			Path::Algorithm *outAlgorithm
+		);
+
+		// console name of an algorithm
+		const char *GetAlgorithmName(
+			Path::Algorithm algorithm
+		);
+
+		// run a complete query with the specified algorithm
+		// route receives the tiles from start to goal inclusive, returns false if no route was found
+		bool Search(
+			Path::Algorithm algorithm,
+			const Grid &grid,
+			Tile *start,
+			Tile *goal,
+			nodeList &route,
+			searchStats_t *stats
+		);
+
+		// reference A*, memory is a flat node record per tile plus the open list
+		bool SearchAStar(
+			const Grid &grid,
+			Tile *start,
+			Tile *goal,
+			nodeList &route,
+			searchStats_t *stats
+		);
+
+		//
+		// memory-bounded searches, see XSClientPathBounded.cpp
+		//
+
+		// iterative deepening A* with a fixed-size transposition table of tableSize entries
+		// memory is O(tableSize + path length) regardless of map size
+		bool SearchIDAStar(
+			const Grid &grid,
+			Tile *start,
+			Tile *goal,
+			nodeList &route,
+			searchStats_t *stats,
+			size_t tableSize
+		);
+
+		// fringe search with now/later lists, memory is proportional to the number of tiles visited rather than the
+		//	size of the map
+		bool SearchFringe(
+			const Grid &grid,
+			Tile *start,
+			Tile *goal,
+			nodeList &route,
+			searchStats_t *stats
+		);
+
+		// simplified memory-bounded A*, never holds more than nodeBudget nodes
+		// returns the best route that fits in the budget, or fails if the route is longer than nodeBudget tiles
+		// if it thrashes for too long it gives up and sets stats->exhausted
+		bool SearchSMAStar(
+			const Grid &grid,
+			Tile *start,
+			Tile *goal,
+			nodeList &route,
+			searchStats_t *stats,
+			size_t nodeBudget
+		);
+
+		//
+		// parallel searches, see XSClientPathParallel.cpp
+		//
+
+		// hash-distributed A* over numThreads threads, finds the same route cost as SearchAStar
+		bool SearchHDAStar(
+			const Grid &grid,
+			Tile *start,
+			Tile *goal,
+			nodeList &route,
+			searchStats_t *stats,
+			uint32_t numThreads
+		);
+
+		//
+		// bidirectional searches, see XSClientPathBidirectional.cpp
+		//
+
+		// forward and backward searches that stop once their best meeting point is proven optimal
+		// without useHeuristic this is bidirectional Dijkstra. frontiers alternate by open list size, or run on a
+		//	thread each if threaded is set
+		bool SearchBidirectional(
+			const Grid &grid,
+			Tile *start,
+			Tile *goal,
+			nodeList &route,
+			searchStats_t *stats,
+			bool useHeuristic,
+			bool threaded
+		);
+
+		// run every algorithm over randomly generated maps and compare time against memory
+		//	pathbench [width] [height] [queries] [wall percentage]
+		void Cmd_PathBench(
+			const commandContext_t * const context
+		);
+
+		// compare serial A* against HDA* on 1 to path_threads threads with long corner-to-corner queries
+		//	pathscale [width] [height] [queries] [wall percentage]
+		void Cmd_PathScale(
+			const commandContext_t * const context
+		);
+
+	} // namespace ClientGame
+
+} // namespace XS
@@ -0,0 +1,362 @@
+#include <algorithm>
+
+#include "XSCommon/XSCommon.h"
+#include "XSCommon/XSConsole.h"
+#include "XSCommon/XSJob.h"
+#include "XSCommon/XSTimer.h"
+#include "XSClient/XSClientPath.h"
+#include "XSClient/XSClientPathDatabase.h"
+#include "XSClient/XSClientPathMap.h"
+
+namespace XS {
+
+	namespace ClientGame {
+
+		static const Path::Algorithm benchAlgorithms[] = {
+			Path::Algorithm::AStar,
+			Path::Algorithm::IDAStar,
+			Path::Algorithm::Fringe,
+			Path::Algorithm::SMAStar,
+			Path::Algorithm::HDAStar,
+			Path::Algorithm::BidirectionalAStar,
+			Path::Algorithm::BidirectionalDijkstra,
+		};
+
+		struct benchQuery_t {
+			Tile	*start, *goal;
+			int32_t	 cost; // reference cost from A*
+			uint32_t expanded; // reference expansions from A*
+		};
+
+		static uint32_t GetArgument( const commandContext_t * const context, size_t index, uint32_t defaultValue,
+			uint32_t minValue, uint32_t maxValue )
+		{
+			if ( context->size() <= index ) {
+				return defaultValue;
+			}
+			const int32_t value = atoi( (*context)[index].c_str() );
+			return std::min( std::max( static_cast<uint32_t>( std::max( value, 0 ) ), minValue ), maxValue );
+		}
+
+		static Tile *RandomBlankTile( const Grid &grid ) {
+			while ( true ) {
+				Tile *tile = grid.Get( rand() % grid.width, rand() % grid.height );
+				if ( tile->type != TileType::Wall ) {
+					return tile;
+				}
+			}
+		}
+
+		// fill the grid with random walls and pick random start/goal pairs
+		static void GenerateBenchMap( Grid &grid, uint32_t wallPercent, std::vector<benchQuery_t> &queries ) {
+			InitGrid( grid );
+			for ( size_t i = 0u; i < grid.Size(); i++ ) {
+				if ( static_cast<uint32_t>( rand() % 100 ) < wallPercent ) {
+					grid.tiles[i].type = TileType::Wall;
+				}
+			}
+
+			for ( auto &query : queries ) {
+				query.start = RandomBlankTile( grid );
+				query.goal = RandomBlankTile( grid );
+				query.cost = -1;
+				query.expanded = 0u;
+			}
+		}
+
+		void Cmd_PathBench( const commandContext_t * const context ) {
+			const uint32_t width = GetArgument( context, 0, 128u, 8u, 16384u );
+			const uint32_t height = GetArgument( context, 1, 128u, 8u, 16384u );
+			const uint32_t numQueries = GetArgument( context, 2, 8u, 1u, 1024u );
+			const uint32_t wallPercent = GetArgument( context, 3, 20u, 0u, 60u );
+
+			std::vector<Tile> tiles( static_cast<size_t>( width ) * height );
+			Grid grid = { tiles.data(), width, height };
+			std::vector<benchQuery_t> queries( numQueries );
+			GenerateBenchMap( grid, wallPercent, queries );
+
+			console.Print( "Path benchmark: %ux%u, %u queries, %u%% walls (map %.1f KiB)\n", width, height, numQueries,
+				wallPercent, (tiles.size() * sizeof(Tile)) / 1024.0 );
+			Indent indent( 1 );
+
+			// saved: expansions saved against A* over all queries, negative if the algorithm expanded more
+			console.Print( "%-10s %10s %10s %12s %8s %14s %14s %6s\n", "algorithm", "total ms", "ms/query", "expanded",
+				"saved", "avg peak KiB", "max peak KiB", "wrong" );
+
+			nodeList route;
+			for ( const auto &algorithm : benchAlgorithms ) {
+				real64_t totalMsec = 0.0;
+				uint64_t totalExpanded = 0u, referenceExpanded = 0u;
+				size_t totalBytes = 0u, maxBytes = 0u;
+				uint32_t wrong = 0u;
+
+				for ( auto &query : queries ) {
+					searchStats_t stats;
+					Search( algorithm, grid, query.start, query.goal, route, &stats );
+
+					if ( algorithm == Path::Algorithm::AStar ) {
+						query.cost = stats.cost;
+						query.expanded = stats.expanded;
+					}
+					else if ( stats.cost != query.cost ) {
+						wrong++;
+					}
+
+					totalMsec += stats.msec;
+					totalExpanded += stats.expanded;
+					referenceExpanded += query.expanded;
+					totalBytes += stats.peakBytes;
+					maxBytes = std::max( maxBytes, stats.peakBytes );
+				}
+
+				const real64_t saved = referenceExpanded
+					? 100.0 * (1.0 - static_cast<real64_t>( totalExpanded ) / referenceExpanded)
+					: 0.0;
+				console.Print( "%-10s %10.3f %10.3f %12llu %7.1f%% %14.1f %14.1f %6u\n", GetAlgorithmName( algorithm ),
+					totalMsec, totalMsec / numQueries, static_cast<unsigned long long>( totalExpanded / numQueries ),
+					saved, (totalBytes / numQueries) / 1024.0, maxBytes / 1024.0, wrong );
+			}
+
+			// SMA* must still find every route when its budget comfortably exceeds the route, even though nodes that
+			//	dominated other successors are culled along the way
+			uint32_t lost = 0u, exhausted = 0u;
+			for ( const auto &query : queries ) {
+				if ( query.cost < 0 ) {
+					continue;
+				}
+				searchStats_t stats = {};
+				SearchAStar( grid, query.start, query.goal, route, &stats );
+				const size_t nodeBudget = (route.size() + 1u) * 8u;
+
+				stats = {};
+				if ( !SearchSMAStar( grid, query.start, query.goal, route, &stats, nodeBudget ) ) {
+					if ( stats.exhausted ) {
+						exhausted++;
+					}
+					else {
+						lost++;
+					}
+				}
+				else if ( stats.cost != query.cost ) {
+					lost++;
+				}
+			}
+			if ( lost || exhausted ) {
+				console.Print( "%s with 8x the route length in nodes: %u routes lost, %u gave up\n",
+					GetAlgorithmName( Path::Algorithm::SMAStar ), lost, exhausted );
+			}
+		}
+
+		void Cmd_PathScale( const commandContext_t * const context ) {
+			const uint32_t width = GetArgument( context, 0, 1024u, 8u, 16384u );
+			const uint32_t height = GetArgument( context, 1, 1024u, 8u, 16384u );
+			const uint32_t numQueries = GetArgument( context, 2, 4u, 1u, 1024u );
+			const uint32_t wallPercent = GetArgument( context, 3, 20u, 0u, 60u );
+			const uint32_t maxThreads = GetSearchThreads();
+
+			std::vector<Tile> tiles( static_cast<size_t>( width ) * height );
+			Grid grid = { tiles.data(), width, height };
+			std::vector<benchQuery_t> queries( numQueries );
+			GenerateBenchMap( grid, wallPercent, queries );
+
+			// the longest queries the map has, cycling through both diagonals in both directions
+			Tile *corners[4] = {
+				grid.Get( 0u, 0u ),
+				grid.Get( width - 1u, height - 1u ),
+				grid.Get( width - 1u, 0u ),
+				grid.Get( 0u, height - 1u ),
+			};
+			for ( auto &corner : corners ) {
+				corner->type = TileType::Blank;
+			}
+			for ( uint32_t i = 0u; i < numQueries; i++ ) {
+				const uint32_t diagonal = (i / 2u) % 2u;
+				const uint32_t reverse = i % 2u;
+				queries[i].start = corners[(diagonal * 2u) + reverse];
+				queries[i].goal = corners[(diagonal * 2u) + 1u - reverse];
+			}
+
+			console.Print( "Path scaling: %ux%u, %u corner to corner queries, %u%% walls, 1 to %u threads\n", width,
+				height, numQueries, wallPercent, maxThreads );
+			Indent indent( 1 );
+
+			console.Print( "%-10s %8s %10s %10s %10s %6s\n", "algorithm", "threads", "total ms", "ms/query", "speedup",
+				"wrong" );
+
+			nodeList route;
+			Timer timer;
+			for ( auto &query : queries ) {
+				searchStats_t stats = {};
+				SearchAStar( grid, query.start, query.goal, route, &stats );
+				query.cost = stats.cost;
+			}
+			const real64_t serialMsec = timer.GetTiming( true, Timer::Resolution::MILLISECONDS );
+			console.Print( "%-10s %8u %10.3f %10.3f %10s %6s\n", GetAlgorithmName( Path::Algorithm::AStar ), 1u,
+				serialMsec, serialMsec / numQueries, "-", "-" );
+
+			// speedup is against HDA* on 1 thread, so it shows how the search itself scales
+			real64_t oneThreadMsec = 0.0;
+			for ( uint32_t numThreads = 1u; numThreads <= maxThreads; numThreads++ ) {
+				uint32_t wrong = 0u;
+				timer.GetTiming( true );
+				for ( const auto &query : queries ) {
+					searchStats_t stats = {};
+					SearchHDAStar( grid, query.start, query.goal, route, &stats, numThreads );
+					if ( stats.cost != query.cost ) {
+						wrong++;
+					}
+				}
+				const real64_t msec = timer.GetTiming( true, Timer::Resolution::MILLISECONDS );
+				if ( numThreads == 1u ) {
+					oneThreadMsec = msec;
+				}
+
+				console.Print( "%-10s %8u %10.3f %10.3f %9.2fx %6u\n", GetAlgorithmName( Path::Algorithm::HDAStar ),
+					numThreads, msec, msec / numQueries, (msec > 0.0) ? oneThreadMsec / msec : 0.0, wrong );
+			}
+		}
+
+		void Cmd_PathNearest( const commandContext_t * const context ) {
+			const uint32_t width = GetArgument( context, 0, 256u, 8u, 16384u );
+			const uint32_t height = GetArgument( context, 1, 256u, 8u, 16384u );
+			const uint32_t numGoals = GetArgument( context, 2, 16u, 1u, 1024u );
+			const uint32_t wallPercent = GetArgument( context, 3, 20u, 0u, 60u );
+			const uint32_t numQueries = 16u;
+
+			std::vector<Tile> tiles( static_cast<size_t>( width ) * height );
+			Grid grid = { tiles.data(), width, height };
+			std::vector<benchQuery_t> queries( numQueries );
+			GenerateBenchMap( grid, wallPercent, queries );
+
+			nodeList goals( numGoals );
+			for ( auto &goal : goals ) {
+				goal = RandomBlankTile( grid );
+			}
+
+			console.Print( "Nearest goal: %ux%u, %u goals, %u queries, %u%% walls\n", width, height, numGoals,
+				numQueries, wallPercent );
+			Indent indent( 1 );
+
+			nodeList route;
+			uint32_t wrong = 0u;
+
+			// one A* per candidate
+			Timer timer;
+			for ( auto &query : queries ) {
+				for ( const auto &goal : goals ) {
+					searchStats_t stats;
+					if ( Search( Path::Algorithm::AStar, grid, query.start, goal, route, &stats )
+						&& (query.cost < 0 || stats.cost < query.cost) )
+					{
+						query.cost = stats.cost;
+					}
+				}
+			}
+			const real64_t perGoalMsec = timer.GetTiming( true, Timer::Resolution::MILLISECONDS );
+
+			// one query that stops at the first goal
+			for ( const auto &query : queries ) {
+				searchStats_t stats = {};
+				SearchNearest( grid, query.start, goals, route, &stats );
+				if ( stats.cost != query.cost ) {
+					wrong++;
+				}
+			}
+			const real64_t nearestMsec = timer.GetTiming( true, Timer::Resolution::MILLISECONDS );
+
+			// a Dijkstra map seeded with every goal, then walk downhill
+			DijkstraMap map( grid );
+			for ( const auto &goal : goals ) {
+				map.AddSeed( goal );
+			}
+			const real64_t buildMsec = timer.GetTiming( true, Timer::Resolution::MILLISECONDS );
+			for ( const auto &query : queries ) {
+				const int32_t distance = map.Distance( query.start );
+				if ( (distance == PATH_COST_INFINITE ? -1 : distance) != query.cost ) {
+					wrong++;
+				}
+				map.Route( query.start, route );
+			}
+			const real64_t mapMsec = timer.GetTiming( false, Timer::Resolution::MILLISECONDS );
+
+			console.Print( "%-16s %10s %10s\n", "method", "total ms", "ms/query" );
+			console.Print( "%-16s %10.3f %10.3f\n", "astar per goal", perGoalMsec, perGoalMsec / numQueries );
+			console.Print( "%-16s %10.3f %10.3f\n", "nearest", nearestMsec, nearestMsec / numQueries );
+			console.Print( "%-16s %10.3f %10.3f (+%.3f ms to build, %.1f KiB)\n", "dijkstra map", mapMsec,
+				mapMsec / numQueries, buildMsec, map.Bytes() / 1024.0 );
+			if ( wrong ) {
+				console.Print( "%u results did not match the best A* result\n", wrong );
+			}
+		}
+
+		void Cmd_PathCPDBench( const commandContext_t * const context ) {
+			const uint32_t width = GetArgument( context, 0, 96u, 8u, 1024u );
+			const uint32_t height = GetArgument( context, 1, 96u, 8u, 1024u );
+			const uint32_t numQueries = GetArgument( context, 2, 256u, 1u, 65536u );
+			const uint32_t wallPercent = GetArgument( context, 3, 20u, 0u, 60u );
+			const uint32_t numThreads = Job::GetNumThreads();
+			const char *gamePath = "cache/pathbench.cpd";
+
+			std::vector<Tile> tiles( static_cast<size_t>( width ) * height );
+			Grid grid = { tiles.data(), width, height };
+			std::vector<benchQuery_t> queries( numQueries );
+			GenerateBenchMap( grid, wallPercent, queries );
+
+			console.Print( "Compressed path database: %ux%u, %u queries, %u%% walls\n", width, height, numQueries,
+				wallPercent );
+			Indent indent( 1 );
+
+			Timer timer;
+			{
+				const PathDatabase database( grid );
+				const real64_t buildMsec = timer.GetTiming( true, Timer::Resolution::MILLISECONDS );
+				console.Print( "built in %.1f ms on %u threads, %u runs (%.2f per tile), %.1f KiB\n", buildMsec,
+					numThreads, static_cast<uint32_t>( database.NumRuns() ),
+					static_cast<real64_t>( database.NumRuns() ) / tiles.size(), database.Bytes() / 1024.0 );
+				if ( !database.Write( gamePath ) ) {
+					console.Print( "couldn't write %s\n", gamePath );
+					return;
+				}
+			}
+
+			timer.GetTiming( true );
+			const PathDatabase database( grid, gamePath );
+			if ( !database.IsValid() ) {
+				console.Print( "couldn't map %s\n", gamePath );
+				return;
+			}
+			console.Print( "mapped %s in %.3f ms\n", gamePath,
+				timer.GetTiming( true, Timer::Resolution::MILLISECONDS ) );
+
+			nodeList route;
+			size_t routeLength = 0u;
+			for ( auto &query : queries ) {
+				searchStats_t stats;
+				Search( Path::Algorithm::AStar, grid, query.start, query.goal, route, &stats );
+				query.cost = stats.cost;
+			}
+			const real64_t searchMsec = timer.GetTiming( true, Timer::Resolution::MILLISECONDS );
+
+			uint32_t wrong = 0u;
+			for ( const auto &query : queries ) {
+				searchStats_t stats = {};
+				database.Extract( query.start, query.goal, route, &stats );
+				routeLength += route.size();
+				if ( stats.cost != query.cost ) {
+					wrong++;
+				}
+			}
+			const real64_t extractMsec = timer.GetTiming( false, Timer::Resolution::MILLISECONDS );
+
+			console.Print( "%-10s %10s %12s\n", "method", "total ms", "usec/query" );
+			console.Print( "%-10s %10.3f %12.3f\n", "astar", searchMsec, (searchMsec * 1000.0) / numQueries );
+			console.Print( "%-10s %10.3f %12.3f (%.1f tiles per route)\n", "cpd", extractMsec,
+				(extractMsec * 1000.0) / numQueries, static_cast<real64_t>( routeLength ) / numQueries );
+			if ( wrong ) {
+				console.Print( "%u routes did not match the A* cost\n", wrong );
+			}
+		}
+
+	} // namespace ClientGame
+
+} // namespace XS
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "XSCommon/XSCommon.h"
+#include "XSClient/XSClientPath.h"
+
+// bidirectional searches, a forward search from the start and a backward search from the goal meet in the middle
+// moves cost the same in both directions, so the backward search walks the same neighbours as the forward one
+// references:
+//	Pohl, "Bi-directional search" (1971)
+//	Goldberg & Harrelson, "Computing the shortest path: A* search meets graph theory" (2005)
+
+namespace XS {
+
+	namespace ClientGame {
+
+		#define BIDIR_NO_PARENT (UINT32_MAX)
+		#define BIDIR_NO_MEETING (UINT64_MAX)
+
+		struct bidirOpen_t {
+			int32_t		f, g;
+			uint32_t	index;
+
+			// ordered for a min-heap on f, preferring deeper nodes on ties
+			inline bool operator<( const bidirOpen_t &rhs ) const {
+				if ( f != rhs.f ) {
+					return f > rhs.f;
+				}
+				return g < rhs.g;
+			}
+		};
+
+		// one frontier
+		// g and topKey are read by the other frontier, everything else is private to the frontier's thread
+		struct bidirSide_t {
+			std::vector<std::atomic<int32_t>>	g;
+			std::atomic<int32_t>				topKey; // lowest f in the open list, possibly out of date
+			std::vector<uint32_t>				parent;
+			std::vector<uint8_t>				closed;
+			std::vector<bidirOpen_t>			open;
+			const Tile							*target; // heuristic target
+			uint32_t							 expanded;
+			size_t								 peakOpen;
+		};
+
+		bool SearchBidirectional( const Grid &grid, Tile *start, Tile *goal, nodeList &route, searchStats_t *stats,
+			bool useHeuristic, bool threaded )
+		{
+			if ( start == goal ) {
+				route.push_back( start );
+				stats->cost = 0;
+				stats->iterations = 1u;
+				return true;
+			}
+
+			const size_t size = grid.Size();
+			bidirSide_t sides[2];
+			for ( auto &side : sides ) {
+				side.g = std::vector<std::atomic<int32_t>>( size );
+				for ( auto &g : side.g ) {
+					g.store( PATH_COST_INFINITE, std::memory_order_relaxed );
+				}
+				side.parent.assign( size, BIDIR_NO_PARENT );
+				side.closed.assign( size, 0u );
+				side.topKey.store( 0, std::memory_order_relaxed );
+				side.expanded = 0u;
+				side.peakOpen = 1u;
+			}
+			bidirSide_t &forward = sides[0];
+			bidirSide_t &backward = sides[1];
+			forward.target = goal;
+			backward.target = start;
+
+			auto Heuristic = [&]( const bidirSide_t &side, const Tile *tile ) -> int32_t {
+				return useHeuristic ? OctileDistance( tile, side.target ) : 0;
+			};
+
+			const uint32_t startIndex = grid.Index( start );
+			const uint32_t goalIndex = grid.Index( goal );
+			forward.g[startIndex].store( 0 );
+			forward.open.push_back( { Heuristic( forward, start ), 0, startIndex } );
+			backward.g[goalIndex].store( 0 );
+			backward.open.push_back( { Heuristic( backward, goal ), 0, goalIndex } );
+
+			// best meeting so far, packed as cost << 32 | tile index so both are updated together
+			std::atomic<uint64_t> meeting( BIDIR_NO_MEETING );
+			std::atomic<bool> done( false );
+
+			auto BestCost = [&]( void ) -> int32_t {
+				const uint64_t packed = meeting.load( std::memory_order_acquire );
+				if ( packed == BIDIR_NO_MEETING ) {
+					return PATH_COST_INFINITE;
+				}
+				return static_cast<int32_t>( packed >> 32 );
+			};
+
+			// drop stale entries from the top of the open list, returns false if it's empty
+			auto Clean = [&]( bidirSide_t &side ) -> bool {
+				while ( !side.open.empty() ) {
+					const bidirOpen_t &top = side.open.front();
+					if ( !side.closed[top.index]
+						&& top.g == side.g[top.index].load( std::memory_order_relaxed ) )
+					{
+						return true;
+					}
+					std::pop_heap( side.open.begin(), side.open.end() );
+					side.open.pop_back();
+				}
+				return false;
+			};
+
+			// expand the best node of one frontier
+			// returns true once this frontier alone proves the best meeting is optimal, or it ran out of nodes
+			auto Step = [&]( bidirSide_t &self, bidirSide_t &other ) -> bool {
+				if ( !Clean( self ) ) {
+					return true;
+				}
+
+				// every route cheaper than the best meeting must pass through this frontier at f or above
+				const int32_t best = BestCost();
+				const int32_t topKey = self.open.front().f;
+				if ( topKey >= best ) {
+					return true;
+				}
+
+				// without a heuristic the frontiers are ordered by g, so such a route also costs at least both tops
+				//	combined. the other top only ever rises, so an out of date value is still a lower bound
+				self.topKey.store( topKey, std::memory_order_relaxed );
+				if ( !useHeuristic
+					&& static_cast<int64_t>( topKey ) + other.topKey.load( std::memory_order_relaxed ) >= best )
+				{
+					return true;
+				}
+
+				std::pop_heap( self.open.begin(), self.open.end() );
+				const bidirOpen_t current = self.open.back();
+				self.open.pop_back();
+				self.closed[current.index] = 1u;
+				self.expanded++;
+
+				const Tile *tile = &grid.tiles[current.index];
+				for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+					const Tile *neighbour = tile->neighbours[dir];
+					if ( !neighbour || neighbour->type == TileType::Wall ) {
+						continue;
+					}
+
+					const uint32_t index = static_cast<uint32_t>( grid.Index( neighbour ) );
+					const int32_t g = current.g + tile->cost[dir];
+					if ( self.closed[index] || g >= self.g[index].load( std::memory_order_relaxed ) ) {
+						continue;
+					}
+
+					// publish before looking at the other side, so of two threads reaching the same tile at least one
+					//	sees the other's g
+					self.g[index].store( g );
+					self.parent[index] = current.index;
+					self.open.push_back( { g + Heuristic( self, neighbour ), g, index } );
+					std::push_heap( self.open.begin(), self.open.end() );
+					self.peakOpen = std::max( self.peakOpen, self.open.size() );
+
+					const int32_t otherG = other.g[index].load();
+					if ( otherG == PATH_COST_INFINITE ) {
+						continue;
+					}
+					const uint64_t packed = (static_cast<uint64_t>( g + otherG ) << 32) | index;
+					uint64_t previous = meeting.load( std::memory_order_relaxed );
+					while ( packed < previous && !meeting.compare_exchange_weak( previous, packed ) ) {
+						// previous was refreshed by the failed exchange
+					}
+				}
+
+				return false;
+			};
+
+			if ( threaded ) {
+				auto Run = [&]( bidirSide_t &self, bidirSide_t &other ) {
+					while ( !done.load( std::memory_order_acquire ) ) {
+						if ( Step( self, other ) ) {
+							done.store( true, std::memory_order_release );
+						}
+					}
+				};
+				std::thread backwardThread( Run, std::ref( backward ), std::ref( forward ) );
+				Run( forward, backward );
+				backwardThread.join();
+			}
+			else {
+				while ( true ) {
+					// expand the smaller frontier
+					const bool forwardFirst = forward.open.size() <= backward.open.size();
+					bidirSide_t &self = forwardFirst ? forward : backward;
+					bidirSide_t &other = forwardFirst ? backward : forward;
+					if ( Step( self, other ) ) {
+						break;
+					}
+				}
+			}
+
+			stats->expanded = forward.expanded + backward.expanded;
+			stats->iterations = 1u;
+			stats->peakNodes = (2u * size) + forward.peakOpen + backward.peakOpen;
+			stats->peakBytes = (2u * size * (sizeof(int32_t) + sizeof(uint32_t) + sizeof(uint8_t)))
+				+ ((forward.peakOpen + backward.peakOpen) * sizeof(bidirOpen_t));
+
+			const uint64_t packed = meeting.load();
+			if ( packed == BIDIR_NO_MEETING ) {
+				return false;
+			}
+
+			// start -> meeting from the forward parents, then meeting -> goal from the backward parents
+			const uint32_t middle = static_cast<uint32_t>( packed & 0xFFFFFFFFu );
+			for ( uint32_t index = middle; index != BIDIR_NO_PARENT; index = forward.parent[index] ) {
+				route.push_back( &grid.tiles[index] );
+			}
+			std::reverse( route.begin(), route.end() );
+			for ( uint32_t index = backward.parent[middle]; index != BIDIR_NO_PARENT; index = backward.parent[index] ) {
+				route.push_back( &grid.tiles[index] );
+			}
+			stats->cost = static_cast<int32_t>( packed >> 32 );
+
+			return true;
+		}
+
+	} // namespace ClientGame
+
+} // namespace XS
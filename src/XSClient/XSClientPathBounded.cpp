@@ -0,0 +1,555 @@
+#include <algorithm>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+#include "XSCommon/XSCommon.h"
+#include "XSClient/XSClientPath.h"
+
+// memory-bounded searches for maps where a node record per tile is too expensive
+// references:
+//	Korf, "Depth-first iterative-deepening: an optimal admissible tree search" (1985)
+//	Reinefeld & Marsland, "Enhanced iterative-deepening search" (1994)
+//	Bjornsson et al, "Fringe Search: beating A* at pathfinding on game maps" (2005)
+//	Russell, "Efficient memory-bounded search methods" (1992)
+
+namespace XS {
+
+	namespace ClientGame {
+
+		// approximate heap usage of node-based containers, used for peak memory reporting
+		template<typename T>
+		static inline size_t TreeBytes( size_t count ) {
+			// value + colour/parent/left/right
+			return count * (sizeof(T) + (4 * sizeof(void *)));
+		}
+
+		template<typename Map>
+		static inline size_t HashBytes( const Map &map, size_t count ) {
+			// bucket array + value/next/cached hash per element
+			return (map.bucket_count() * sizeof(void *))
+				+ (count * (sizeof(typename Map::value_type) + (2 * sizeof(void *))));
+		}
+
+		// successors that can be moved to
+		static uint8_t PassableMask( const Tile *tile ) {
+			uint8_t mask = 0u;
+			for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+				const Tile *neighbour = tile->neighbours[dir];
+				if ( neighbour && neighbour->type != TileType::Wall ) {
+					mask |= (1u << dir);
+				}
+			}
+			return mask;
+		}
+
+		//
+		// IDA* with transposition table
+		//	memory: tableSize * sizeof(idaEntry_t) + depth * sizeof(idaFrame_t)
+		//	the table is lossy, a collision simply replaces the previous entry which only costs re-expansions
+		//
+
+		struct idaEntry_t {
+			const Tile	*tile;
+			int32_t		 g; // cheapest g this tile has been reached with
+			uint32_t	 iteration; // iteration the tile was last reached with g
+		};
+
+		struct idaFrame_t {
+			Tile		*tile;
+			int32_t		 g;
+			int32_t		 dir; // next direction to try
+		};
+
+		bool SearchIDAStar( const Grid &grid, Tile *start, Tile *goal, nodeList &route, searchStats_t *stats,
+			size_t tableSize )
+		{
+			std::vector<idaEntry_t> table( tableSize, { nullptr, 0, 0u } );
+			std::vector<idaFrame_t> stack;
+			size_t peakDepth = 1u;
+
+			auto GetEntry = [&]( const Tile *tile ) -> idaEntry_t & {
+				const uint64_t hash = static_cast<uint64_t>( grid.Index( tile ) ) * 0x9E3779B97F4A7C15ull;
+				return table[(hash >> 16) % tableSize];
+			};
+
+			int32_t bound = OctileDistance( start, goal );
+			bool found = (start == goal);
+
+			for ( uint32_t iteration = 1u; !found && bound != PATH_COST_INFINITE; iteration++ ) {
+				int32_t nextBound = PATH_COST_INFINITE;
+				stats->iterations = iteration;
+
+				stack.clear();
+				stack.push_back( { start, 0, 0 } );
+				GetEntry( start ) = { start, 0, iteration };
+				stats->expanded++;
+
+				while ( !stack.empty() ) {
+					idaFrame_t &top = stack.back();
+					if ( top.dir >= NUM_DIRECTIONS ) {
+						stack.pop_back();
+						continue;
+					}
+
+					const int32_t dir = top.dir++;
+					Tile *neighbour = top.tile->neighbours[dir];
+					if ( !neighbour || neighbour->type == TileType::Wall ) {
+						continue;
+					}
+
+					const int32_t g = top.g + top.tile->cost[dir];
+					const int32_t f = g + OctileDistance( neighbour, goal );
+					if ( f > bound ) {
+						nextBound = std::min( nextBound, f );
+						continue;
+					}
+
+					// already reached more cheaply, or just as cheaply during this iteration
+					idaEntry_t &entry = GetEntry( neighbour );
+					if ( entry.tile == neighbour
+						&& (g > entry.g || (g == entry.g && entry.iteration == iteration)) )
+					{
+						continue;
+					}
+					entry = { neighbour, g, iteration };
+
+					// top is invalidated from here on
+					stack.push_back( { neighbour, g, 0 } );
+					peakDepth = std::max( peakDepth, stack.size() );
+
+					if ( neighbour == goal ) {
+						found = true;
+						break;
+					}
+					stats->expanded++;
+				}
+
+				bound = nextBound;
+			}
+
+			stats->peakNodes = tableSize + peakDepth;
+			stats->peakBytes = (tableSize * sizeof(idaEntry_t)) + (peakDepth * sizeof(idaFrame_t));
+
+			if ( !found ) {
+				return false;
+			}
+
+			if ( stack.empty() ) {
+				// start == goal
+				route.push_back( start );
+				stats->cost = 0;
+				return true;
+			}
+
+			// the stack is the route
+			for ( const auto &frame : stack ) {
+				route.push_back( frame.tile );
+			}
+			stats->cost = stack.back().g;
+
+			return true;
+		}
+
+		//
+		// Fringe search
+		//	the fringe is split into a "now" list that is processed depth-first under the current f limit and a
+		//	"later" list of nodes that exceeded it. when "now" runs dry, the limit is raised to the smallest f seen in
+		//	"later" and the lists are swapped
+		//	memory: a cache entry per visited tile + the two lists, no priority queue and nothing per unvisited tile
+		//
+
+		struct fringeEntry_t {
+			int32_t		 g;
+			Tile		*parent;
+		};
+
+		struct fringeItem_t {
+			Tile		*tile;
+			int32_t		 g; // stale if it no longer matches the cache
+		};
+
+		bool SearchFringe( const Grid &grid, Tile *start, Tile *goal, nodeList &route, searchStats_t *stats ) {
+			std::unordered_map<const Tile *, fringeEntry_t> cache;
+			std::vector<fringeItem_t> now, later;
+			size_t peakLists = 1u;
+
+			cache[start] = { 0, nullptr };
+			now.push_back( { start, 0 } );
+			int32_t fLimit = OctileDistance( start, goal );
+
+			bool found = false;
+			while ( !now.empty() ) {
+				int32_t fMin = PATH_COST_INFINITE;
+				stats->iterations++;
+
+				while ( !now.empty() ) {
+					const fringeItem_t item = now.back();
+					now.pop_back();
+
+					if ( cache[item.tile].g != item.g ) {
+						continue;
+					}
+
+					const int32_t f = item.g + OctileDistance( item.tile, goal );
+					if ( f > fLimit ) {
+						fMin = std::min( fMin, f );
+						later.push_back( item );
+						continue;
+					}
+
+					if ( item.tile == goal ) {
+						found = true;
+						break;
+					}
+
+					stats->expanded++;
+					// push in reverse so successors are visited in direction order
+					for ( int32_t dir = NUM_DIRECTIONS - 1; dir >= 0; dir-- ) {
+						Tile *neighbour = item.tile->neighbours[dir];
+						if ( !neighbour || neighbour->type == TileType::Wall ) {
+							continue;
+						}
+
+						const int32_t g = item.g + item.tile->cost[dir];
+						const auto it = cache.find( neighbour );
+						if ( it != cache.end() && g >= it->second.g ) {
+							continue;
+						}
+
+						cache[neighbour] = { g, item.tile };
+						now.push_back( { neighbour, g } );
+					}
+					peakLists = std::max( peakLists, now.size() + later.size() );
+				}
+
+				if ( found ) {
+					break;
+				}
+
+				fLimit = fMin;
+				std::swap( now, later );
+				later.clear();
+			}
+
+			stats->peakNodes = cache.size() + peakLists;
+			stats->peakBytes = HashBytes( cache, cache.size() ) + (peakLists * sizeof(fringeItem_t));
+
+			if ( !found ) {
+				return false;
+			}
+
+			stats->cost = cache[goal].g;
+			for ( Tile *tile = goal; tile; tile = cache[tile].parent ) {
+				route.push_back( tile );
+			}
+			std::reverse( route.begin(), route.end() );
+
+			return true;
+		}
+
+		//
+		// simplified memory-bounded A*
+		//	a best-first tree search over a fixed pool of nodes. when the pool is full the shallowest, highest-f leaf
+		//	is forgotten and its f is backed up into its parent, which will regenerate it if that region becomes
+		//	promising again
+		//	tiles already held with a cheaper or equal g are not generated again, this also prevents cycles. the
+		//	skipped successor waits on the tile and is forgotten instead once the holder is culled
+		//	memory: nodeBudget * sizeof(smaNode_t) + the open/leaf orderings, tile lookup and waiting list for at most
+		//	nodeBudget nodes
+		//
+
+		#define SMA_NONE (-1)
+
+		struct smaNode_t {
+			Tile		*tile;
+			int32_t		 g;
+			int32_t		 staticF; // pathmax of g + h
+			int32_t		 f; // backed up from successors
+			int32_t		 openKey; // position in the open ordering, PATH_COST_INFINITE if absent
+			int32_t		 parent;
+			int32_t		 children[NUM_DIRECTIONS]; // node if held, otherwise f of a forgotten or dominated successor
+			uint32_t	 depth;
+			uint8_t		 parentDir;
+			uint8_t		 childMask; // successors currently held
+			uint8_t		 ungenerated; // successors that have never been generated
+			uint8_t		 forgotten; // successors that were culled and must be regenerated
+			uint8_t		 dominated; // successors skipped because a cheaper node held their tile
+			bool		 inLeaves;
+		};
+
+		// open: lowest f, deepest first
+		// leaves: highest f, shallowest first
+		typedef std::tuple<int32_t, int32_t, int32_t> smaKey_t;
+
+		bool SearchSMAStar( const Grid &grid, Tile *start, Tile *goal, nodeList &route, searchStats_t *stats,
+			size_t nodeBudget )
+		{
+			std::vector<smaNode_t> nodes( nodeBudget );
+			std::vector<int32_t> freeList;
+			std::set<smaKey_t> open, leaves;
+			std::unordered_map<const Tile *, int32_t> held; // cheapest node held for each tile
+			std::unordered_multimap<const Tile *, int32_t> waiting; // nodes with a successor dominated by the tile
+			size_t used = 0u, peakUsed = 0u, peakHeld = 0u, peakWaiting = 0u;
+
+			freeList.reserve( nodeBudget );
+			for ( int32_t i = static_cast<int32_t>( nodeBudget ) - 1; i >= 0; i-- ) {
+				freeList.push_back( i );
+			}
+
+			auto OpenKey = [&]( const smaNode_t &node ) -> int32_t {
+				if ( node.tile == goal ) {
+					return node.staticF;
+				}
+				int32_t key = PATH_COST_INFINITE;
+				if ( node.ungenerated ) {
+					key = node.staticF;
+				}
+				for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+					if ( node.forgotten & (1u << dir) ) {
+						key = std::min( key, node.children[dir] );
+					}
+				}
+				return key;
+			};
+
+			auto BackedF = [&]( const smaNode_t &node ) -> int32_t {
+				int32_t f = OpenKey( node );
+				for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+					if ( node.childMask & (1u << dir) ) {
+						f = std::min( f, nodes[node.children[dir]].f );
+					}
+				}
+				return f;
+			};
+
+			// re-evaluate a node's orderings and back its f up through its ancestors
+			auto Update = [&]( int32_t index ) {
+				while ( index != SMA_NONE ) {
+					smaNode_t &node = nodes[index];
+					const int32_t key = OpenKey( node );
+					const int32_t f = BackedF( node );
+
+					if ( node.openKey != PATH_COST_INFINITE ) {
+						open.erase( smaKey_t( node.openKey, -static_cast<int32_t>( node.depth ), index ) );
+					}
+					if ( key != PATH_COST_INFINITE ) {
+						open.insert( smaKey_t( key, -static_cast<int32_t>( node.depth ), index ) );
+					}
+
+					// the root is never forgotten
+					if ( node.inLeaves ) {
+						leaves.erase( smaKey_t( -node.f, node.depth, index ) );
+					}
+					node.inLeaves = !node.childMask && node.parent != SMA_NONE;
+					if ( node.inLeaves ) {
+						leaves.insert( smaKey_t( -f, node.depth, index ) );
+					}
+
+					const bool changed = (f != node.f);
+					node.openKey = key;
+					node.f = f;
+					if ( !changed ) {
+						break;
+					}
+					index = node.parent;
+				}
+			};
+
+			auto Allocate = [&]( Tile *tile, int32_t g, int32_t staticF, int32_t parent, uint8_t parentDir,
+				uint32_t depth ) -> int32_t
+			{
+				const int32_t index = freeList.back();
+				freeList.pop_back();
+				used++;
+				peakUsed = std::max( peakUsed, used );
+
+				smaNode_t &node = nodes[index];
+				node.tile = tile;
+				node.g = g;
+				node.staticF = staticF;
+				node.f = PATH_COST_INFINITE;
+				node.openKey = PATH_COST_INFINITE;
+				node.parent = parent;
+				node.depth = depth;
+				node.parentDir = parentDir;
+				node.childMask = 0u;
+				node.ungenerated = (tile == goal) ? 0u : PassableMask( tile );
+				node.forgotten = 0u;
+				node.dominated = 0u;
+				node.inLeaves = false;
+
+				held[tile] = index;
+				peakHeld = std::max( peakHeld, held.size() );
+				Update( index );
+				return index;
+			};
+
+			// the cheapest node for a tile was culled, so the successors it dominated must be regenerated
+			auto Wake = [&]( const Tile *tile ) {
+				const auto range = waiting.equal_range( tile );
+				for ( auto it = range.first; it != range.second; ++it ) {
+					smaNode_t &node = nodes[it->second];
+					for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+						if ( node.tile->neighbours[dir] == tile ) {
+							const uint8_t bit = static_cast<uint8_t>( 1u << dir );
+							node.dominated &= ~bit;
+							node.forgotten |= bit;
+						}
+					}
+					Update( it->second );
+				}
+				waiting.erase( range.first, range.second );
+			};
+
+			// forget the worst leaf, other than the node being expanded
+			auto Cull = [&]( int32_t keep ) -> bool {
+				for ( const auto &it : leaves ) {
+					const int32_t index = std::get<2>( it );
+					if ( index == keep ) {
+						continue;
+					}
+
+					smaNode_t &leaf = nodes[index];
+					smaNode_t &parent = nodes[leaf.parent];
+					const uint8_t bit = static_cast<uint8_t>( 1u << leaf.parentDir );
+					parent.childMask &= ~bit;
+					// dead ends are not worth regenerating
+					if ( leaf.f != PATH_COST_INFINITE ) {
+						parent.forgotten |= bit;
+						parent.children[leaf.parentDir] = leaf.f;
+					}
+
+					leaves.erase( it );
+					if ( leaf.openKey != PATH_COST_INFINITE ) {
+						open.erase( smaKey_t( leaf.openKey, -static_cast<int32_t>( leaf.depth ), index ) );
+					}
+					for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+						if ( !(leaf.dominated & (1u << dir)) ) {
+							continue;
+						}
+						const auto range = waiting.equal_range( leaf.tile->neighbours[dir] );
+						for ( auto waitIt = range.first; waitIt != range.second; ++waitIt ) {
+							if ( waitIt->second == index ) {
+								waiting.erase( waitIt );
+								break;
+							}
+						}
+					}
+					const auto heldIt = held.find( leaf.tile );
+					if ( heldIt != held.end() && heldIt->second == index ) {
+						held.erase( heldIt );
+						Wake( leaf.tile );
+					}
+					freeList.push_back( index );
+					used--;
+
+					Update( leaf.parent );
+					return true;
+				}
+				return false;
+			};
+
+			// give up rather than thrash forever when the budget is hopelessly small, this is reported as the budget
+			//	being exhausted rather than there being no route
+			const uint64_t maxSteps = (static_cast<uint64_t>( grid.Size() ) + nodeBudget) * 64u;
+			uint64_t steps = 0u;
+
+			Allocate( start, 0, OctileDistance( start, goal ), SMA_NONE, 0u, 0u );
+			stats->iterations = 1u;
+
+			int32_t result = SMA_NONE;
+			while ( !open.empty() && steps++ < maxSteps ) {
+				const int32_t best = std::get<2>( *open.begin() );
+				if ( nodes[best].tile == goal ) {
+					result = best;
+					break;
+				}
+				stats->expanded++;
+
+				// generate one successor at a time, the one the open key came from
+				smaNode_t &node = nodes[best];
+				int32_t dir = NUM_DIRECTIONS;
+				int32_t remembered = PATH_COST_INFINITE;
+				for ( int32_t i = 0; i < NUM_DIRECTIONS; i++ ) {
+					if ( (node.forgotten & (1u << i)) && node.children[i] < remembered ) {
+						dir = i;
+						remembered = node.children[i];
+					}
+				}
+				if ( node.ungenerated && (dir == NUM_DIRECTIONS || node.staticF < remembered) ) {
+					dir = 0;
+					while ( !(node.ungenerated & (1u << dir)) ) {
+						dir++;
+					}
+					remembered = PATH_COST_INFINITE;
+				}
+				const uint8_t bit = static_cast<uint8_t>( 1u << dir );
+				node.ungenerated &= ~bit;
+				node.forgotten &= ~bit;
+
+				Tile *neighbour = node.tile->neighbours[dir];
+				const int32_t g = node.g + node.tile->cost[dir];
+				const uint32_t depth = node.depth + 1u;
+
+				// dominated by a node we already hold
+				const auto heldIt = held.find( neighbour );
+				const bool dominated = heldIt != held.end() && nodes[heldIt->second].g <= g;
+
+				// a route through here would not fit in memory
+				const bool tooDeep = depth + 1u >= nodeBudget && neighbour != goal;
+
+				// a forgotten successor keeps the f it was backed up to
+				int32_t staticF = std::max( node.staticF, g + OctileDistance( neighbour, goal ) );
+				if ( remembered != PATH_COST_INFINITE ) {
+					staticF = std::max( staticF, remembered );
+				}
+
+				if ( dominated ) {
+					// a route through the tile costs at least what the cheaper node has backed up, which is remembered
+					//	for when it is woken
+					const smaNode_t &holder = nodes[heldIt->second];
+					node.dominated |= bit;
+					node.children[dir] = staticF;
+					if ( holder.f != PATH_COST_INFINITE ) {
+						node.children[dir] = std::max( staticF, holder.f + (g - holder.g) );
+					}
+					waiting.emplace( neighbour, best );
+					peakWaiting = std::max( peakWaiting, waiting.size() );
+					Update( best );
+					continue;
+				}
+
+				if ( tooDeep || (freeList.empty() && !Cull( best )) ) {
+					Update( best );
+					continue;
+				}
+
+				const int32_t child = Allocate( neighbour, g, staticF, best, static_cast<uint8_t>( dir ), depth );
+				node.children[dir] = child;
+				node.childMask |= bit;
+				Update( best );
+			}
+
+			stats->peakNodes = peakUsed;
+			stats->peakBytes = (nodeBudget * (sizeof(smaNode_t) + sizeof(int32_t)))
+				+ (2u * TreeBytes<smaKey_t>( peakUsed )) + HashBytes( held, peakHeld )
+				+ HashBytes( waiting, peakWaiting );
+
+			if ( result == SMA_NONE ) {
+				stats->exhausted = !open.empty();
+				return false;
+			}
+
+			stats->cost = nodes[result].g;
+			for ( int32_t index = result; index != SMA_NONE; index = nodes[index].parent ) {
+				route.push_back( nodes[index].tile );
+			}
+			std::reverse( route.begin(), route.end() );
+
+			return true;
+		}
+
+	} // namespace ClientGame
+
+} // namespace XS
@@ -0,0 +1,317 @@
+#include <algorithm>
+
+#include "XSCommon/XSCommon.h"
+#include "XSCommon/XSError.h"
+#include "XSCommon/XSFile.h"
+#include "XSCommon/XSJob.h"
+#include "XSClient/XSClientPathDatabase.h"
+
+// references:
+//	Botea, "Ultra-fast optimal pathfinding without runtime search" (2011)
+//	Strasser, Botea & Harabor, "Compressing optimal paths with run length encoding" (2015)
+
+namespace XS {
+
+	namespace ClientGame {
+
+		#define CPD_MAGIC (0x44504358u) // "XCPD"
+		#define CPD_VERSION (1u)
+		#define CPD_NO_MOVE (0xFFu)
+		#define CPD_MOVE_BITS (3u)
+		#define CPD_MOVE_MASK ((1u << CPD_MOVE_BITS) - 1u)
+		// move costs are below this, so the Dijkstra buckets of the current distance are never pushed to
+		#define CPD_BUCKETS (4u)
+		// each one is a full Dijkstra, so a job can take a few without the scratch buffers costing much
+		#define CPD_SOURCES_PER_JOB (16u)
+
+		static inline bool Passable( const Tile *tile ) {
+			return tile && tile->type != TileType::Wall;
+		}
+
+		// identifies the walls a database was built for
+		static uint32_t HashGrid( const Grid &grid ) {
+			// FNV-1a
+			uint32_t hash = 2166136261u;
+			auto Mix = [&hash]( uint32_t value ) {
+				hash = (hash ^ value) * 16777619u;
+			};
+
+			Mix( grid.width );
+			Mix( grid.height );
+			for ( size_t i = 0u; i < grid.Size(); i++ ) {
+				Mix( Passable( &grid.tiles[i] ) ? 1u : 0u );
+			}
+			return hash;
+		}
+
+		size_t PathDatabase::Words( size_t numTiles, size_t numRuns ) {
+			return (sizeof(header_t) / sizeof(uint32_t)) + (2u * numTiles) + (numTiles + 1u) + numRuns;
+		}
+
+		PathDatabase::PathDatabase( const Grid &grid )
+		: grid( grid ), mapping(), header( nullptr ), order( nullptr ), components( nullptr ), offsets( nullptr ),
+			runs( nullptr )
+		{
+			const size_t numTiles = grid.Size();
+			if ( numTiles >= (1u << (32u - CPD_MOVE_BITS)) ) {
+				throw( XSError( "PathDatabase: grid is too large to encode" ) );
+			}
+
+			// number the targets depth-first, one connected area after another, walls last
+			std::vector<uint32_t> tileOrder( numTiles, CPD_NONE );
+			std::vector<uint32_t> tileComponent( numTiles, CPD_NONE );
+			std::vector<uint32_t> targets;
+			std::vector<uint32_t> stack;
+			targets.reserve( numTiles );
+			uint32_t numComponents = 0u;
+			for ( uint32_t root = 0u; root < numTiles; root++ ) {
+				if ( tileOrder[root] != CPD_NONE || !Passable( &grid.tiles[root] ) ) {
+					continue;
+				}
+
+				stack.push_back( root );
+				while ( !stack.empty() ) {
+					const uint32_t index = stack.back();
+					stack.pop_back();
+					if ( tileOrder[index] != CPD_NONE ) {
+						continue;
+					}
+					tileOrder[index] = static_cast<uint32_t>( targets.size() );
+					tileComponent[index] = numComponents;
+					targets.push_back( index );
+
+					// push in reverse so neighbours are visited in direction order
+					const Tile *tile = &grid.tiles[index];
+					for ( int32_t dir = NUM_DIRECTIONS - 1; dir >= 0; dir-- ) {
+						const Tile *neighbour = tile->neighbours[dir];
+						if ( Passable( neighbour ) && tileOrder[grid.Index( neighbour )] == CPD_NONE ) {
+							stack.push_back( static_cast<uint32_t>( grid.Index( neighbour ) ) );
+						}
+					}
+				}
+				numComponents++;
+			}
+			for ( uint32_t index = 0u; index < numTiles; index++ ) {
+				if ( tileOrder[index] == CPD_NONE ) {
+					tileOrder[index] = static_cast<uint32_t>( targets.size() );
+					targets.push_back( index );
+				}
+			}
+
+			// a Dijkstra per source, ranges of sources are spread over the job system
+			std::vector<std::vector<uint32_t>> sourceRuns( numTiles );
+
+			auto Run = [&]( uint32_t begin, uint32_t end ) {
+				std::vector<int32_t> distance( numTiles );
+				std::vector<uint8_t> firstMove( numTiles );
+				std::vector<uint32_t> buckets[CPD_BUCKETS];
+
+				for ( uint32_t source = begin; source < end; source++ ) {
+					if ( !Passable( &grid.tiles[source] ) ) {
+						continue;
+					}
+
+					std::fill( distance.begin(), distance.end(), PATH_COST_INFINITE );
+					std::fill( firstMove.begin(), firstMove.end(), CPD_NO_MOVE );
+					distance[source] = 0;
+					buckets[0].push_back( source );
+
+					// costs are small integers, so a bucket per distance replaces the priority queue
+					size_t pending = 1u;
+					for ( int32_t current = 0; pending; current++ ) {
+						std::vector<uint32_t> &bucket = buckets[current % CPD_BUCKETS];
+						for ( const auto &index : bucket ) {
+							pending--;
+							// stale entry, a cheaper route was pushed after this one
+							if ( distance[index] != current ) {
+								continue;
+							}
+
+							const Tile *tile = &grid.tiles[index];
+							for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+								const Tile *neighbour = tile->neighbours[dir];
+								if ( !Passable( neighbour ) ) {
+									continue;
+								}
+
+								const uint32_t neighbourIndex = static_cast<uint32_t>( grid.Index( neighbour ) );
+								const int32_t cost = current + tile->cost[dir];
+								if ( cost >= distance[neighbourIndex] ) {
+									continue;
+								}
+								distance[neighbourIndex] = cost;
+								firstMove[neighbourIndex] = (index == source)
+									? static_cast<uint8_t>( dir )
+									: firstMove[index];
+								buckets[cost % CPD_BUCKETS].push_back( neighbourIndex );
+								pending++;
+							}
+						}
+						bucket.clear();
+					}
+
+					// run-length encode over the target order, targets without a move extend the current run
+					std::vector<uint32_t> &out = sourceRuns[source];
+					uint32_t current = CPD_NO_MOVE;
+					for ( uint32_t position = 0u; position < numTiles; position++ ) {
+						const uint32_t move = firstMove[targets[position]];
+						if ( move == CPD_NO_MOVE || move == current ) {
+							continue;
+						}
+						// the first run starts at 0 so it also covers any targets before it
+						out.push_back( ((out.empty() ? 0u : position) << CPD_MOVE_BITS) | move );
+						current = move;
+					}
+					out.shrink_to_fit();
+				}
+			};
+			Job::ParallelFor( 0u, static_cast<uint32_t>( numTiles ), CPD_SOURCES_PER_JOB, Run );
+
+			// flatten into the file layout
+			size_t numRuns = 0u;
+			for ( const auto &it : sourceRuns ) {
+				numRuns += it.size();
+			}
+			storage.resize( Words( numTiles, numRuns ) );
+
+			header_t *outHeader = reinterpret_cast<header_t *>( storage.data() );
+			outHeader->magic = CPD_MAGIC;
+			outHeader->version = CPD_VERSION;
+			outHeader->width = grid.width;
+			outHeader->height = grid.height;
+			outHeader->mapHash = HashGrid( grid );
+			outHeader->numTiles = static_cast<uint32_t>( numTiles );
+			outHeader->numRuns = static_cast<uint32_t>( numRuns );
+			outHeader->reserved = 0u;
+
+			uint32_t *out = storage.data() + (sizeof(header_t) / sizeof(uint32_t));
+			out = std::copy( tileOrder.begin(), tileOrder.end(), out );
+			out = std::copy( tileComponent.begin(), tileComponent.end(), out );
+			uint32_t *outOffsets = out;
+			out += numTiles + 1u;
+			uint32_t offset = 0u;
+			for ( size_t source = 0u; source < numTiles; source++ ) {
+				outOffsets[source] = offset;
+				out = std::copy( sourceRuns[source].begin(), sourceRuns[source].end(), out );
+				offset += static_cast<uint32_t>( sourceRuns[source].size() );
+			}
+			outOffsets[numTiles] = offset;
+
+			if ( !Attach( reinterpret_cast<const uint8_t *>( storage.data() ), storage.size() * sizeof(uint32_t) ) ) {
+				throw( XSError( "PathDatabase: built an inconsistent database" ) );
+			}
+		}
+
+		PathDatabase::PathDatabase( const Grid &grid, const char *gamePath )
+		: grid( grid ), mapping(), header( nullptr ), order( nullptr ), components( nullptr ), offsets( nullptr ),
+			runs( nullptr )
+		{
+			char path[XS_MAX_FILENAME];
+			if ( !File::GetFullPath( gamePath, path, sizeof(path) ) || !OS::MapFile( path, &mapping ) ) {
+				return;
+			}
+
+			if ( !Attach( mapping.Data(), mapping.length ) ) {
+				OS::UnmapFile( &mapping );
+			}
+		}
+
+		PathDatabase::~PathDatabase() {
+			if ( mapping.Data() ) {
+				OS::UnmapFile( &mapping );
+			}
+		}
+
+		bool PathDatabase::Attach( const uint8_t *data, size_t length ) {
+			header = nullptr;
+
+			const header_t *candidate = reinterpret_cast<const header_t *>( data );
+			if ( length < sizeof(header_t)
+				|| candidate->magic != CPD_MAGIC
+				|| candidate->version != CPD_VERSION
+				|| candidate->width != grid.width
+				|| candidate->height != grid.height
+				|| candidate->numTiles != grid.Size()
+				|| length != Words( candidate->numTiles, candidate->numRuns ) * sizeof(uint32_t)
+				|| candidate->mapHash != HashGrid( grid ) )
+			{
+				return false;
+			}
+
+			const size_t numTiles = candidate->numTiles;
+			order = reinterpret_cast<const uint32_t *>( data + sizeof(header_t) );
+			components = order + numTiles;
+			offsets = components + numTiles;
+			runs = offsets + numTiles + 1u;
+			if ( offsets[numTiles] != candidate->numRuns ) {
+				return false;
+			}
+
+			header = candidate;
+			return true;
+		}
+
+		size_t PathDatabase::Bytes( void ) const {
+			return Words( header->numTiles, header->numRuns ) * sizeof(uint32_t);
+		}
+
+		bool PathDatabase::Write( const char *gamePath ) const {
+			const File f( gamePath, FileMode::WRITE_BINARY );
+			if ( !f.open ) {
+				return false;
+			}
+
+			f.Write( header, Bytes() );
+			return true;
+		}
+
+		int32_t PathDatabase::FirstMove( const Tile *from, const Tile *to ) const {
+			const size_t fromIndex = grid.Index( from );
+			const size_t toIndex = grid.Index( to );
+			if ( from == to || components[fromIndex] == CPD_NONE || components[fromIndex] != components[toIndex] ) {
+				return -1;
+			}
+
+			// the last run starting at or before the target
+			const uint32_t key = (order[toIndex] << CPD_MOVE_BITS) | CPD_MOVE_MASK;
+			const uint32_t *run = std::upper_bound( runs + offsets[fromIndex], runs + offsets[fromIndex + 1u], key );
+			return static_cast<int32_t>( *(run - 1) & CPD_MOVE_MASK );
+		}
+
+		bool PathDatabase::Extract( Tile *start, Tile *goal, nodeList &route, searchStats_t *stats ) const {
+			route.clear();
+			stats->cost = -1;
+			stats->iterations = 1u;
+			stats->peakBytes = Bytes();
+
+			if ( start == goal ) {
+				route.push_back( start );
+				stats->cost = 0;
+				return true;
+			}
+			if ( FirstMove( start, goal ) == -1 ) {
+				return false;
+			}
+
+			int32_t cost = 0;
+			route.push_back( start );
+			for ( Tile *tile = start; tile != goal; ) {
+				const int32_t dir = FirstMove( tile, goal );
+				// a route can't be longer than the map, anything else means the database doesn't match
+				if ( dir == -1 || !Passable( tile->neighbours[dir] ) || route.size() > header->numTiles ) {
+					route.clear();
+					return false;
+				}
+				cost += tile->cost[dir];
+				tile = tile->neighbours[dir];
+				route.push_back( tile );
+			}
+
+			stats->cost = cost;
+			stats->peakNodes = route.size();
+			return true;
+		}
+
+	} // namespace ClientGame
+
+} // namespace XS
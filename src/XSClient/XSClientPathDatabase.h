@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+
+#include "XSClient/XSClientPath.h"
+#include "XSSystem/XSOS.h"
+
+namespace XS {
+
+	namespace ClientGame {
+
+		#define CPD_NONE (UINT32_MAX)
+
+		// a compressed path database (CPD) stores the optimal first move from every tile towards every other tile
+		// queries follow first moves until the goal is reached, there is no search and no open list
+		// targets are numbered in depth-first order so nearby targets tend to share a first move, and each source's
+		//	moves are run-length encoded over that order. walls and unreachable targets don't care which move they get,
+		//	so they extend the run before them
+		// the in-memory layout is the file layout, so a database loaded from disk is used straight from the mapping
+		class PathDatabase {
+		private:
+			// every section is a uint32_t array, in this order
+			struct header_t {
+				uint32_t	magic;
+				uint32_t	version;
+				uint32_t	width, height;
+				uint32_t	mapHash; // walls the database was built for
+				uint32_t	numTiles;
+				uint32_t	numRuns;
+				uint32_t	reserved;
+			};
+
+			Grid					 grid;
+			std::vector<uint32_t>	 storage; // used when built in memory
+			OS::mappedFile_t		 mapping; // used when loaded from a file
+			const header_t			*header;
+			const uint32_t			*order; // tile index -> depth-first target number
+			const uint32_t			*components; // tile index -> connected area, CPD_NONE for walls
+			const uint32_t			*offsets; // first run of each source, numTiles + 1 entries
+			const uint32_t			*runs; // first target number << 3 | direction
+
+			// size of a database in uint32_t words
+			static size_t Words(
+				size_t numTiles,
+				size_t numRuns
+			);
+
+			// point the sections at a complete database, returns false if it doesn't match the grid
+			bool Attach(
+				const uint8_t *data,
+				size_t length
+			);
+
+		public:
+			// don't allow default instantiation
+			PathDatabase() = delete;
+			PathDatabase( const PathDatabase& ) = delete;
+			PathDatabase& operator=( const PathDatabase& ) = delete;
+
+			// build the database for every tile of the grid, spread over the job system
+			explicit PathDatabase(
+				const Grid &grid
+			);
+
+			// map a database file that was written for this grid, check IsValid() afterwards
+			PathDatabase(
+				const Grid &grid,
+				const char *gamePath
+			);
+
+			~PathDatabase();
+
+			// false if the file could not be loaded or was built for different walls
+			inline bool IsValid( void ) const {
+				return header != nullptr;
+			}
+
+			inline size_t NumRuns( void ) const {
+				return header->numRuns;
+			}
+
+			// size of the database, in memory and on disk
+			size_t Bytes(
+				void
+			) const;
+
+			// returns false if the file could not be written
+			bool Write(
+				const char *gamePath
+			) const;
+
+			// optimal direction to move from one tile towards another, -1 if there is no route
+			int32_t FirstMove(
+				const Tile *from,
+				const Tile *to
+			) const;
+
+			// follow first moves from start to goal, returns false if there is no route
+			bool Extract(
+				Tile *start,
+				Tile *goal,
+				nodeList &route,
+				searchStats_t *stats
+			) const;
+		};
+
+		// build a database for a random map, write it out, map it back in and compare queries against A*
+		//	pathcpdbench [width] [height] [queries] [wall percentage]
+		void Cmd_PathCPDBench(
+			const commandContext_t * const context
+		);
+
+	} // namespace ClientGame
+
+} // namespace XS
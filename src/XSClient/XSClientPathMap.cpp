@@ -0,0 +1,407 @@
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include "XSCommon/XSCommon.h"
+#include "XSCommon/XSConsole.h"
+#include "XSClient/XSClientPathMap.h"
+
+// multi-target queries and multi-source Dijkstra maps
+// references:
+//	http://www.roguebasin.com/index.php?title=The_Incredible_Power_of_Dijkstra_Maps
+//	Ramalingam & Reps, "An incremental algorithm for a generalization of the shortest-path problem" (1996)
+
+namespace XS {
+
+	namespace ClientGame {
+
+		#define MAP_NO_TILE (UINT32_MAX)
+
+		static inline bool Passable( const Tile *tile ) {
+			return tile && tile->type != TileType::Wall;
+		}
+
+		//
+		// nearest of many goals
+		//
+
+		struct nearestOpen_t {
+			int32_t		f, g;
+			uint32_t	index;
+
+			// ordered for a min-heap on f, preferring deeper nodes on ties
+			inline bool operator<( const nearestOpen_t &rhs ) const {
+				if ( f != rhs.f ) {
+					return f > rhs.f;
+				}
+				return g < rhs.g;
+			}
+		};
+
+		bool SearchNearest( const Grid &grid, Tile *start, const nodeList &goals, nodeList &route,
+			searchStats_t *stats )
+		{
+			route.clear();
+			stats->cost = -1;
+			stats->iterations = 1u;
+			if ( goals.empty() ) {
+				return false;
+			}
+
+			std::vector<int32_t> g( grid.Size(), PATH_COST_INFINITE );
+			std::vector<uint32_t> parent( grid.Size(), MAP_NO_TILE );
+			std::vector<uint8_t> isGoal( grid.Size(), 0u );
+			std::vector<nearestOpen_t> open;
+			size_t peakOpen = 1u;
+			for ( const auto &goal : goals ) {
+				isGoal[grid.Index( goal )] = 1u;
+			}
+
+			// the minimum of consistent heuristics is still consistent
+			auto Heuristic = [&]( const Tile *tile ) -> int32_t {
+				int32_t h = PATH_COST_INFINITE;
+				for ( const auto &goal : goals ) {
+					h = std::min( h, OctileDistance( tile, goal ) );
+				}
+				return h;
+			};
+
+			const uint32_t startIndex = grid.Index( start );
+			g[startIndex] = 0;
+			open.push_back( { Heuristic( start ), 0, startIndex } );
+
+			uint32_t found = MAP_NO_TILE;
+			while ( !open.empty() ) {
+				std::pop_heap( open.begin(), open.end() );
+				const nearestOpen_t current = open.back();
+				open.pop_back();
+
+				// stale entry, a cheaper route was pushed after this one
+				if ( current.g != g[current.index] ) {
+					continue;
+				}
+
+				if ( isGoal[current.index] ) {
+					found = current.index;
+					break;
+				}
+
+				stats->expanded++;
+				const Tile *tile = &grid.tiles[current.index];
+				for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+					const Tile *neighbour = tile->neighbours[dir];
+					if ( !Passable( neighbour ) ) {
+						continue;
+					}
+
+					const uint32_t index = grid.Index( neighbour );
+					const int32_t cost = current.g + tile->cost[dir];
+					if ( cost >= g[index] ) {
+						continue;
+					}
+
+					g[index] = cost;
+					parent[index] = current.index;
+					open.push_back( { cost + Heuristic( neighbour ), cost, index } );
+					std::push_heap( open.begin(), open.end() );
+				}
+				peakOpen = std::max( peakOpen, open.size() );
+			}
+
+			stats->peakNodes = grid.Size();
+			stats->peakBytes = (grid.Size() * (sizeof(int32_t) + sizeof(uint32_t) + sizeof(uint8_t)))
+				+ (peakOpen * sizeof(nearestOpen_t));
+
+			if ( found == MAP_NO_TILE ) {
+				return false;
+			}
+
+			stats->cost = g[found];
+			for ( uint32_t index = found; index != MAP_NO_TILE; index = parent[index] ) {
+				route.push_back( &grid.tiles[index] );
+			}
+			std::reverse( route.begin(), route.end() );
+
+			return true;
+		}
+
+		//
+		// Dijkstra maps
+		//
+
+		DijkstraMap::DijkstraMap( const Grid &grid )
+		: grid( grid ), distance( grid.Size(), PATH_COST_INFINITE ), next( grid.Size(), MAP_NO_TILE ),
+			seed( grid.Size(), 0u ), numSeeds( 0u )
+		{
+		}
+
+		size_t DijkstraMap::Bytes( void ) const {
+			return (distance.capacity() * sizeof(int32_t)) + (next.capacity() * sizeof(uint32_t))
+				+ (seed.capacity() * sizeof(uint8_t)) + (open.capacity() * sizeof(open_t))
+				+ (invalid.capacity() * sizeof(uint32_t));
+		}
+
+		void DijkstraMap::Relax( uint32_t index ) {
+			const Tile *tile = &grid.tiles[index];
+			for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+				const Tile *neighbour = tile->neighbours[dir];
+				if ( !Passable( neighbour ) ) {
+					continue;
+				}
+
+				// moves cost the same both ways, so the cost to the neighbour is the cost back from it
+				const uint32_t neighbourIndex = grid.Index( neighbour );
+				if ( distance[neighbourIndex] == PATH_COST_INFINITE ) {
+					continue;
+				}
+				const int32_t cost = distance[neighbourIndex] + tile->cost[dir];
+				if ( cost < distance[index] ) {
+					distance[index] = cost;
+					next[index] = neighbourIndex;
+				}
+			}
+
+			if ( distance[index] != PATH_COST_INFINITE ) {
+				open.push_back( { distance[index], index } );
+				std::push_heap( open.begin(), open.end() );
+			}
+		}
+
+		void DijkstraMap::Invalidate( uint32_t index ) {
+			// everything whose route to a seed passes through this tile, found by walking the next pointers backwards
+			invalid.clear();
+			invalid.push_back( index );
+			distance[index] = PATH_COST_INFINITE;
+			next[index] = MAP_NO_TILE;
+			for ( size_t i = 0u; i < invalid.size(); i++ ) {
+				const Tile *tile = &grid.tiles[invalid[i]];
+				for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+					const Tile *neighbour = tile->neighbours[dir];
+					if ( !neighbour ) {
+						continue;
+					}
+					const uint32_t neighbourIndex = grid.Index( neighbour );
+					if ( next[neighbourIndex] == invalid[i] ) {
+						distance[neighbourIndex] = PATH_COST_INFINITE;
+						next[neighbourIndex] = MAP_NO_TILE;
+						invalid.push_back( neighbourIndex );
+					}
+				}
+			}
+
+			// pick the best remaining route from the edge of the invalidated region
+			for ( const auto &it : invalid ) {
+				if ( Passable( &grid.tiles[it] ) ) {
+					Relax( it );
+				}
+			}
+		}
+
+		void DijkstraMap::Propagate( void ) {
+			while ( !open.empty() ) {
+				std::pop_heap( open.begin(), open.end() );
+				const open_t current = open.back();
+				open.pop_back();
+
+				// stale entry, a cheaper route was pushed after this one
+				if ( current.distance != distance[current.index] ) {
+					continue;
+				}
+
+				const Tile *tile = &grid.tiles[current.index];
+				for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+					const Tile *neighbour = tile->neighbours[dir];
+					if ( !Passable( neighbour ) ) {
+						continue;
+					}
+
+					const uint32_t index = grid.Index( neighbour );
+					const int32_t cost = current.distance + tile->cost[dir];
+					if ( cost < distance[index] ) {
+						distance[index] = cost;
+						next[index] = current.index;
+						open.push_back( { cost, index } );
+						std::push_heap( open.begin(), open.end() );
+					}
+				}
+			}
+		}
+
+		void DijkstraMap::Rebuild( void ) {
+			std::fill( distance.begin(), distance.end(), PATH_COST_INFINITE );
+			std::fill( next.begin(), next.end(), MAP_NO_TILE );
+			open.clear();
+
+			for ( size_t index = 0u; index < seed.size(); index++ ) {
+				if ( !seed[index] ) {
+					continue;
+				}
+				// seeds that were walled over since they were added
+				if ( !Passable( &grid.tiles[index] ) ) {
+					seed[index] = 0u;
+					numSeeds--;
+					continue;
+				}
+				distance[index] = 0;
+				open.push_back( { 0, static_cast<uint32_t>( index ) } );
+			}
+			std::make_heap( open.begin(), open.end() );
+
+			Propagate();
+		}
+
+		void DijkstraMap::AddSeed( Tile *tile ) {
+			const uint32_t index = grid.Index( tile );
+			if ( seed[index] || !Passable( tile ) ) {
+				return;
+			}
+
+			seed[index] = 1u;
+			numSeeds++;
+			distance[index] = 0;
+			next[index] = MAP_NO_TILE;
+			open.push_back( { 0, index } );
+			std::push_heap( open.begin(), open.end() );
+
+			// distances only shrink, nothing has to be invalidated
+			Propagate();
+		}
+
+		void DijkstraMap::RemoveSeed( Tile *tile ) {
+			const uint32_t index = grid.Index( tile );
+			if ( !seed[index] ) {
+				return;
+			}
+
+			seed[index] = 0u;
+			numSeeds--;
+			Invalidate( index );
+			Propagate();
+		}
+
+		void DijkstraMap::ClearSeeds( void ) {
+			std::fill( seed.begin(), seed.end(), 0u );
+			numSeeds = 0u;
+			std::fill( distance.begin(), distance.end(), PATH_COST_INFINITE );
+			std::fill( next.begin(), next.end(), MAP_NO_TILE );
+			open.clear();
+		}
+
+		void DijkstraMap::TileChanged( Tile *tile ) {
+			const uint32_t index = grid.Index( tile );
+
+			if ( !Passable( tile ) ) {
+				// walled over, a seed under the wall goes with it
+				if ( seed[index] ) {
+					seed[index] = 0u;
+					numSeeds--;
+				}
+				Invalidate( index );
+			}
+			else if ( seed[index] ) {
+				// a seed that was walled over is never kept, so this can only be a no-op
+				return;
+			}
+			else {
+				// opened up, distances can only shrink
+				distance[index] = PATH_COST_INFINITE;
+				next[index] = MAP_NO_TILE;
+				Relax( index );
+			}
+
+			Propagate();
+		}
+
+		int32_t DijkstraMap::Distance( const Tile *tile ) const {
+			return distance[grid.Index( tile )];
+		}
+
+		Tile *DijkstraMap::Downhill( const Tile *tile ) const {
+			const uint32_t index = next[grid.Index( tile )];
+			if ( index == MAP_NO_TILE ) {
+				return nullptr;
+			}
+			return &grid.tiles[index];
+		}
+
+		bool DijkstraMap::Route( Tile *start, nodeList &route ) const {
+			route.clear();
+			if ( Distance( start ) == PATH_COST_INFINITE ) {
+				return false;
+			}
+
+			for ( Tile *tile = start; tile; tile = Downhill( tile ) ) {
+				route.push_back( tile );
+			}
+			return true;
+		}
+
+		//
+		// resident maps
+		//
+
+		static std::unordered_map<std::string, DijkstraMap *> dijkstraMaps;
+
+		DijkstraMap *CreateDijkstraMap( const char *name, const Grid &grid ) {
+			DijkstraMap *&map = dijkstraMaps[name];
+			delete map;
+			map = new DijkstraMap( grid );
+			return map;
+		}
+
+		DijkstraMap *GetDijkstraMap( const char *name ) {
+			const auto it = dijkstraMaps.find( name );
+			if ( it == dijkstraMaps.end() ) {
+				return nullptr;
+			}
+			return it->second;
+		}
+
+		void DeleteDijkstraMap( const char *name ) {
+			const auto it = dijkstraMaps.find( name );
+			if ( it != dijkstraMaps.end() ) {
+				delete it->second;
+				dijkstraMaps.erase( it );
+			}
+		}
+
+		void DeleteAllDijkstraMaps( void ) {
+			for ( auto &it : dijkstraMaps ) {
+				delete it.second;
+			}
+			dijkstraMaps.clear();
+		}
+
+		void DijkstraMapsTileChanged( const Grid &grid, Tile *tile ) {
+			for ( auto &it : dijkstraMaps ) {
+				if ( it.second->GetGrid().tiles == grid.tiles ) {
+					it.second->TileChanged( tile );
+				}
+			}
+		}
+
+		void RebuildDijkstraMaps( const Grid &grid ) {
+			for ( auto &it : dijkstraMaps ) {
+				if ( it.second->GetGrid().tiles == grid.tiles ) {
+					it.second->Rebuild();
+				}
+			}
+		}
+
+		void Cmd_PathMaps( const commandContext_t * const context ) {
+			console.Print( "Dijkstra maps:\n" );
+			Indent indent( 1 );
+
+			size_t totalBytes = 0u;
+			for ( const auto &it : dijkstraMaps ) {
+				const Grid &grid = it.second->GetGrid();
+				console.Print( "%-16s %ux%u, %u seeds, %.1f KiB\n", it.first.c_str(), grid.width, grid.height,
+					static_cast<uint32_t>( it.second->NumSeeds() ), it.second->Bytes() / 1024.0 );
+				totalBytes += it.second->Bytes();
+			}
+			console.Print( "%u maps, %.1f KiB\n", static_cast<uint32_t>( dijkstraMaps.size() ), totalBytes / 1024.0 );
+		}
+
+	} // namespace ClientGame
+
+} // namespace XS
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <vector>
+
+#include "XSClient/XSClientPath.h"
+
+namespace XS {
+
+	namespace ClientGame {
+
+		// one-to-many query, route to whichever of goals is cheapest to reach from start
+		// A* towards the closest goal by octile distance, stops at the first goal taken off the open list
+		bool SearchNearest(
+			const Grid &grid,
+			Tile *start,
+			const nodeList &goals,
+			nodeList &route,
+			searchStats_t *stats
+		);
+
+		// a multi-source Dijkstra map, every tile knows its distance to the nearest seed and the neighbour to step to
+		//	to get there
+		// changes to seeds and walls are repaired incrementally, only the tiles whose nearest seed route went through
+		//	the change are recalculated
+		class DijkstraMap {
+		private:
+			struct open_t {
+				int32_t		distance;
+				uint32_t	index;
+
+				// ordered for a min-heap on distance
+				inline bool operator<( const open_t &rhs ) const {
+					return distance > rhs.distance;
+				}
+			};
+
+			Grid					grid;
+			std::vector<int32_t>	distance; // PATH_COST_INFINITE if no seed can be reached
+			std::vector<uint32_t>	next; // neighbour one step closer to the nearest seed
+			std::vector<uint8_t>	seed;
+			std::vector<open_t>		open;
+			std::vector<uint32_t>	invalid; // scratch space for Invalidate()
+			size_t					numSeeds;
+
+			// cheapest distance offered by a tile's passable neighbours
+			void Relax(
+				uint32_t index
+			);
+
+			// forget the distance of a tile and everything routed through it, then queue up the repairs
+			void Invalidate(
+				uint32_t index
+			);
+
+			// run Dijkstra outwards from the open list
+			void Propagate(
+				void
+			);
+
+		public:
+			// don't allow default instantiation
+			DijkstraMap() = delete;
+			DijkstraMap( const DijkstraMap& ) = delete;
+			DijkstraMap& operator=( const DijkstraMap& ) = delete;
+
+			DijkstraMap(
+				const Grid &grid
+			);
+
+			// the grid this map was built for
+			inline const Grid &GetGrid( void ) const {
+				return grid;
+			}
+
+			inline size_t NumSeeds( void ) const {
+				return numSeeds;
+			}
+
+			// approximate memory held by the map
+			size_t Bytes(
+				void
+			) const;
+
+			// recalculate every tile from the current seeds, e.g. after the whole grid was regenerated
+			void Rebuild(
+				void
+			);
+
+			void AddSeed(
+				Tile *tile
+			);
+
+			void RemoveSeed(
+				Tile *tile
+			);
+
+			void ClearSeeds(
+				void
+			);
+
+			// a tile became a wall or stopped being one
+			void TileChanged(
+				Tile *tile
+			);
+
+			// distance to the nearest seed, PATH_COST_INFINITE if none can be reached
+			int32_t Distance(
+				const Tile *tile
+			) const;
+
+			// the neighbour to step to, nullptr for seeds and unreachable tiles
+			Tile *Downhill(
+				const Tile *tile
+			) const;
+
+			// follow the map downhill from start to the nearest seed, returns false if no seed can be reached
+			bool Route(
+				Tile *start,
+				nodeList &route
+			) const;
+		};
+
+		// named maps stay resident until deleted, creating a map with an existing name replaces it
+		DijkstraMap *CreateDijkstraMap(
+			const char *name,
+			const Grid &grid
+		);
+
+		// returns nullptr if there is no map with that name
+		DijkstraMap *GetDijkstraMap(
+			const char *name
+		);
+
+		void DeleteDijkstraMap(
+			const char *name
+		);
+
+		void DeleteAllDijkstraMaps(
+			void
+		);
+
+		// notify every map built for this grid that a tile became a wall or stopped being one
+		void DijkstraMapsTileChanged(
+			const Grid &grid,
+			Tile *tile
+		);
+
+		// rebuild every map built for this grid, e.g. after the whole grid was regenerated
+		void RebuildDijkstraMaps(
+			const Grid &grid
+		);
+
+		// compare one A* per candidate goal against SearchNearest and a Dijkstra map seeded with every goal
+		//	pathnearest [width] [height] [goals] [wall percentage]
+		void Cmd_PathNearest(
+			const commandContext_t * const context
+		);
+
+		// list the resident maps
+		void Cmd_PathMaps(
+			const commandContext_t * const context
+		);
+
+	} // namespace ClientGame
+
+} // namespace XS
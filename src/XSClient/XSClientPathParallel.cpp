@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "XSCommon/XSCommon.h"
+#include "XSClient/XSClientPath.h"
+
+// hash-distributed A* for single long queries
+// every tile is owned by exactly one thread, chosen by hashing its index. a thread only ever touches the records
+//	of the tiles it owns, successors belonging to other threads are sent to their owner instead
+// references:
+//	Kishimoto, Fukunaga & Botea, "Scalable, parallel best-first search for optimal sequential planning" (2009)
+
+namespace XS {
+
+	namespace ClientGame {
+
+		#define HDA_NO_PARENT (UINT32_MAX)
+		#define HDA_BATCH_SIZE (64u)
+
+		struct hdaRecord_t {
+			int32_t		g;
+			uint32_t	parent;
+		};
+
+		struct hdaOpen_t {
+			int32_t		f, g;
+			uint32_t	index;
+
+			// ordered for a min-heap on f, preferring deeper nodes on ties
+			inline bool operator<( const hdaOpen_t &rhs ) const {
+				if ( f != rhs.f ) {
+					return f > rhs.f;
+				}
+				return g < rhs.g;
+			}
+		};
+
+		// a successor generated by another thread
+		struct hdaMessage_t {
+			uint32_t	index;
+			uint32_t	parent;
+			int32_t		g;
+		};
+
+		// messages are sent in batches to amortise the allocation and the atomic exchange
+		struct hdaBatch_t {
+			hdaBatch_t					*next;
+			std::vector<hdaMessage_t>	 messages;
+		};
+
+		// lock-free multiple-producer single-consumer queue
+		// producers push onto an intrusive stack, the consumer takes the whole stack at once. ordering between batches
+		//	doesn't matter as every message goes through the open list anyway
+		class MPSCQueue {
+		private:
+			std::atomic<hdaBatch_t *>	head;
+
+		public:
+			MPSCQueue() : head( nullptr ) {}
+
+			// the queue does not own anything left in it
+			~MPSCQueue() {}
+
+			void Push( hdaBatch_t *batch ) {
+				batch->next = head.load( std::memory_order_relaxed );
+				while ( !head.compare_exchange_weak( batch->next, batch, std::memory_order_release,
+					std::memory_order_relaxed ) )
+				{
+					// batch->next was refreshed by the failed exchange
+				}
+			}
+
+			bool Empty( void ) const {
+				return head.load( std::memory_order_acquire ) == nullptr;
+			}
+
+			// returns every batch pushed so far, or nullptr
+			hdaBatch_t *PopAll( void ) {
+				if ( !head.load( std::memory_order_relaxed ) ) {
+					return nullptr;
+				}
+				return head.exchange( nullptr, std::memory_order_acquire );
+			}
+		};
+
+		struct hdaWorker_t {
+			MPSCQueue					 inbox;
+			std::vector<hdaOpen_t>		 open;
+			std::vector<hdaBatch_t *>	 outgoing; // one pending batch per destination
+			uint32_t					 expanded;
+			size_t						 peakOpen;
+			size_t						 peakRecords;
+			size_t						 numRecords;
+		};
+
+		bool SearchHDAStar( const Grid &grid, Tile *start, Tile *goal, nodeList &route, searchStats_t *stats,
+			uint32_t numThreads )
+		{
+			numThreads = std::max( numThreads, 1u );
+
+			// records are shared, but each element is only accessed by the thread that owns it
+			std::vector<hdaRecord_t> records( grid.Size(), { PATH_COST_INFINITE, HDA_NO_PARENT } );
+			std::vector<hdaWorker_t> workers( numThreads );
+
+			const uint32_t startIndex = grid.Index( start );
+			const uint32_t goalIndex = grid.Index( goal );
+
+			// cost of the best route found so far
+			std::atomic<int32_t> incumbent( PATH_COST_INFINITE );
+
+			// one unit per active thread and per message batch in flight
+			// units are only created by something already holding one, so the search is finished once it reaches 0
+			std::atomic<int64_t> work( numThreads );
+
+			auto Owner = [numThreads]( uint32_t index ) -> uint32_t {
+				const uint64_t hash = static_cast<uint64_t>( index ) * 0x9E3779B97F4A7C15ull;
+				return static_cast<uint32_t>( (hash >> 32) % numThreads );
+			};
+
+			for ( auto &worker : workers ) {
+				worker.outgoing.assign( numThreads, nullptr );
+				worker.expanded = 0u;
+				worker.peakOpen = 0u;
+				worker.peakRecords = 0u;
+				worker.numRecords = 0u;
+			}
+
+			auto Flush = [&]( hdaWorker_t &self, uint32_t destination ) {
+				hdaBatch_t *&batch = self.outgoing[destination];
+				if ( batch ) {
+					work.fetch_add( 1, std::memory_order_relaxed );
+					workers[destination].inbox.Push( batch );
+					batch = nullptr;
+				}
+			};
+
+			auto Send = [&]( hdaWorker_t &self, const hdaMessage_t &message ) {
+				const uint32_t destination = Owner( message.index );
+				hdaBatch_t *&batch = self.outgoing[destination];
+				if ( !batch ) {
+					batch = new hdaBatch_t;
+					batch->messages.reserve( HDA_BATCH_SIZE );
+				}
+				batch->messages.push_back( message );
+				if ( batch->messages.size() >= HDA_BATCH_SIZE ) {
+					Flush( self, destination );
+				}
+			};
+
+			// a successor reached this tile, only called by the tile's owner
+			auto Receive = [&]( hdaWorker_t &self, const hdaMessage_t &message ) {
+				hdaRecord_t &record = records[message.index];
+				if ( message.g >= record.g ) {
+					return;
+				}
+				if ( record.g == PATH_COST_INFINITE ) {
+					self.numRecords++;
+					self.peakRecords = std::max( self.peakRecords, self.numRecords );
+				}
+				record.g = message.g;
+				record.parent = message.parent;
+
+				if ( message.index == goalIndex ) {
+					// the goal is never expanded, it only lowers the bound
+					int32_t best = incumbent.load( std::memory_order_relaxed );
+					while ( message.g < best && !incumbent.compare_exchange_weak( best, message.g ) ) {
+						// best was refreshed by the failed exchange
+					}
+					return;
+				}
+
+				const int32_t f = message.g + OctileDistance( &grid.tiles[message.index], goal );
+				if ( f >= incumbent.load( std::memory_order_relaxed ) ) {
+					return;
+				}
+				self.open.push_back( { f, message.g, message.index } );
+				std::push_heap( self.open.begin(), self.open.end() );
+				self.peakOpen = std::max( self.peakOpen, self.open.size() );
+			};
+
+			// returns true if anything was received
+			auto Drain = [&]( hdaWorker_t &self ) -> bool {
+				hdaBatch_t *batch = self.inbox.PopAll();
+				if ( !batch ) {
+					return false;
+				}
+				int64_t batches = 0;
+				while ( batch ) {
+					for ( const auto &message : batch->messages ) {
+						Receive( self, message );
+					}
+					hdaBatch_t *next = batch->next;
+					delete batch;
+					batch = next;
+					batches++;
+				}
+				// the batches' units are handed over to this thread, which is active
+				work.fetch_sub( batches, std::memory_order_acq_rel );
+				return true;
+			};
+
+			auto Run = [&]( uint32_t id ) {
+				hdaWorker_t &self = workers[id];
+				bool active = true;
+
+				while ( true ) {
+					if ( !active ) {
+						if ( self.inbox.Empty() ) {
+							if ( work.load( std::memory_order_acquire ) == 0 ) {
+								break;
+							}
+							std::this_thread::yield();
+							continue;
+						}
+						// claim a unit before taking any messages so the total can't touch 0 in between
+						work.fetch_add( 1, std::memory_order_acq_rel );
+						active = true;
+					}
+
+					Drain( self );
+
+					const int32_t bound = incumbent.load( std::memory_order_relaxed );
+					bool expanded = false;
+					while ( !self.open.empty() ) {
+						std::pop_heap( self.open.begin(), self.open.end() );
+						const hdaOpen_t current = self.open.back();
+						self.open.pop_back();
+
+						// stale entry, or it can't improve on the incumbent
+						if ( current.g != records[current.index].g ) {
+							continue;
+						}
+						if ( current.f >= bound ) {
+							// nothing left in this open list can either
+							self.open.clear();
+							break;
+						}
+
+						self.expanded++;
+						expanded = true;
+						const Tile *tile = &grid.tiles[current.index];
+						for ( int32_t dir = 0; dir < NUM_DIRECTIONS; dir++ ) {
+							const Tile *neighbour = tile->neighbours[dir];
+							if ( !neighbour || neighbour->type == TileType::Wall ) {
+								continue;
+							}
+
+							const hdaMessage_t message = {
+								static_cast<uint32_t>( grid.Index( neighbour ) ),
+								current.index,
+								current.g + tile->cost[dir]
+							};
+							if ( Owner( message.index ) == id ) {
+								Receive( self, message );
+							}
+							else {
+								Send( self, message );
+							}
+						}
+						break;
+					}
+
+					if ( expanded ) {
+						continue;
+					}
+
+					// out of local work, make sure everything generated so far is on its way before going idle
+					for ( uint32_t destination = 0u; destination < numThreads; destination++ ) {
+						Flush( self, destination );
+					}
+					if ( Drain( self ) ) {
+						continue;
+					}
+					active = false;
+					work.fetch_sub( 1, std::memory_order_acq_rel );
+				}
+			};
+
+			// seed the search through the start tile's owner
+			{
+				hdaBatch_t *batch = new hdaBatch_t;
+				batch->messages.push_back( { startIndex, HDA_NO_PARENT, 0 } );
+				work.fetch_add( 1, std::memory_order_relaxed );
+				workers[Owner( startIndex )].inbox.Push( batch );
+			}
+
+			if ( start == goal ) {
+				incumbent = 0;
+				records[startIndex].g = 0;
+			}
+			else {
+				std::vector<std::thread> threads;
+				for ( uint32_t id = 1u; id < numThreads; id++ ) {
+					threads.push_back( std::thread( Run, id ) );
+				}
+				Run( 0u );
+				for ( auto &thread : threads ) {
+					thread.join();
+				}
+			}
+
+			// nothing can be left in flight, but the seed may have been skipped
+			for ( auto &worker : workers ) {
+				for ( hdaBatch_t *batch = worker.inbox.PopAll(); batch; ) {
+					hdaBatch_t *next = batch->next;
+					delete batch;
+					batch = next;
+				}
+			}
+
+			size_t peakOpen = 0u, peakRecords = 0u;
+			for ( const auto &worker : workers ) {
+				stats->expanded += worker.expanded;
+				peakOpen += worker.peakOpen;
+				peakRecords += worker.peakRecords;
+			}
+			stats->iterations = numThreads;
+			stats->peakNodes = peakRecords + peakOpen;
+			stats->peakBytes = (records.size() * sizeof(hdaRecord_t)) + (peakOpen * sizeof(hdaOpen_t));
+
+			if ( incumbent == PATH_COST_INFINITE ) {
+				return false;
+			}
+
+			stats->cost = records[goalIndex].g;
+			for ( uint32_t index = goalIndex; index != HDA_NO_PARENT; index = records[index].parent ) {
+				route.push_back( &grid.tiles[index] );
+			}
+			std::reverse( route.begin(), route.end() );
+
+			return true;
+		}
+
+	} // namespace ClientGame
+
+} // namespace XS
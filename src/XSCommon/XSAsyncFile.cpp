@@ -0,0 +1,47 @@
+#include "XSCommon/XSCommon.h"
+#include "XSCommon/XSAsyncFile.h"
+#include "XSCommon/XSFile.h"
+#include "XSCommon/XSJob.h"
+#include "XSCommon/XSTimeline.h"
+
+namespace XS {
+
+	AsyncFile::AsyncFile( const char *gamePath )
+	: gamePath( gamePath ), open( false ), ready( false ), job( nullptr )
+	{
+		AsyncFile *self = this;
+		job = Job::Create( Read, &self, sizeof(self) );
+		Job::Run( job );
+	}
+
+	AsyncFile::~AsyncFile() {
+		// once the job system has shut down every read has either finished or been dropped
+		if ( !IsReady() && Job::GetNumThreads() ) {
+			Job::Wait( job );
+		}
+	}
+
+	void AsyncFile::Read( Job::job_t *job, const void *data ) {
+		AsyncFile *file = *static_cast<AsyncFile * const *>( data );
+		Timeline::Span span( file->gamePath.c_str() );
+
+		const File f( file->gamePath.c_str(), FileMode::READ_BINARY );
+		if ( f.open ) {
+			file->contents.resize( f.length );
+			f.Read( file->contents.data() );
+			file->open = true;
+		}
+
+		file->ready.store( true, std::memory_order_release );
+	}
+
+	bool AsyncFile::Wait( void ) {
+		// the job can't have been reused before it's finished, and it's still running if it isn't ready
+		if ( !IsReady() ) {
+			Job::Wait( job );
+		}
+
+		return open;
+	}
+
+} // namespace XS
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace XS {
+
+	namespace Job {
+		struct job_t;
+	} // namespace Job
+
+	// a whole file read into memory on a worker thread, so reading overlaps with whatever the creator does meanwhile
+	// the read is queued as soon as it's created, and it must be waited on by the thread that created it
+	class AsyncFile {
+	private:
+		std::string				gamePath;
+		std::vector<uint8_t>	contents;
+		bool					open;
+		std::atomic<bool>		ready; // open and contents have been written
+		Job::job_t				*job;
+
+		static void Read(
+			Job::job_t *job,
+			const void *data
+		);
+
+	public:
+		// don't allow default instantiation
+		AsyncFile() = delete;
+		AsyncFile( const AsyncFile& ) = delete;
+		AsyncFile& operator=( const AsyncFile& ) = delete;
+
+		// queue a file to be read in binary mode
+		AsyncFile(
+			const char *gamePath
+		);
+
+		// waits for the read if it's still going
+		~AsyncFile();
+
+		// the read has finished, so Wait won't block
+		inline bool IsReady( void ) const {
+			return ready.load( std::memory_order_acquire );
+		}
+
+		// run jobs until the file has been read, returns false if it couldn't be opened
+		bool Wait(
+			void
+		);
+
+		// the file's contents, only valid once Wait has returned true
+		// not null-terminated, they can be moved out with swap
+		inline std::vector<uint8_t> &GetContents( void ) {
+			return contents;
+		}
+
+		inline const char *GetPath( void ) const {
+			return gamePath.c_str();
+		}
+	};
+
+} // namespace XS
@@ -14,8 +14,10 @@ namespace XS {
 		// commands
 		static std::unordered_map<std::string, commandFunc_t> commands;
 
-		// command buffer
-		static std::vector<std::string> buffer;
+		// command buffer, one command per line
+		static std::string buffer;
+		static String::Tokenizer tokenizer;
+		static std::string lookupName; // reused so looking up a command doesn't allocate
 
 		static void Cmd_ListCvars( const commandContext_t * const context ) {
 			Cvar::List();
@@ -28,7 +30,7 @@ namespace XS {
 			}
 
 			for ( const auto &it : *context ) {
-				const Cvar *cv = Cvar::Get( it );
+				const Cvar *cv = Cvar::Get( it.c_str() );
 				if ( cv ) {
 					console.Print( "%s: \"%s\"\n", it.c_str(), cv->GetFullCString() );
 				}
@@ -44,12 +46,17 @@ namespace XS {
 				return;
 			}
 
-			Cvar *cv = Cvar::Create( (*context)[0] );
+			Cvar *cv = Cvar::Get( (*context)[0].c_str() );
+			if ( !cv ) {
+				cv = Cvar::Create( (*context)[0].c_str() );
+			}
 
+			// reused, scripts can set a lot of cvars
+			static std::string value;
+			value.clear();
 			size_t size = context->size();
-			std::string value;
 			for ( size_t i = 1; i < size; i++ ) {
-				value += (*context)[i];
+				value.append( (*context)[i].text, (*context)[i].length );
 				if ( i != size - 1 ) {
 					value += " ";
 				}
@@ -58,7 +65,7 @@ namespace XS {
 		}
 
 		static void Cmd_ToggleCvar( const commandContext_t * const context ) {
-			Cvar *cv = Cvar::Get( (*context)[0] );
+			Cvar *cv = Cvar::Get( (*context)[0].c_str() );
 
 			cv->Set( !cv->GetBool() );
 		}
@@ -81,37 +88,41 @@ namespace XS {
 		// command buffer
 
 		void Append( const char *str, char delimiter ) {
-			std::vector<std::string> commands = String::Split( str, delimiter );
-			for ( const auto &command : commands ) {
-				buffer.push_back( command );
+			// store every command on its own line, whichever delimiter separated them
+			bool quoted = false;
+			for ( const char *p = str; *p; p++ ) {
+				if ( *p == '\n' ) {
+					// an unterminated quote doesn't run on to the next line
+					quoted = false;
+				}
+				else if ( *p == '"' ) {
+					quoted = !quoted;
+				}
+				buffer += (!quoted && *p == delimiter) ? '\n' : *p;
 			}
+			buffer += '\n';
 		}
 
 		void ExecuteBuffer( void ) {
-			for ( const auto &it : buffer ) {
-				commandContext_t context;
-
-				// tokenise the arguments
-				const char delim = ' ';
-				size_t start = it.find( delim );
-				std::string name = it.substr( 0, start );
-
-				if ( start != std::string::npos && start != it.size() - 1 ) {
-					context = String::Split( &it[start + 1], ' ' );
-
-					// strip any quotes around the arguments
-					for ( auto &tok : context ) {
-						tok.erase( std::remove( tok.begin(), tok.end(), '"' ), tok.end() );
-					}
+			// a command may append more commands, so the buffer is indexed rather than iterated
+			size_t offset = 0u;
+			while ( offset < buffer.size() ) {
+				const char *start = buffer.c_str() + offset;
+				const char *next = tokenizer.Tokenize( start, buffer.c_str() + buffer.size() );
+				offset = next - buffer.c_str();
+
+				if ( tokenizer.empty() ) {
+					continue;
 				}
 
-				const commandFunc_t &func = commands[name];
-				if ( func ) {
-					func( &context );
-					continue;
+				lookupName.assign( tokenizer[0].text, tokenizer[0].length );
+				const auto it = commands.find( lookupName );
+				if ( it != commands.end() && it->second ) {
+					const commandContext_t context( tokenizer.begin() + 1, tokenizer.size() - 1 );
+					it->second( &context );
 				}
 				else {
-					console.Print( "Unknown command \"%s\"\n", it.c_str()  );
+					console.Print( "Unknown command \"%s\"\n", tokenizer[0].text );
 				}
 			}
 			buffer.clear();
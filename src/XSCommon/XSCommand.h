@@ -1,11 +1,35 @@
 #pragma once
 
-#include <vector>
-#include <string>
+#include "XSCommon/XSString.h"
 
 namespace XS {
 
-	typedef std::vector<std::string> commandContext_t;
+	// the arguments a command was called with, not including the command's name
+	// they point into the command buffer's tokenizer, so they're only valid until the command returns
+	class commandContext_t {
+	private:
+		const String::token_t	*args;
+		size_t					 numArgs;
+
+	public:
+		commandContext_t( const String::token_t *args, size_t numArgs )
+		: args( args ), numArgs( numArgs )
+		{
+		}
+
+		inline size_t size( void ) const {
+			return numArgs;
+		}
+		inline const String::token_t &operator[]( size_t index ) const {
+			return args[index];
+		}
+		inline const String::token_t *begin( void ) const {
+			return args;
+		}
+		inline const String::token_t *end( void ) const {
+			return args + numArgs;
+		}
+	};
 
 	namespace Command {
 
@@ -23,6 +47,7 @@ namespace XS {
 		);
 
 		// append text to the command buffer to be executed in a batch
+		// commands are separated by the delimiter or a linefeed, a delimiter in double quotes doesn't count
 		void Append(
 			const char *str,
 			char delimiter = ';'
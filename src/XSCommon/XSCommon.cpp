@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <SDL2/SDL_timer.h>
 #include <SDL2/SDL.h>
 
@@ -8,6 +10,11 @@
 #include "XSCommon/XSEvent.h"
 #include "XSCommon/XSError.h"
 #include "XSCommon/XSFile.h"
+#include "XSCommon/XSFrameArena.h"
+#include "XSCommon/XSFramePacer.h"
+#include "XSCommon/XSJob.h"
+#include "XSCommon/XSMessageBuffer.h"
+#include "XSCommon/XSTimeline.h"
 #include "XSCommon/XSTimer.h"
 #include "XSCommon/XSString.h"
 #include "XSCommon/XSGlobals.h"
@@ -25,6 +32,7 @@ namespace XS {
 		Cvar *com_developer;
 		static Cvar *com_framerate;
 		static Cvar *r_framerate;
+		static Cvar *in_pollRate;
 
 		static void RegisterCvars( void ) {
 			Cvar::Create( "com_date", __DATE__, "Compilation date", CVAR_READONLY );
@@ -35,6 +43,8 @@ namespace XS {
 		#endif // _DEBUG
 			com_framerate = Cvar::Create( "com_framerate", "50", "Game tick rate", CVAR_NONE );
 			r_framerate = Cvar::Create( "r_framerate", "120", "Render framerate", CVAR_NONE );
+			in_pollRate = Cvar::Create( "in_pollRate", "1000", "Times per second input is polled between frames",
+				CVAR_ARCHIVE );
 		}
 
 		static void ParseCommandLine( int32_t argc, char **argv ) {
@@ -72,8 +82,12 @@ namespace XS {
 
 			console.DebugPrint( "Startup parameters:\n" );
 			Indent indent( 1 );
-			for ( const auto &arg : String::Split( &commandLine[start + 1], delimiter ) ) {
-				console.DebugPrint( "%s\n", arg.c_str() );
+			for ( size_t begin = start + 1, end; begin < commandLine.size(); begin = end + 1 ) {
+				end = commandLine.find( delimiter, begin );
+				if ( end == std::string::npos ) {
+					end = commandLine.size();
+				}
+				console.DebugPrint( "%.*s\n", static_cast<int>( end - begin ), &commandLine[begin] );
 			}
 		}
 
@@ -86,12 +100,9 @@ namespace XS {
 					f.Read( reinterpret_cast<uint8_t *>(buffer) );
 
 					Command::ExecuteBuffer(); // flush buffer before we issue commands
-					char *current = strtok( buffer, "\n" );
-					while ( current ) {
-						Command::Append( current );
-						Command::ExecuteBuffer();
-						current = strtok( nullptr, "\n" );
-					}
+					// every line is its own command, so the whole file can be queued and run in one pass
+					Command::Append( buffer );
+					Command::ExecuteBuffer();
 				delete[] buffer;
 			}
 		}
@@ -124,7 +135,58 @@ namespace XS {
 			WriteConfig( cfg );
 		}
 
+		// format lines the way the console does and report how many it could print a second
+		// the log is written to cache/printbench.log rather than flooding the console
+		//	printbench [lines]
+		static void Cmd_PrintBench( const commandContext_t * const context ) {
+			const uint32_t numLines = context->size()
+				? static_cast<uint32_t>( std::max( atoi( (*context)[0].c_str() ), 1 ) )
+				: 100000u;
+			const char *fmt = "frameTime %.5f < %.5f, delaying for %0i\n";
+
+			console.Print( "Print benchmark: %u lines\n", numLines );
+			Indent indent( 1 );
+
+			// sum the lengths so the formatting can't be optimised away
+			size_t length = 0u;
+			Timer timer;
+			for ( uint32_t i = 0u; i < numLines; i++ ) {
+				const std::string line = String::Format( fmt, i * 0.001, 8.333, i & 7u );
+				length += line.length();
+			}
+			const real64_t formatMsec = timer.GetTiming( true, Timer::Resolution::MILLISECONDS );
+
+			for ( uint32_t i = 0u; i < numLines; i++ ) {
+				length += strlen( String::FormatTemp( fmt, i * 0.001, 8.333, i & 7u ) );
+			}
+			const real64_t tempMsec = timer.GetTiming( true, Timer::Resolution::MILLISECONDS );
+
+			real64_t appendMsec, flushMsec;
+			{
+				MessageBuffer buffer( "cache/printbench.log" );
+				timer.GetTiming( true );
+				for ( uint32_t i = 0u; i < numLines; i++ ) {
+					const char *line = String::FormatTemp( fmt, i * 0.001, 8.333, i & 7u );
+					buffer.Append( line, static_cast<uint32_t>( strlen( line ) ) );
+				}
+				appendMsec = timer.GetTiming( true, Timer::Resolution::MILLISECONDS );
+				buffer.FlushLog();
+				flushMsec = timer.GetTiming( true, Timer::Resolution::MILLISECONDS );
+			}
+
+			auto Report = [numLines]( const char *method, real64_t msec ) {
+				console.Print( "%-12s %10.3f %14.0f\n", method, msec, numLines / (msec / 1000.0) );
+			};
+			console.Print( "%-12s %10s %14s\n", "method", "total ms", "lines/sec" );
+			Report( "Format", formatMsec );
+			Report( "FormatTemp", tempMsec );
+			Report( "Append", appendMsec );
+			console.Print( "log writer caught up %.3f ms after the last append (%.1f KiB formatted)\n", flushMsec,
+				length / 1024.0 );
+		}
+
 		Timer *gameTimer = nullptr;
+		FramePacer *framePacer = nullptr;
 
 	} // namespace Common
 
@@ -141,6 +203,8 @@ int main( int argc, char **argv ) {
 		XS::Common::RegisterCvars();
 		XS::Command::Init(); // register commands like exec, vstr
 		XS::Command::AddCommand( "writeconfig", XS::Common::Cmd_WriteConfig );
+		XS::Command::AddCommand( "printbench", XS::Common::Cmd_PrintBench );
+		XS::Timeline::Init();
 		XS::Common::ParseCommandLine( argc, argv );
 
 		// execute the command line args, so config can be loaded from an overridden base path
@@ -154,7 +218,11 @@ int main( int argc, char **argv ) {
 
 		XS::console.Print( WINDOW_TITLE " (" XSTR( ARCH_WIDTH ) " bits) built on " __DATE__ " [git " REVISION "]\n" );
 
-		XS::Renderer::Init();
+		XS::Job::Init();
+		{
+			XS::Timeline::Span span( "renderer" );
+			XS::Renderer::Init();
+		}
 		XS::Event::Init();
 
 		if ( XS::Common::com_developer->GetBool() ) {
@@ -162,53 +230,82 @@ int main( int argc, char **argv ) {
 			XS::console.DebugPrint( "Init time: %.0f milliseconds\n", t );
 		}
 
-		XS::Client::Init();
+		{
+			XS::Timeline::Span span( "client" );
+			XS::Client::Init();
+		}
 
 		// post-init stuff
 		XS::Cvar::initialised = true;
 
 		// frame
 		XS::Common::gameTimer = new XS::Timer();
+		XS::Common::framePacer = new XS::FramePacer();
 		while ( 1 ) {
-			static double currentTime = XS::Common::gameTimer->GetTiming( false, XS::Timer::Resolution::MILLISECONDS );
-			static double accumulator = 0.0;
+			// times are kept in integer nanoseconds so nothing drifts however long we run
+			static uint64_t currentTime = XS::Common::gameTimer->GetElapsed();
+			static uint64_t accumulator = 0u;
 
 			// calculate delta time for integrating this frame
-			const double newTime = XS::Common::gameTimer->GetTiming( false, XS::Timer::Resolution::MILLISECONDS );
-			const double dt = 1000.0 / XS::Common::com_framerate->GetDouble();
-			const double frameTime = newTime - currentTime;
+			const uint64_t newTime = XS::Common::gameTimer->GetElapsed();
+			const uint64_t dt = static_cast<uint64_t>( 1000000000.0 / XS::Common::com_framerate->GetDouble() );
+			const uint64_t frameTime = newTime - currentTime;
 			currentTime = newTime;
 
-			double sliceMsec = frameTime;
-			if ( sliceMsec > 250.0 ) {
-				sliceMsec = 250.0; // avoid spiral of death, maximum 250mspf
+			// nothing is drawn headless, so ticks run back to back as fast as they'll go rather than keeping up with
+			//	the clock, e.g. for throughput tests
+			if ( XS::Renderer::IsHeadless() ) {
+				XS::Renderer::BeginFrame();
+				XS::Client::input.Poll();
+				XS::Job::RunMainThreadJobs();
+				XS::console.buffer->Pump();
+				XS::Event::Pump( newTime );
+				XS::Command::ExecuteBuffer();
+				XS::Client::RunFrame( dt * 0.000001 );
+				XS::Renderer::Update();
+				XS::FrameArena::EndFrame();
+				continue;
 			}
-			accumulator += sliceMsec;
+
+			// avoid spiral of death, maximum 250mspf
+			accumulator += std::min<uint64_t>( frameTime, 250000000u );
+
+			XS::Renderer::BeginFrame();
 
 			// input
 			XS::Client::input.Poll();
 
-			// event pump
-			XS::Event::Pump();
-			XS::Command::ExecuteBuffer();
+			// finish off anything the workers handed back to the main thread, and show what they printed
+			XS::Job::RunMainThreadJobs();
+			XS::console.buffer->Pump();
 
+			// each tick runs the events and commands from before the time it simulates up to, so they apply on the
+			//	tick they happened in whatever the render rate is
+			uint64_t tickTime = newTime - accumulator;
 			while ( accumulator >= dt ) {
-				XS::Client::RunFrame( dt );
+				tickTime += dt;
+				XS::Event::Pump( tickTime );
+				XS::Command::ExecuteBuffer();
+				XS::Client::RunFrame( dt * 0.000001 );
 				accumulator -= dt;
 			}
 
-			// alpha = accumulator / dt;
-			// lerp( previousState, alpha, currentState )
-			XS::Client::DrawFrame( frameTime );
+			// the leftover time is drawn by interpolating within the last tick's snapshot
+			const double alpha = static_cast<double>( accumulator ) / dt;
+			XS::Client::DrawFrame( frameTime * 0.000001, alpha );
 			XS::Renderer::Update( /*state*/ );
+			XS::FrameArena::EndFrame();
 
+			// keep polling input while we wait, so events are stamped close to when they happened rather than when
+			//	the next frame starts
 			const double frameRate = XS::Common::r_framerate->GetDouble();
-			const double renderMsec = 1000.0 / frameRate;
-			if ( frameTime < renderMsec ) {
-				XS::console.DebugPrint( "frameTime %.5f < %.5f, delaying for %0i\n", frameTime, renderMsec,
-					(uint32_t)(renderMsec - frameTime) );
-				SDL_Delay( (uint32_t)(renderMsec - frameTime) );
-			}
+			const uint64_t renderNsec = (frameRate > 0.0) ? static_cast<uint64_t>( 1000000000.0 / frameRate ) : 0u;
+			const uint64_t pollNsec = static_cast<uint64_t>(
+				1000000000.0 / std::max( XS::Common::in_pollRate->GetDouble(), 1.0 )
+			);
+			XS::Common::framePacer->Wait( renderNsec, pollNsec, [] {
+				XS::Client::input.Poll();
+			} );
 		}
 	}
 	catch( const XS::XSError &e ) {
@@ -224,6 +321,10 @@ int main( int argc, char **argv ) {
 		// indent the console for this scope
 		{
 			XS::Indent indent( 1 );
+			// the client releases render resources, so it needs the render context
+			XS::Renderer::JoinRenderThread();
+			// no job can be left running when what it works on is released
+			XS::Job::Shutdown();
 			XS::Client::Shutdown();
 			XS::Renderer::Shutdown();
 
@@ -238,6 +339,9 @@ int main( int argc, char **argv ) {
 			XS::console.DebugPrint( "Shutdown time: %.3f seconds\n\n\n", shutdownTIme );
 		}
 
+		// the log is written from another thread, make sure it's all out before we go
+		XS::console.buffer->FlushLog();
+
 		return EXIT_SUCCESS;
 	}
 
@@ -1,7 +1,8 @@
-#include <iostream>
+#include <algorithm>
 
 #include "XSCommon/XSCommon.h"
 #include "XSCommon/XSConsole.h"
+#include "XSCommon/XSFrameArena.h"
 #include "XSCommon/XSString.h"
 #include "XSCommon/XSMessageBuffer.h"
 
@@ -17,96 +18,64 @@
 namespace XS {
 
 	Console console = {};
+	thread_local int32_t Console::indentation = 0;
 
 	Console::Console()
-	: indentation( 0u )
 	{
-		buffer = new MessageBuffer( "console.log" );
+		// stdout is written along with the log, off the printing thread
+		buffer = new MessageBuffer( "console.log", true );
 	}
 
-	void Console::Print( const char *fmt, ... ) {
-		size_t size = 128;
-		std::string str;
-		va_list ap;
-
-		while ( 1 ) {
-			str.resize( size );
-
-			va_start( ap, fmt );
-			int n = vsnprintf( (char *)str.c_str(), size, fmt, ap );
-			va_end( ap );
-
-			if ( n > -1 && n < (signed)size ) {
-				str.resize( n );
-				break;
-			}
-			if ( n > -1 ) {
-				size = n + 1;
-			}
-			else {
-				size *= 1.5;
-			}
+	void Console::PrintV( const char *fmt, va_list ap ) {
+		// the indentation and message are formatted together into a thread-local buffer, falling back to the frame
+		//	arena for long messages, so printing doesn't allocate
+		static thread_local char local[CONSOLE_PRINT_SIZE];
+		const size_t indent = std::min( static_cast<size_t>( std::max( indentation, 0 ) ) * 2u,
+			static_cast<size_t>( CONSOLE_PRINT_SIZE / 2u ) );
+
+		char *out = local;
+		std::memset( out, ' ', indent );
+
+		va_list retry;
+		va_copy( retry, ap );
+		int n = vsnprintf( out + indent, CONSOLE_PRINT_SIZE - indent, fmt, ap );
+		if ( n < 0 ) {
+			out[indent] = '\0';
+			n = 0;
 		}
-
-		//FIXME: care about printing twice on same line
-		std::string finalOut = "";
-		for ( uint32_t i = 0; i < indentation; i++ ) {
-			finalOut += "  ";
+		else if ( indent + n >= CONSOLE_PRINT_SIZE ) {
+			out = static_cast<char *>( FrameArena::Allocate( indent + n + 1 ) );
+			std::memset( out, ' ', indent );
+			vsnprintf( out + indent, n + 1, fmt, retry );
 		}
-		finalOut += str;
+		va_end( retry );
 
+		//FIXME: care about printing twice on same line
 		//TODO: strip colours?
-		std::cout << finalOut;
-		buffer->Append( finalOut );
+		buffer->Append( out, static_cast<uint32_t>( indent + n ) );
 
 	#if defined(XS_OS_WINDOWS) && defined(_DEBUG)
-		if ( !finalOut.empty() ) {
-			OutputDebugString( finalOut.c_str() );
+		if ( out[0] ) {
+			OutputDebugString( out );
 		}
 	#endif
 	}
 
-	void Console::DebugPrint( const char *fmt, ... ) {
-	#if defined(_DEBUG)
-		size_t size = 128;
-		std::string str;
+	void Console::Print( const char *fmt, ... ) {
 		va_list ap;
 
-		while ( 1 ) {
-			str.resize( size );
-
-			va_start( ap, fmt );
-			int n = vsnprintf( (char *)str.c_str(), size, fmt, ap );
-			va_end( ap );
-
-			if ( n > -1 && n < (signed)size ) {
-				str.resize( n );
-				break;
-			}
-			if ( n > -1 ) {
-				size = n + 1;
-			}
-			else {
-				size *= 1.5;
-			}
-		}
-
-		//FIXME: care about printing twice on same line
-		std::string finalOut = "";
-		for ( uint32_t i = 0; i < indentation; i++ ) {
-			finalOut += "  ";
-		}
-		finalOut += str;
+		va_start( ap, fmt );
+		PrintV( fmt, ap );
+		va_end( ap );
+	}
 
-		//TODO: strip colours?
-		std::cout << finalOut;
-		buffer->Append( finalOut );
+	void Console::DebugPrint( const char *fmt, ... ) {
+	#if defined(_DEBUG)
+		va_list ap;
 
-	#if defined(XS_OS_WINDOWS)
-		if ( !finalOut.empty() ) {
-			OutputDebugString( finalOut.c_str() );
-		}
-	#endif // XS_OS_WINDOWS
+		va_start( ap, fmt );
+		PrintV( fmt, ap );
+		va_end( ap );
 	#endif // _DEBUG
 	}
 
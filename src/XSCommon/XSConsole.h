@@ -3,9 +3,12 @@
 #include "XSCommon/XSMessageBuffer.h"
 namespace XS {
 
+	#define CONSOLE_PRINT_SIZE (1024u) // longer messages are formatted into the frame arena
+
+	// any thread can print, see MessageBuffer
 	extern struct Console {
-		int32_t			indentation;
-		MessageBuffer	*buffer;
+		static thread_local int32_t	indentation; // each thread indents its own prints
+		MessageBuffer				*buffer;
 
 		Console();
 		inline ~Console() {
@@ -31,6 +34,12 @@ namespace XS {
 		);
 
 	private:
+		// format and append a message, with the current indentation
+		void PrintV(
+			const char *fmt,
+			va_list ap
+		);
+
 		// used internally
 		// append a line to the list, accounting for split lines
 		void Append(
@@ -1,5 +1,6 @@
 #include <unordered_map>
 #include <map>
+#include <mutex>
 
 #include "XSCommon/XSCommon.h"
 #include "XSCommon/XSGlobals.h"
@@ -27,7 +28,7 @@ namespace XS {
 				continue;
 			}
 			if ( (cv->flags & CVAR_ARCHIVE) && cv->modified && cv->fullString != cv->defaultStr ) {
-				str += String::Format( "set %s \"%s\"\n", name, cv->fullString.c_str() );
+				str += String::FormatTemp( "set %s \"%s\"\n", name, cv->fullString.c_str() );
 			}
 		}
 	}
@@ -41,16 +42,18 @@ namespace XS {
 	}
 
 	// private
-	Cvar::Cvar() {
+	Cvar::Cvar()
+	: parsed( false ), modified( false ), modificationCount( 0u ), nextCallbackId( 0u )
+	{
 		cvars[name] = this;
 
 		SetFlags( CVAR_NONE );
-		modified = false;
 	}
 
 	// private
 	Cvar::Cvar( const std::string &name, const std::string &value, const std::string &description, uint32_t flags )
-	: name( name ), defaultStr( value ), description( description ), modified( false )
+	: name( name ), defaultStr( value ), description( description ), parsed( false ), modified( false ),
+		modificationCount( 0u ), nextCallbackId( 0u )
 	{
 		cvars[name] = this;
 		SetFlags( flags );
@@ -59,7 +62,8 @@ namespace XS {
 
 	// public
 	Cvar *Cvar::Create( std::string name, std::string value, std::string description, uint32_t flags ) {
-		Cvar *cvar = cvars[name];
+		const auto it = cvars.find( name );
+		Cvar *cvar = (it != cvars.end()) ? it->second : nullptr;
 		if ( initialised ) {
 			flags &= ~CVAR_INIT;
 		}
@@ -93,10 +97,10 @@ namespace XS {
 	}
 
 	Cvar *Cvar::Get( const std::string &name ) {
-		Cvar *cv = cvars[name];
-
-		if ( cv ) {
-			return cv;
+		// don't use operator[], it would add an entry for every name that's looked up
+		const auto it = cvars.find( name );
+		if ( it != cvars.end() ) {
+			return it->second;
 		}
 
 		return nullptr;
@@ -132,51 +136,86 @@ namespace XS {
 		this->flags = flags;
 	}
 
+	uint32_t Cvar::AddCallback( const cvarCallback_t &callback ) {
+		const callback_t entry = { nextCallbackId++, callback };
+		callbacks.push_back( entry );
+		return entry.id;
+	}
+
+	void Cvar::RemoveCallback( uint32_t id ) {
+		for ( auto it = callbacks.begin(); it != callbacks.end(); ++it ) {
+			if ( it->id == id ) {
+				callbacks.erase( it );
+				return;
+			}
+		}
+	}
+
 	bool Cvar::Set( const char *value, bool initial ) {
 		if ( !initial && (flags & CVAR_READONLY) ) {
 			console.Print( "Attempt to set read-only cvar \"%s\"\n", name.c_str() );
 			return false;
 		}
 
-		fullString = value;
+		if ( !initial ) {
+			modified = true;
+		}
+
+		{
+			// another thread may be reading the values
+			std::lock_guard<std::mutex> lock( mutex );
 
-		values.clear();
-		const char delim = ' ';
-		std::vector<std::string> tokens = String::Split( value, delim );
-		for ( const auto &it : tokens ) {
-			CvarValue newValue = {};
-
-			newValue.str = it;
-			const char *cstr = newValue.str.c_str();
-			newValue.real = atof( cstr );
-			newValue.number = static_cast<float>( newValue.real );
-			newValue.integer = atoi( cstr );
-			newValue.boolean = !!newValue.integer; // coerce to boolean
-
-			values.push_back( newValue );
+			// nothing depends on the value having been set, only on what it is
+			if ( modificationCount && fullString == value ) {
+				return true;
+			}
+
+			fullString = value;
+			parsed = false;
 		}
 
-		if ( !initial ) {
-			modified = true;
+		modificationCount++;
+		for ( const auto &callback : callbacks ) {
+			callback.function( this );
 		}
 
 		return true;
 	}
 
+	void Cvar::Parse( void ) const {
+		const char *end = fullString.c_str() + fullString.length();
+		tokens.Tokenize( fullString.c_str(), end );
+
+		values.clear();
+		for ( const auto &token : tokens ) {
+			CvarValue value;
+
+			value.str = token.text;
+			value.real = atof( token.text );
+			value.number = static_cast<float>( value.real );
+			value.integer = atoi( token.text );
+			value.boolean = !!value.integer; // coerce to boolean
+
+			values.push_back( value );
+		}
+
+		parsed = true;
+	}
+
 	bool Cvar::Set( const std::string &value, bool initial ) {
 		return Set( value.c_str(), initial );
 	}
 
 	bool Cvar::Set( const int32_t value, bool initial ) {
-		return Set( String::Format( "%i", value ), initial );
+		return Set( String::FormatTemp( "%i", value ), initial );
 	}
 
 	bool Cvar::Set( const float value, bool initial ) {
-		return Set( String::Format( "%f", value ), initial );
+		return Set( String::FormatTemp( "%f", value ), initial );
 	}
 
 	bool Cvar::Set( const bool value, bool initial ) {
-		return Set( String::Format( "%i", !!value ), initial ); // good enough
+		return Set( String::FormatTemp( "%i", !!value ), initial ); // good enough
 	}
 
 } // namespace XS
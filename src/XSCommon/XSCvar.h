@@ -1,8 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "XSCommon/XSString.h"
+
 namespace XS {
 
 	#define CVAR_NONE		(0x0000u)	// temporary storage
@@ -12,15 +17,25 @@ namespace XS {
 	#define CVAR_READONLY	(0x0008u)	// can only be set by code
 
 	struct CvarValue {
-		std::string 	str;
-		int32_t			integer;
-		float			number;
-		double			real;
-		bool			boolean;
+		const char		*str; // in the cvar's tokenizer
+		int32_t			 integer;
+		float			 number;
+		double			 real;
+		bool			 boolean;
 	};
 
+	class Cvar;
+
+	// called with the cvar after its value changes
+	typedef std::function<void( const Cvar *cvar )> cvarCallback_t;
+
 	class Cvar {
 	private:
+		struct callback_t {
+			uint32_t		id;
+			cvarCallback_t	function;
+		};
+
 		// used internally
 		// construct a new cvar object and add it to the global list
 		// called by Cvar::Create()
@@ -36,9 +51,36 @@ namespace XS {
 		std::string				defaultStr;
 		std::string				description; // short description of the cvar
 		std::string				fullString;
-		std::vector<CvarValue>	values; // separated by whitespace
+
+		// fullString is only split up and converted when a value is first asked for after it changes, so setting a
+		//	cvar is just a copy
+		// any thread may read a cvar, so fullString and the parsed values are only touched with mutex held, and
+		//	values are handed out by copy
+		mutable std::mutex				mutex;
+		mutable String::Tokenizer		tokens;
+		mutable std::vector<CvarValue>	values; // separated by whitespace
+		mutable bool					parsed; // values match fullString
 		uint32_t				flags; // archive, read-only, etc
 		bool					modified; // has been modified after creation (by user or code)
+		std::atomic<uint32_t>	modificationCount; // incremented every time the value changes, including creation
+		std::vector<callback_t>	callbacks;
+		uint32_t				nextCallbackId;
+
+		// split fullString into values if it has changed since they were last parsed, mutex must be held
+		void Parse(
+			void
+		) const;
+
+		// a copy of the value at the given index, or an empty one if there aren't that many
+		// its str is only valid until the cvar is next set
+		inline CvarValue GetValue( size_t index ) const {
+			static const CvarValue empty = { "", 0, 0.0f, 0.0, false };
+			std::lock_guard<std::mutex> lock( mutex );
+			if ( !parsed ) {
+				Parse();
+			}
+			return (index < values.size()) ? values[index] : empty;
+		}
 
 	public:
 		// indicates whether the game has been initialised for cvars that may only be set on the command line
@@ -68,6 +110,7 @@ namespace XS {
 
 		// fetch a handle to an existing cvar
 		// returns nullptr if none are found
+		// this is a string lookup, so look it up once and keep the handle rather than calling it every frame
 		static Cvar *Get(
 			const std::string &name
 		);
@@ -83,7 +126,20 @@ namespace XS {
 			uint32_t flags
 		);
 
+		// call a function whenever the value changes, on the thread that changed it
+		// callbacks must not add or remove callbacks on the same cvar
+		// returns an id to remove it with
+		uint32_t AddCallback(
+			const cvarCallback_t &callback
+		);
+
+		// stop calling a function added with AddCallback
+		void RemoveCallback(
+			uint32_t id
+		);
+
 		// set a new value for the cvar
+		// callbacks are only called, and the modification count only incremented, if the value is different
 		bool Set(
 			const std::string &value,
 			bool initial = false
@@ -105,12 +161,24 @@ namespace XS {
 			bool initial = false
 		);
 
-		// retrieve a value for the cvar at the given index (e.g. index 1 for "640 480" will be "480"
-		inline const std::string &GetString( size_t index = 0u ) const {
-			return this->values[index].str;
+		// compare with a count saved earlier to find out if the value has changed since then
+		// it's never 0 once the cvar has been created, so 0 can be used to mean "never seen"
+		inline uint32_t GetModificationCount( void ) const {
+			return this->modificationCount.load( std::memory_order_relaxed );
 		}
+
+		// retrieve a value for the cvar at the given index (e.g. index 1 for "640 480" will be "480"
+		// numbers can be read from any thread, strings are only valid until the cvar is next set so other threads
+		//	should use GetString, and only the main thread should read the full string
 		inline const char *GetCString( size_t index = 0u ) const {
-			return this->values[index].str.c_str();
+			return GetValue( index ).str;
+		}
+		inline std::string GetString( size_t index = 0u ) const {
+			std::lock_guard<std::mutex> lock( mutex );
+			if ( !parsed ) {
+				Parse();
+			}
+			return (index < values.size()) ? values[index].str : "";
 		}
 		inline const std::string &GetFullString( void ) const {
 			return this->fullString;
@@ -119,16 +187,16 @@ namespace XS {
 			return this->fullString.c_str();
 		}
 		inline int32_t GetInt( size_t index = 0u ) const {
-			return this->values[index].integer;
+			return GetValue( index ).integer;
 		}
 		inline float GetFloat( size_t index = 0u ) const {
-			return this->values[index].number;
+			return GetValue( index ).number;
 		}
 		inline double GetDouble( size_t index = 0u ) const {
-			return this->values[index].real;
+			return GetValue( index ).real;
 		}
 		inline bool GetBool( size_t index = 0u ) const {
-			return this->values[index].boolean;
+			return GetValue( index ).boolean;
 		}
 	};
 
@@ -1,11 +1,12 @@
-#include <list>
-
 #include "XSCommon/XSCommon.h"
 #include "XSCommon/XSEvent.h"
 #include "XSCommon/XSCvar.h"
 #include "XSCommon/XSString.h"
 #include "XSCommon/XSConsole.h"
 #include "XSCommon/XSError.h"
+#include "XSCommon/XSGlobals.h"
+#include "XSCommon/XSRingBuffer.h"
+#include "XSCommon/XSTimer.h"
 #include "XSInput/XSKeys.h"
 
 namespace XS {
@@ -14,10 +15,8 @@ namespace XS {
 
 		static Cvar *debug_events = nullptr;
 
-		// this is cleared each pump. we may just want to expand
-		//	as necessary and set the head to 0 at the end of each pump
-		//	to avoid the overhead of clear()
-		static std::list<XSEvent> events;
+		// filled by whoever polls input, drained by the simulation a tick at a time
+		static RingBuffer<XSEvent, EVENT_QUEUE_SIZE> events;
 
 		// for debugging
 		static const char *eventNames[EventType::NUM_EVENTS] = {
@@ -54,11 +53,19 @@ namespace XS {
 				}
 			}
 
-			events.push_back( *ev );
+			XSEvent stamped( *ev );
+			stamped.time = Common::gameTimer ? Common::gameTimer->GetElapsed() : 0u;
+			if ( !events.Push( stamped ) ) {
+				console.Print( "WARNING: Event queue is full, dropping %s\n", eventNames[ev->type] );
+			}
 		}
 
-		void Pump( void ) {
-			for ( const auto &it : events ) {
+		void Pump( uint64_t time ) {
+			for ( XSEvent *ev = events.Front(); ev && ev->time <= time; ev = events.Front() ) {
+				// copied so it's off the queue before anything runs, in case that queues more events
+				const XSEvent it( *ev );
+				events.Pop();
+
 				switch( it.type ) {
 				case EventType::KEY: {
 					Client::KeyEvent( it.keyEvent.key, it.keyEvent.down );
@@ -77,7 +84,6 @@ namespace XS {
 				} break;
 				}
 			}
-			events.clear();
 		}
 
 	} // namespace Event
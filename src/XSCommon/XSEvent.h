@@ -17,9 +17,11 @@ namespace XS {
 		NUM_EVENTS
 	};
 
+	#define EVENT_QUEUE_SIZE (1024u) // events that can be waiting for a tick at once
+
 	struct XSEvent {
 		EventType	type;
-		uint32_t	time;
+		uint64_t	time; // nanoseconds on Common::gameTimer, set when the event is queued
 
 		union {
 			struct {
@@ -54,14 +56,17 @@ namespace XS {
 			void
 		);
 
-		// add an event to the event queue
+		// stamp an event with the current time and add it to the event queue
+		// the queue has a fixed size, if it's full the event is dropped
+		// only one thread may queue events
 		void Queue(
 			const XSEvent *ev
 		);
 
-		// pump all queued events, executing the necessary functions
+		// pump the events queued up to and including the given time, executing the necessary functions
+		// later events are left in the queue, so each tick only sees what happened before it
 		void Pump(
-			void
+			uint64_t time
 		);
 
 	} // namespace Event
@@ -1,3 +1,5 @@
+#include <atomic>
+
 #include "XSCommon/XSCommon.h"
 #include "XSCommon/XSFile.h"
 #include "XSCommon/XSCvar.h"
@@ -10,7 +12,8 @@ namespace XS {
 
 	static char basePath[XS_MAX_FILENAME];
 	static Cvar *com_path;
-	static bool initialised = false;
+	// the log writer thread opens files too
+	static std::atomic<bool> initialised( false );
 
 	static const char *modes[FileMode::NUM_MODES] = {
 		"rb", // FM_READ
@@ -193,6 +196,10 @@ namespace XS {
 		fwrite( buf, 1, len, file );
 	}
 
+	void File::Flush( void ) const {
+		fflush( file );
+	}
+
 	void File::Clear( void ) {
 		length = 0L;
 		open = false;
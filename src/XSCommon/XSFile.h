@@ -122,6 +122,11 @@ namespace XS {
 			const void *buf,
 			size_t len
 		) const;
+
+		// write anything buffered out to the OS
+		void Flush(
+			void
+		) const;
 	};
 
 } // namespace XS
@@ -0,0 +1,58 @@
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "XSCommon/XSCommon.h"
+#include "XSCommon/XSFrameArena.h"
+
+namespace XS {
+
+	namespace FrameArena {
+
+		#define FRAMEARENA_BLOCK_SIZE (64u * 1024u)
+		#define FRAMEARENA_ALIGNMENT (alignof(std::max_align_t))
+
+		struct arena_t {
+			std::vector<std::unique_ptr<uint8_t[]>>	blocks;
+			std::vector<size_t>						blockSizes;
+			size_t									used; // in the last block
+			uint32_t								frame; // when the blocks were last released
+		};
+
+		static std::atomic<uint32_t> frameNum( 0u );
+		static thread_local arena_t arena;
+
+		void *Allocate( size_t bytes ) {
+			bytes = (bytes + FRAMEARENA_ALIGNMENT - 1u) & ~(FRAMEARENA_ALIGNMENT - 1u);
+
+			// release last frame's allocations, keeping the first block for this frame
+			const uint32_t frame = frameNum.load( std::memory_order_relaxed );
+			if ( arena.frame != frame ) {
+				if ( arena.blocks.size() > 1u ) {
+					arena.blocks.resize( 1u );
+					arena.blockSizes.resize( 1u );
+				}
+				arena.used = 0u;
+				arena.frame = frame;
+			}
+
+			if ( arena.blocks.empty() || arena.used + bytes > arena.blockSizes.back() ) {
+				const size_t size = std::max<size_t>( bytes, FRAMEARENA_BLOCK_SIZE );
+				arena.blocks.push_back( std::unique_ptr<uint8_t[]>( new uint8_t[size] ) );
+				arena.blockSizes.push_back( size );
+				arena.used = 0u;
+			}
+
+			void *memory = arena.blocks.back().get() + arena.used;
+			arena.used += bytes;
+			return memory;
+		}
+
+		void EndFrame( void ) {
+			frameNum.fetch_add( 1u, std::memory_order_relaxed );
+		}
+
+	} // namespace FrameArena
+
+} // namespace XS
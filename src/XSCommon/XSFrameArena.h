@@ -0,0 +1,23 @@
+#pragma once
+
+namespace XS {
+
+	// memory that lasts until the end of the frame, for temporaries that don't fit in a fixed buffer
+	// allocation is a pointer bump, and nothing is freed individually, everything goes at once when the frame ends
+	// each thread allocates from its own blocks, so there's no locking
+	namespace FrameArena {
+
+		// returns memory valid until the end of the frame, aligned for any type
+		void *Allocate(
+			size_t bytes
+		);
+
+		// release everything allocated this frame, called once per frame by the main thread
+		// other threads release theirs the next time they allocate
+		void EndFrame(
+			void
+		);
+
+	} // namespace FrameArena
+
+} // namespace XS
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "XSCommon/XSCommon.h"
+#include "XSCommon/XSFramePacer.h"
+#include "XSCommon/XSTimer.h"
+
+namespace XS {
+
+	FramePacer::FramePacer()
+	: deadline( 0u ), lastFrame( 0u ), numSamples( 0u ), nextSample( 0u )
+	{
+	}
+
+	void FramePacer::Wait( uint64_t intervalNsec, uint64_t idleNsec, const std::function<void( void )> &idle ) {
+		uint64_t now = Timer::GetNanoseconds();
+		if ( !deadline ) {
+			deadline = now;
+		}
+		deadline += intervalNsec;
+		if ( deadline < now ) {
+			// we're more than a frame behind, start the next one now rather than rushing to catch up
+			deadline = now;
+		}
+
+		// sleep while there's time to spare, a slice at a time so idle gets a look in
+		while ( now + FRAMEPACER_SPIN_NSEC < deadline ) {
+			const uint64_t sleepNsec = std::min( deadline - now - FRAMEPACER_SPIN_NSEC,
+				std::max<uint64_t>( idleNsec, 1u ) );
+			std::this_thread::sleep_for( std::chrono::nanoseconds( sleepNsec ) );
+			if ( idle ) {
+				idle();
+			}
+			now = Timer::GetNanoseconds();
+		}
+
+		// and spin for the rest
+		while ( now < deadline ) {
+			now = Timer::GetNanoseconds();
+		}
+
+		if ( lastFrame ) {
+			const uint64_t frameNsec = now - lastFrame;
+			const uint64_t offNsec = (frameNsec > intervalNsec) ? frameNsec - intervalNsec : intervalNsec - frameNsec;
+			jitter[nextSample] = static_cast<uint32_t>( std::min<uint64_t>( offNsec, UINT32_MAX ) );
+			nextSample = (nextSample + 1u) % FRAMEPACER_HISTORY;
+			numSamples = std::min( numSamples + 1u, FRAMEPACER_HISTORY );
+		}
+		lastFrame = now;
+	}
+
+	void FramePacer::GetJitter( real64_t *outMeanUsec, real64_t *outMaxUsec ) const {
+		uint64_t total = 0u;
+		uint32_t most = 0u;
+		for ( uint32_t i = 0u; i < numSamples; i++ ) {
+			total += jitter[i];
+			most = std::max( most, jitter[i] );
+		}
+
+		*outMeanUsec = numSamples ? (total / static_cast<real64_t>( numSamples )) * 0.001 : 0.0;
+		*outMaxUsec = most * 0.001;
+	}
+
+} // namespace XS
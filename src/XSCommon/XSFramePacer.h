@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+
+namespace XS {
+
+	#define FRAMEPACER_SPIN_NSEC (1000000u) // sleeping can overshoot by this much, so the last of a wait is spun
+	#define FRAMEPACER_HISTORY (128u) // frames the jitter is measured over
+
+	// keeps frames starting a fixed interval apart
+	// it sleeps while there's plenty of time left, then spins until the frame is due, so frames start within
+	//	microseconds of when they should rather than whenever the scheduler wakes us up
+	// if a frame runs long the next one starts straight away, but it doesn't try to catch up on the ones it missed
+	class FramePacer {
+	private:
+		uint64_t	deadline; // when the next frame is due, on Timer::GetNanoseconds
+		uint64_t	lastFrame; // when the last wait finished
+		uint32_t	jitter[FRAMEPACER_HISTORY]; // nanoseconds each frame interval was off its target
+		uint32_t	numSamples;
+		uint32_t	nextSample;
+
+	public:
+		FramePacer();
+
+		// wait until intervalNsec after the last frame was due
+		// idle, if set, is called at least every idleNsec while there's time to sleep, e.g. to poll input
+		void Wait(
+			uint64_t intervalNsec,
+			uint64_t idleNsec,
+			const std::function<void( void )> &idle
+		);
+
+		// how far the time between frames has been from the target over the last FRAMEPACER_HISTORY frames, on
+		//	average and at most, in microseconds
+		void GetJitter(
+			real64_t *outMeanUsec,
+			real64_t *outMaxUsec
+		) const;
+	};
+
+} // namespace XS
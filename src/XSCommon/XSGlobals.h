@@ -3,6 +3,7 @@
 namespace XS {
 
 	class Cvar;
+	class FramePacer;
 	class Timer;
 
 	namespace Common {
@@ -11,6 +12,7 @@ namespace XS {
 		extern Cvar *com_path;
 
 		extern Timer *gameTimer;
+		extern FramePacer *framePacer;
 
 	} // namespace Common
 
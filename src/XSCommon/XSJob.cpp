@@ -0,0 +1,440 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "XSCommon/XSCommon.h"
+#include "XSCommon/XSConsole.h"
+#include "XSCommon/XSCvar.h"
+#include "XSCommon/XSError.h"
+#include "XSCommon/XSJob.h"
+#include "XSCommon/XSString.h"
+
+namespace XS {
+
+	namespace Job {
+
+		#define JOB_SPIN_COUNT (64u) // times an idle worker looks for work before it goes to sleep
+
+		struct job_t {
+			jobFunc_t				func;
+			job_t					*parent;
+			std::atomic<int32_t>	unfinished; // this job plus its unfinished children
+			Affinity				affinity;
+			alignas(std::max_align_t) uint8_t data[JOB_DATA_SIZE];
+		};
+
+		// a Chase-Lev deque
+		// the owner pushes and pops at the bottom, other threads steal from the top, and only taking the last job
+		//	needs a compare and swap
+		// it can't hold more than the owner's pool, so it never has to grow
+		class JobDeque {
+		private:
+			static constexpr int64_t mask = JOB_POOL_SIZE - 1;
+
+			// padded rather than aligned, so the deque can be allocated with new
+			// thieves write top and the owner writes bottom, so they're kept on separate cache lines
+			std::atomic<job_t *>	jobs[JOB_POOL_SIZE];
+			std::atomic<int64_t>	top; // next to steal
+			uint8_t					padding[64];
+			std::atomic<int64_t>	bottom; // next to push
+
+		public:
+			JobDeque()
+			: top( 0 ), bottom( 0 )
+			{
+			}
+
+			// owner only, returns false if the deque is full
+			bool Push( job_t *job ) {
+				const int64_t b = bottom.load( std::memory_order_relaxed );
+				const int64_t t = top.load( std::memory_order_acquire );
+				if ( b - t > mask ) {
+					return false;
+				}
+				jobs[b & mask].store( job, std::memory_order_relaxed );
+				bottom.store( b + 1, std::memory_order_release );
+				return true;
+			}
+
+			// owner only, the newest job or nullptr
+			job_t *Pop( void ) {
+				const int64_t b = bottom.load( std::memory_order_relaxed ) - 1;
+				bottom.store( b, std::memory_order_seq_cst );
+				int64_t t = top.load( std::memory_order_seq_cst );
+				if ( t > b ) {
+					// empty
+					bottom.store( b + 1, std::memory_order_relaxed );
+					return nullptr;
+				}
+
+				job_t *job = jobs[b & mask].load( std::memory_order_relaxed );
+				if ( t == b ) {
+					// the last job, race any thieves for it
+					if ( !top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst,
+						std::memory_order_relaxed ) )
+					{
+						job = nullptr;
+					}
+					bottom.store( b + 1, std::memory_order_relaxed );
+				}
+				return job;
+			}
+
+			// any thread, the oldest job or nullptr if it's empty or another thread got there first
+			job_t *Steal( void ) {
+				int64_t t = top.load( std::memory_order_seq_cst );
+				const int64_t b = bottom.load( std::memory_order_seq_cst );
+				if ( t >= b ) {
+					return nullptr;
+				}
+
+				job_t *job = jobs[t & mask].load( std::memory_order_relaxed );
+				if ( !top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) {
+					return nullptr;
+				}
+				return job;
+			}
+		};
+
+		struct worker_t {
+			JobDeque					deque;
+			std::unique_ptr<job_t[]>	pool; // reused in turn, JOB_POOL_SIZE of them
+			uint32_t					nextJob;
+			uint32_t					index; // 0 is the main thread
+		};
+
+		static Cvar *com_jobThreads = nullptr;
+
+		static std::vector<std::unique_ptr<worker_t>> workers;
+		static std::vector<std::thread> threads;
+		static thread_local worker_t *self = nullptr;
+
+		// idle workers sleep until the generation changes, which it does whenever a job is queued
+		static std::mutex sleepMutex;
+		static std::condition_variable sleepCondition;
+		static std::atomic<uint32_t> generation( 0u );
+		static std::atomic<uint32_t> sleepers( 0u );
+		static std::atomic<bool> quit( false );
+
+		// jobs that can only run on the main thread
+		static std::mutex mainMutex;
+		static std::deque<job_t *> mainJobs;
+		static std::atomic<uint32_t> numMainJobs( 0u );
+
+		// the first error thrown by a job, rethrown on the main thread
+		static std::mutex errorMutex;
+		static std::string errorMessage;
+		static std::atomic<bool> failed( false );
+
+		static inline bool IsMainThread( void ) {
+			return self && self->index == 0u;
+		}
+
+		static void Wake( void ) {
+			generation.fetch_add( 1u );
+			if ( sleepers.load() ) {
+				std::lock_guard<std::mutex> lock( sleepMutex );
+				sleepCondition.notify_one();
+			}
+		}
+
+		static void Finish( job_t *job ) {
+			// the last child to finish finishes its parent
+			// a finished job can be reused straight away, so nothing is read from it afterwards
+			while ( job ) {
+				job_t *parent = job->parent;
+				if ( job->unfinished.fetch_sub( 1, std::memory_order_acq_rel ) != 1 ) {
+					break;
+				}
+				job = parent;
+			}
+		}
+
+		static void Execute( job_t *job ) {
+			try {
+				job->func( job, job->data );
+			}
+			catch ( const XSError &e ) {
+				std::lock_guard<std::mutex> lock( errorMutex );
+				if ( !failed.load( std::memory_order_relaxed ) ) {
+					errorMessage = e.what();
+					failed.store( true, std::memory_order_release );
+				}
+			}
+			Finish( job );
+		}
+
+		static void CheckErrors( void ) {
+			if ( !IsMainThread() || !failed.load( std::memory_order_acquire ) ) {
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock( errorMutex );
+			failed.store( false, std::memory_order_relaxed );
+			throw( XSError( errorMessage.c_str() ) );
+		}
+
+		static job_t *GetMainJob( void ) {
+			if ( !numMainJobs.load( std::memory_order_acquire ) ) {
+				return nullptr;
+			}
+
+			std::lock_guard<std::mutex> lock( mainMutex );
+			if ( mainJobs.empty() ) {
+				return nullptr;
+			}
+			job_t *job = mainJobs.front();
+			mainJobs.pop_front();
+			numMainJobs.fetch_sub( 1u, std::memory_order_relaxed );
+			return job;
+		}
+
+		// the next job this thread should run, or nullptr if there's nothing to do
+		static job_t *GetJob( void ) {
+			job_t *job = nullptr;
+			if ( IsMainThread() && (job = GetMainJob()) ) {
+				return job;
+			}
+
+			if ( (job = self->deque.Pop()) ) {
+				return job;
+			}
+
+			// steal from the others, starting with the next thread along so they don't all pick on the same one
+			const uint32_t numThreads = static_cast<uint32_t>( workers.size() );
+			for ( uint32_t i = 1u; i < numThreads; i++ ) {
+				worker_t *victim = workers[(self->index + i) % numThreads].get();
+				if ( (job = victim->deque.Steal()) ) {
+					return job;
+				}
+			}
+
+			return nullptr;
+		}
+
+		static void WorkerThread( worker_t *worker ) {
+			self = worker;
+
+			uint32_t idle = 0u;
+			while ( !quit.load( std::memory_order_acquire ) ) {
+				// read before looking for work, so a job queued after we look changes it and we don't sleep
+				const uint32_t seen = generation.load();
+
+				job_t *job = GetJob();
+				if ( job ) {
+					Execute( job );
+					idle = 0u;
+					continue;
+				}
+
+				if ( ++idle < JOB_SPIN_COUNT ) {
+					std::this_thread::yield();
+					continue;
+				}
+
+				idle = 0u;
+				std::unique_lock<std::mutex> lock( sleepMutex );
+				sleepers.fetch_add( 1u );
+				sleepCondition.wait( lock, [seen] {
+					return quit.load() || generation.load() != seen;
+				} );
+				sleepers.fetch_sub( 1u );
+			}
+
+			self = nullptr;
+		}
+
+		void Init( void ) {
+			com_jobThreads = Cvar::Create( "com_jobThreads", "0",
+				"Number of worker threads that run jobs alongside the main thread, 0 for one per core", CVAR_ARCHIVE );
+
+			uint32_t numWorkers = 0u;
+			if ( com_jobThreads->GetInt() > 0 ) {
+				numWorkers = static_cast<uint32_t>( com_jobThreads->GetInt() );
+			}
+			else {
+				// there's always at least one, so jobs nobody waits on still get run
+				numWorkers = std::max( std::thread::hardware_concurrency(), 2u ) - 1u;
+			}
+
+			quit.store( false );
+			for ( uint32_t i = 0u; i <= numWorkers; i++ ) {
+				worker_t *worker = new worker_t();
+				worker->pool.reset( new job_t[JOB_POOL_SIZE] );
+				for ( uint32_t j = 0u; j < JOB_POOL_SIZE; j++ ) {
+					worker->pool[j].unfinished.store( 0, std::memory_order_relaxed );
+				}
+				worker->nextJob = 0u;
+				worker->index = i;
+				workers.push_back( std::unique_ptr<worker_t>( worker ) );
+			}
+
+			self = workers[0].get();
+			for ( uint32_t i = 1u; i <= numWorkers; i++ ) {
+				threads.push_back( std::thread( WorkerThread, workers[i].get() ) );
+			}
+
+			console.DebugPrint( "Job system running on %u threads\n", numWorkers + 1u );
+		}
+
+		void Shutdown( void ) {
+			if ( workers.empty() ) {
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock( sleepMutex );
+				quit.store( true );
+			}
+			sleepCondition.notify_all();
+			for ( auto &thread : threads ) {
+				thread.join();
+			}
+			threads.clear();
+
+			{
+				std::lock_guard<std::mutex> lock( mainMutex );
+				mainJobs.clear();
+				numMainJobs.store( 0u );
+			}
+
+			self = nullptr;
+			workers.clear();
+		}
+
+		uint32_t GetNumThreads( void ) {
+			return static_cast<uint32_t>( workers.size() );
+		}
+
+		uint32_t GetThreadIndex( void ) {
+			return self ? self->index : JOB_NO_THREAD;
+		}
+
+		job_t *Create( jobFunc_t func, const void *data, size_t size, Affinity affinity ) {
+			if ( !self ) {
+				throw( XSError( "Tried to create a job outside of the job system" ) );
+			}
+			if ( size > JOB_DATA_SIZE ) {
+				throw( XSError( String::Format( "Job data is too large (%u > %u bytes)",
+					static_cast<uint32_t>( size ), JOB_DATA_SIZE ).c_str() ) );
+			}
+
+			// jobs mostly finish in the order they're created, but a parent outlives its children, so skip any that
+			//	are still in flight
+			job_t *job = nullptr;
+			for ( uint32_t i = 0u; i < JOB_POOL_SIZE && !job; i++ ) {
+				job_t *slot = &self->pool[self->nextJob++ & (JOB_POOL_SIZE - 1u)];
+				if ( !slot->unfinished.load( std::memory_order_acquire ) ) {
+					job = slot;
+				}
+			}
+			if ( !job ) {
+				throw( XSError( "Too many jobs in flight" ) );
+			}
+
+			job->func = func;
+			job->parent = nullptr;
+			job->unfinished.store( 1, std::memory_order_relaxed );
+			job->affinity = affinity;
+			if ( size ) {
+				std::memcpy( job->data, data, size );
+			}
+
+			return job;
+		}
+
+		job_t *CreateChild( job_t *parent, jobFunc_t func, const void *data, size_t size, Affinity affinity ) {
+			job_t *job = Create( func, data, size, affinity );
+			job->parent = parent;
+			parent->unfinished.fetch_add( 1, std::memory_order_relaxed );
+			return job;
+		}
+
+		void Run( job_t *job ) {
+			if ( job->affinity == Affinity::MAIN ) {
+				std::lock_guard<std::mutex> lock( mainMutex );
+				mainJobs.push_back( job );
+				numMainJobs.fetch_add( 1u, std::memory_order_release );
+				return;
+			}
+
+			// if the deque is full the job may as well run now, it's what we'd end up doing anyway
+			if ( !self->deque.Push( job ) ) {
+				Execute( job );
+				return;
+			}
+
+			Wake();
+		}
+
+		void Wait( const job_t *job ) {
+			while ( job->unfinished.load( std::memory_order_acquire ) > 0 ) {
+				job_t *next = GetJob();
+				if ( next ) {
+					Execute( next );
+				}
+				else {
+					std::this_thread::yield();
+				}
+			}
+
+			CheckErrors();
+		}
+
+		void RunMainThreadJobs( void ) {
+			while ( job_t *job = GetMainJob() ) {
+				Execute( job );
+			}
+
+			CheckErrors();
+		}
+
+		struct parallelFor_t {
+			rangeFunc_t	func;
+			const void	*context;
+			uint32_t	begin, end;
+			uint32_t	grain;
+		};
+
+		static void ParallelForJob( job_t *job, const void *data ) {
+			parallelFor_t range = *static_cast<const parallelFor_t *>( data );
+
+			// hand the upper half of the range to another job until what's left is small enough to run here
+			// the biggest halves are the oldest, so they're the ones other threads steal
+			while ( range.end - range.begin > range.grain ) {
+				parallelFor_t upper = range;
+				upper.begin = range.begin + ((range.end - range.begin) / 2u);
+				Run( CreateChild( job, ParallelForJob, &upper, sizeof(upper) ) );
+				range.end = upper.begin;
+			}
+
+			range.func( range.context, range.begin, range.end );
+		}
+
+		void ParallelFor( uint32_t begin, uint32_t end, uint32_t grain, rangeFunc_t func, const void *context ) {
+			if ( begin >= end ) {
+				return;
+			}
+
+			grain = std::max( grain, 1u );
+			if ( end - begin <= grain ) {
+				func( context, begin, end );
+				return;
+			}
+
+			const parallelFor_t range = { func, context, begin, end, grain };
+			job_t *job = Create( ParallelForJob, &range, sizeof(range) );
+			Run( job );
+			Wait( job );
+		}
+
+	} // namespace Job
+
+} // namespace XS
@@ -0,0 +1,107 @@
+#pragma once
+
+namespace XS {
+
+	// small pieces of work spread over a worker thread per core
+	// each thread keeps its jobs on its own deque and takes the newest first, an idle thread steals the oldest from
+	//	another thread's deque, so work spreads out without a shared queue to fight over
+	// a job finishes once it and every child created for it have run, waiting on a job runs other jobs meanwhile
+	// jobs can only be created and run from the main thread and from other jobs
+	namespace Job {
+
+		#define JOB_DATA_SIZE (96u) // bytes of arguments copied into a job
+		#define JOB_POOL_SIZE (4096u) // jobs each thread can have in flight, must be a power of two
+		#define JOB_NO_THREAD (UINT32_MAX)
+
+		struct job_t;
+
+		typedef void (*jobFunc_t)( job_t *job, const void *data );
+
+		// a range of indices for ParallelFor, called with [begin, end)
+		typedef void (*rangeFunc_t)( const void *context, uint32_t begin, uint32_t end );
+
+		enum class Affinity {
+			ANY, // run by whichever thread gets to it first
+			// only run by the main thread, e.g. SDL and window work
+			// not GL calls, the render thread may own the context, so use Renderer::RunOnRenderThread for those
+			MAIN,
+		};
+
+		// start the worker threads, called once by the main thread
+		void Init(
+			void
+		);
+
+		// stop the worker threads, jobs that haven't started yet are dropped
+		void Shutdown(
+			void
+		);
+
+		// number of threads that run jobs, including the main thread
+		// 0 once the job system has been shut down
+		uint32_t GetNumThreads(
+			void
+		);
+
+		// the calling thread's index, 0 for the main thread, or JOB_NO_THREAD if it doesn't run jobs
+		uint32_t GetThreadIndex(
+			void
+		);
+
+		// create a job that runs func with a copy of size bytes of data, up to JOB_DATA_SIZE
+		// it does nothing until it's handed to Run
+		job_t *Create(
+			jobFunc_t func,
+			const void *data = nullptr,
+			size_t size = 0u,
+			Affinity affinity = Affinity::ANY
+		);
+
+		// create a job that parent doesn't finish without
+		// parent must not have finished yet, e.g. created from within the parent itself or before it's run
+		job_t *CreateChild(
+			job_t *parent,
+			jobFunc_t func,
+			const void *data = nullptr,
+			size_t size = 0u,
+			Affinity affinity = Affinity::ANY
+		);
+
+		// queue a job to be run
+		void Run(
+			job_t *job
+		);
+
+		// run jobs until this one and all of its children have finished
+		// rethrows an error from any job that failed
+		void Wait(
+			const job_t *job
+		);
+
+		// run the jobs that can only run on the main thread, called once per frame by the main thread
+		// rethrows an error from any job that failed
+		void RunMainThreadJobs(
+			void
+		);
+
+		// call func over [begin, end), split into ranges of no fewer than grain indices that are run in parallel
+		// returns once every range has been run
+		void ParallelFor(
+			uint32_t begin,
+			uint32_t end,
+			uint32_t grain,
+			rangeFunc_t func,
+			const void *context
+		);
+
+		// as above, with anything callable as func( begin, end )
+		template<typename Func>
+		inline void ParallelFor( uint32_t begin, uint32_t end, uint32_t grain, const Func &func ) {
+			ParallelFor( begin, end, grain, []( const void *context, uint32_t rangeBegin, uint32_t rangeEnd ) {
+				(*static_cast<const Func *>( context ))( rangeBegin, rangeEnd );
+			}, &func );
+		}
+
+	} // namespace Job
+
+} // namespace XS
@@ -1,58 +1,243 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <exception>
+#include <vector>
+
 #include "XSCommon/XSCommon.h"
 #include "XSCommon/XSLogger.h"
 #include "XSCommon/XSFile.h"
 
+#if defined(XS_OS_WINDOWS)
+	#define WIN32_LEAN_AND_MEAN
+	#define VC_EXTRALEAN
+	#ifndef NOMINMAX
+		#define NOMINMAX /* Don't define min() and max() */
+	#endif
+	#include <Windows.h>
+#endif
+
 namespace XS {
 
+	#define LOGGER_WAKE_MSEC (50) // the writer wakes at least this often, which is how stale the cached clock gets
+
+	// refreshed by the writer threads, so printing doesn't have to read the clock
+	static std::atomic<time_t> cachedTime( 0 );
+
+	// loggers to flush if we terminate or crash
+	static std::mutex loggersMutex;
+	static std::vector<Logger *> loggers;
+	static bool crashHandlersInstalled = false;
+	static std::atomic<bool> crashing( false );
+	static std::terminate_handler previousTerminate = nullptr;
+	static const int fatalSignals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+#if defined(XS_OS_WINDOWS)
+	static LPTOP_LEVEL_EXCEPTION_FILTER previousFilter = nullptr;
+#endif
+
+	static void FlushLoggers( void ) {
+		// only the first fatal error writes anything, e.g. Terminate aborting raises SIGABRT
+		if ( crashing.exchange( true ) ) {
+			return;
+		}
+
+		// write out what we can, but never wait on anything, the thread holding a lock may be the one that failed
+		if ( loggersMutex.try_lock() ) {
+			for ( auto &logger : loggers ) {
+				logger->Flush( false );
+			}
+			loggersMutex.unlock();
+		}
+	}
+
+	static void Terminate( void ) {
+		FlushLoggers();
+
+		if ( previousTerminate ) {
+			previousTerminate();
+		}
+		std::abort();
+	}
+
+	static void FatalSignal( int signalNumber ) {
+		FlushLoggers();
+
+		// let the default action take the process down, so the exit status and core dump are still right
+		std::signal( signalNumber, SIG_DFL );
+		std::raise( signalNumber );
+	}
+
+#if defined(XS_OS_WINDOWS)
+	static LONG WINAPI UnhandledException( EXCEPTION_POINTERS *exception ) {
+		FlushLoggers();
+
+		if ( previousFilter ) {
+			return previousFilter( exception );
+		}
+		return EXCEPTION_CONTINUE_SEARCH;
+	}
+#endif
+
+	// loggersMutex must be held
+	static void InstallCrashHandlers( void ) {
+		if ( crashHandlersInstalled ) {
+			return;
+		}
+		crashHandlersInstalled = true;
+
+		previousTerminate = std::set_terminate( Terminate );
+		for ( const auto &signalNumber : fatalSignals ) {
+			std::signal( signalNumber, FatalSignal );
+		}
+	#if defined(XS_OS_WINDOWS)
+		previousFilter = SetUnhandledExceptionFilter( UnhandledException );
+	#endif
+	}
+
+	Logger::Logger( const char *filename, bool timestamp, bool echo )
+	: head( nullptr ), f( nullptr ), filename( filename ), timestamp( timestamp ), echo( echo ), quit( false ),
+		stampTime( 0 )
+	{
+		stamp[0] = '\0';
+
+		{
+			std::lock_guard<std::mutex> lock( loggersMutex );
+			InstallCrashHandlers();
+			loggers.push_back( this );
+		}
+
+		writer = std::thread( &Logger::Run, this );
+	}
+
 	Logger::~Logger() {
+		{
+			std::lock_guard<std::mutex> lock( loggersMutex );
+			loggers.erase( std::remove( loggers.begin(), loggers.end(), this ), loggers.end() );
+		}
+
+		quit.store( true, std::memory_order_release );
+		wake.notify_one();
+		writer.join();
+
+		// anything printed while the writer was finishing
+		Drain();
 		delete f;
 	}
 
-	void Logger::PrintQueued( void ) {
-		for ( const std::string &str : queue ) {
-			f->AppendString( str.c_str() );
+	void Logger::Run( void ) {
+		while ( true ) {
+			const bool quitting = quit.load( std::memory_order_acquire );
+
+			cachedTime.store( time( nullptr ), std::memory_order_relaxed );
+			{
+				std::lock_guard<std::mutex> lock( writeMutex );
+				Drain();
+			}
+
+			if ( quitting ) {
+				return;
+			}
+
+			// printers don't take the mutex to notify, so a wakeup can be missed, but only for LOGGER_WAKE_MSEC
+			std::unique_lock<std::mutex> lock( wakeMutex );
+			wake.wait_for( lock, std::chrono::milliseconds( LOGGER_WAKE_MSEC ), [this] {
+				return quit.load( std::memory_order_acquire ) || head.load( std::memory_order_relaxed ) != nullptr;
+			} );
 		}
-		queue.clear();
 	}
 
-	void Logger::Queue( std::string &str ) {
-		queue.push_back( str );
-	}
+	void Logger::Drain( void ) {
+		// take everything printed so far, and put it back in the order it was printed
+		message_t *message = head.exchange( nullptr, std::memory_order_acquire );
+		message_t *ordered = nullptr;
+		while ( message ) {
+			message_t *next = message->next;
+			message->next = ordered;
+			ordered = message;
+			message = next;
+		}
+		if ( !ordered ) {
+			return;
+		}
 
-	void Logger::Print( const char *message ) {
-		std::string out;
+		std::string batch;
+		std::string echoed;
+		for ( message = ordered; message; ) {
+			if ( timestamp ) {
+				// only format the stamp when the second changes
+				if ( message->time != stampTime || !stamp[0] ) {
+					strftime( stamp, sizeof(stamp), "[%Y-%m-%d] [%H:%M:%S] ", localtime( &message->time ) );
+					stampTime = message->time;
+				}
+				batch += stamp;
+			}
+			batch.append( message->text, message->length );
+			if ( echo ) {
+				echoed.append( message->text, message->length );
+			}
 
-		// create timestamp
-		if ( timestamp ) {
-			char buf[128];
-			time_t rawtime;
-			time( &rawtime );
-			strftime( buf, sizeof(buf), "[%Y-%m-%d] [%H:%M:%S] ", localtime( &rawtime ) );
-			out += buf;
+			message_t *next = message->next;
+			::operator delete( message );
+			message = next;
 		}
 
-		out += message;
+		if ( !echoed.empty() ) {
+			fwrite( echoed.c_str(), 1, echoed.length(), stdout );
+			fflush( stdout );
+		}
 
 		if ( !f ) {
 			// haven't opened the file yet, see if filesystem is available
-
 			f = new File( filename.c_str(), FileMode::APPEND );
-			if ( f->open ) {
-				// success, print what we've missed so far
-				Queue( out );
-				PrintQueued();
-			}
-			else {
-				// can't open yet, queue it
+			if ( !f->open ) {
+				// can't open yet, hold on to it
 				delete f;
 				f = nullptr;
-				Queue( out );
+				pending += batch;
 				return;
 			}
+
+			// success, write what we've missed so far
+			f->AppendString( pending.c_str() );
+			pending.clear();
+			pending.shrink_to_fit();
+		}
+		f->AppendString( batch.c_str() );
+		f->Flush();
+	}
+
+	void Logger::Print( const char *message, uint32_t length ) {
+		time_t now = cachedTime.load( std::memory_order_relaxed );
+		if ( !now ) {
+			now = time( nullptr );
+		}
+		message_t *node = static_cast<message_t *>( ::operator new( offsetof( message_t, text ) + length + 1u ) );
+		node->time = now;
+		node->length = length;
+		std::memcpy( node->text, message, length );
+		node->text[length] = '\0';
+
+		message_t *next = head.load( std::memory_order_relaxed );
+		do {
+			node->next = next;
+		} while ( !head.compare_exchange_weak( next, node, std::memory_order_release, std::memory_order_relaxed ) );
+
+		// the writer only needs waking for the first message of a batch
+		if ( !next ) {
+			wake.notify_one();
+		}
+	}
+
+	void Logger::Flush( bool wait ) {
+		if ( wait ) {
+			writeMutex.lock();
 		}
-		else {
-			f->AppendString( out.c_str() );
+		else if ( !writeMutex.try_lock() ) {
+			return;
 		}
+		Drain();
+		writeMutex.unlock();
 	}
 
 } // namespace XS
@@ -1,28 +1,53 @@
 #pragma once
 
-#include <vector>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 
 namespace XS {
 
 	class File;
 
+	// writes messages to a file from a background thread, so printing never waits on the disk
+	// any thread can print without blocking: messages are pushed onto a lock-free list, and the writer takes the
+	//	whole list at once and writes it out in order as one batch
+	// the file is opened once the filesystem is available, anything printed before then is held until it is
+	// queued messages are also written out on std::terminate and fatal signals/unhandled exceptions
 	class Logger {
 	private:
-		std::vector<std::string>	queue;
+		// allocated along with its text, so a message is one allocation
+		struct message_t {
+			message_t	*next;
+			time_t		 time;
+			uint32_t	 length;
+			char		 text[1];
+		};
+
+		std::atomic<message_t *>	 head; // newest first
+		std::string					 pending; // waiting for the file to be opened
 		File						*f;
-		std::string					filename;
-		bool						timestamp;
+		std::string					 filename;
+		bool						 timestamp;
+		bool						 echo; // also write messages to stdout
+
+		std::thread					 writer;
+		std::mutex					 writeMutex; // held while a batch is written
+		std::mutex					 wakeMutex;
+		std::condition_variable		 wake;
+		std::atomic<bool>			 quit;
+		time_t						 stampTime; // when stamp was formatted for
+		char						 stamp[64];
 
-		// write queued messages out to file once we have one open
-		void PrintQueued(
+		// the writer thread
+		void Run(
 			void
 		);
 
-		// add a message to the print queue
-		// when the filesystem becomes available, it will be written to disk
-		void Queue(
-			std::string &str
+		// write out everything printed so far, writeMutex must be held
+		void Drain(
+			void
 		);
 
 	public:
@@ -31,16 +56,25 @@ namespace XS {
 		Logger( const Logger& ) = delete;
 		Logger& operator=( const Logger& ) = delete;
 
-		Logger( const char *filename, bool timestamp = true )
-		: f( nullptr ), filename( filename ), timestamp( timestamp )
-		{
-		}
+		Logger(
+			const char *filename,
+			bool timestamp = true,
+			bool echo = false
+		);
 
+		// write out anything still queued
 		~Logger();
 
-		// write a message to the log file, or queue it if filesystem is not available
+		// queue a message to be written to the log file
 		void Print(
-			const char *message
+			const char *message,
+			uint32_t length
+		);
+
+		// write out everything printed so far before returning
+		// if wait is false, give up rather than wait for the writer to finish a batch
+		void Flush(
+			bool wait = true
 		);
 	};
 
@@ -6,40 +6,157 @@
 
 namespace XS {
 
-	MessageBuffer::MessageBuffer( const char *logfile ) {
+	MessageBuffer::MessageBuffer( const char *logfile, bool echo, uint32_t maxLines )
+	: writeOffset( 0u ), firstLine( 0u ), numLines( 0u ), owner( std::this_thread::get_id() ), pending( nullptr )
+	{
 		if ( logfile ) {
-			log = new Logger( logfile );
+			log = new Logger( logfile, true, echo );
 		}
 		else {
 			log = nullptr;
 		}
+
+		maxLines = std::max( maxLines, 1u );
+		lines.resize( maxLines );
+		arena.resize( maxLines * MESSAGEBUFFER_BYTES_PER_LINE );
 	}
 	MessageBuffer::~MessageBuffer() {
+		pendingLine_t *line = pending.exchange( nullptr, std::memory_order_acquire );
+		while ( line ) {
+			pendingLine_t *next = line->next;
+			::operator delete( line );
+			line = next;
+		}
 		delete log;
 	}
 
-	void MessageBuffer::Append( std::string message ) {
-		buffer.push_back( message );
+	void MessageBuffer::PopFront( void ) {
+		firstLine++;
+		numLines--;
+	}
+
+	void MessageBuffer::Store( const char *text, uint32_t length ) {
+		const uint32_t arenaSize = static_cast<uint32_t>( arena.size() );
+		length = std::min( length, arenaSize );
+
+		if ( numLines == lines.size() ) {
+			PopFront();
+		}
+
+		// lines are stored one after another, wrapping to the start of the arena when the next one doesn't fit
+		// the lines after the write offset are the oldest, so they're dropped in order until there's room
+		auto Oldest = [this]( void ) -> const lineRecord_t & {
+			return lines[firstLine % lines.size()];
+		};
+		if ( writeOffset + length > arenaSize ) {
+			while ( numLines && Oldest().offset >= writeOffset ) {
+				PopFront();
+			}
+			writeOffset = 0u;
+		}
+		while ( numLines && Oldest().offset >= writeOffset && Oldest().offset < writeOffset + length ) {
+			PopFront();
+		}
 
+		std::memcpy( &arena[writeOffset], text, length );
+		lineRecord_t &record = lines[(firstLine + numLines) % lines.size()];
+		record.offset = writeOffset;
+		record.length = length;
+		numLines++;
+		writeOffset += length;
+	}
+
+	void MessageBuffer::Append( const char *message, uint32_t length ) {
 		if ( log ) {
-			log->Print( message.c_str() );
+			log->Print( message, length );
+		}
+
+		if ( std::this_thread::get_id() == owner ) {
+			// anything other threads appended first goes before this
+			Pump();
+			Store( message, length );
+			return;
 		}
+
+		const size_t size = offsetof( pendingLine_t, text ) + length;
+		pendingLine_t *line = static_cast<pendingLine_t *>( ::operator new( size ) );
+		line->length = length;
+		std::memcpy( line->text, message, length );
+
+		pendingLine_t *next = pending.load( std::memory_order_relaxed );
+		do {
+			line->next = next;
+		} while ( !pending.compare_exchange_weak( next, line, std::memory_order_release, std::memory_order_relaxed ) );
 	}
 
-	bool MessageBuffer::IsEmpty( void ) const {
-		return buffer.empty(); 
+	void MessageBuffer::Pump( void ) {
+		SDL_assert( std::this_thread::get_id() == owner && "MessageBuffer::Pump: called from another thread" );
+
+		// take everything appended so far, and put it back in the order it was appended
+		pendingLine_t *line = pending.exchange( nullptr, std::memory_order_acquire );
+		pendingLine_t *ordered = nullptr;
+		while ( line ) {
+			pendingLine_t *next = line->next;
+			line->next = ordered;
+			ordered = line;
+			line = next;
+		}
+
+		while ( ordered ) {
+			pendingLine_t *next = ordered->next;
+			Store( ordered->text, ordered->length );
+			::operator delete( ordered );
+			ordered = next;
+		}
 	}
 
-	std::vector<std::string> MessageBuffer::FetchLines( uint32_t start, uint32_t count ) const {
-		const uint32_t size = GetNumLines();
-		const uint32_t begin = std::min( size, start );
-		const uint32_t end = std::min( begin + count, size );
+	void MessageBuffer::Resize( uint32_t maxLines ) {
+		maxLines = std::max( maxLines, 1u );
+		if ( maxLines == lines.size() ) {
+			return;
+		}
 
-		return std::vector<std::string>( buffer.begin() + begin, buffer.begin() + end );
+		// keep the newest lines, oldest first so they keep their order
+		const uint32_t keep = std::min( numLines, maxLines );
+		std::vector<std::string> kept;
+		kept.reserve( keep );
+		for ( uint32_t line = GetEndLine() - keep; line != GetEndLine(); line++ ) {
+			const messageLine_t view = GetLine( line );
+			kept.push_back( std::string( view.text, view.length ) );
+		}
+
+		const uint32_t keptFirstLine = GetEndLine() - keep;
+		lines.assign( maxLines, lineRecord_t() );
+		arena.assign( maxLines * MESSAGEBUFFER_BYTES_PER_LINE, '\0' );
+		arena.shrink_to_fit();
+		lines.shrink_to_fit();
+		writeOffset = 0u;
+		firstLine = keptFirstLine;
+		numLines = 0u;
+		for ( const auto &it : kept ) {
+			Store( it.c_str(), static_cast<uint32_t>( it.length() ) );
+		}
+	}
+
+	void MessageBuffer::FlushLog( void ) {
+		if ( log ) {
+			log->Flush();
+		}
+	}
+
+	bool MessageBuffer::IsEmpty( void ) const {
+		return numLines == 0u;
 	}
 
 	uint32_t MessageBuffer::GetNumLines( void ) const {
-		return static_cast<uint32_t>( buffer.size() );
+		return numLines;
+	}
+
+	messageLine_t MessageBuffer::GetLine( uint32_t line ) const {
+		SDL_assert( line - firstLine < numLines && "MessageBuffer::GetLine: line is not in the buffer" );
+
+		const lineRecord_t &record = lines[line % lines.size()];
+		return { arena.data() + record.offset, record.length };
 	}
 
 } // namespace XS
@@ -1,16 +1,61 @@
 #pragma once
 
-#include <vector>
+#include <atomic>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace XS {
 
 	class Logger;
 
+	#define MESSAGEBUFFER_DEFAULT_LINES (1024u)
+	#define MESSAGEBUFFER_BYTES_PER_LINE (128u) // the arena holds this much per line on average
+
+	// a view of a line in a MessageBuffer, valid until the next Append or Resize
+	struct messageLine_t {
+		const char	*text; // not null-terminated
+		uint32_t	 length;
+	};
+
+	// the most recent lines appended, in a fixed number of line records and a fixed size character arena
+	// the oldest lines are dropped when either runs out, so memory is bounded however long it runs
+	// lines are numbered in the order they were appended, and keep their number while they're in the buffer
+	// any thread can append, but only the thread that created the buffer reads it or stores lines in it. lines
+	//	appended by other threads are logged straight away, then wait on a lock-free list until that thread pumps them
 	class MessageBuffer {
 	private:
-		std::vector<std::string>	 buffer;
+		struct lineRecord_t {
+			uint32_t	offset; // into the arena
+			uint32_t	length;
+		};
+
+		// allocated along with its text, so a line is one allocation
+		struct pendingLine_t {
+			pendingLine_t	*next;
+			uint32_t		 length;
+			char			 text[1];
+		};
+
+		std::vector<char>			 arena;
+		std::vector<lineRecord_t>	 lines; // ring, indexed by line number
+		uint32_t					 writeOffset; // in the arena, just past the newest line
+		uint32_t					 firstLine; // number of the oldest line
+		uint32_t					 numLines;
 		Logger						*log;
+		std::thread::id				 owner; // the thread that created the buffer
+		std::atomic<pendingLine_t *> pending; // appended by other threads, newest first
+
+		// drop the oldest line
+		void PopFront(
+			void
+		);
+
+		// copy a line into the arena, evicting whatever it overlaps
+		void Store(
+			const char *text,
+			uint32_t length
+		);
 
 	public:
 		// don't allow default instantiation
@@ -18,15 +63,32 @@ namespace XS {
 		MessageBuffer( const MessageBuffer& ) = delete;
 		MessageBuffer& operator=( const MessageBuffer& ) = delete;
 
+		// if echo is set, messages are written to stdout along with the log file
 		MessageBuffer(
-			const char *logfile = nullptr
+			const char *logfile = nullptr,
+			bool echo = false,
+			uint32_t maxLines = MESSAGEBUFFER_DEFAULT_LINES
 		);
 
 		~MessageBuffer();
 
-		// append a message to the buffer
+		// append a message to the buffer, from any thread
+		// every message is written to the log, even if it doesn't fit in the buffer, but the log is written by
+		//	another thread so it may not have been by the time this returns
+		// messages from other threads don't show up in the buffer until the owning thread pumps it
 		void Append(
-			std::string message
+			const char *message,
+			uint32_t length
+		);
+
+		// store the lines other threads have appended since the last pump, called by the owning thread
+		void Pump(
+			void
+		);
+
+		// change the number of lines the buffer holds, keeping as many of the newest lines as will fit
+		void Resize(
+			uint32_t maxLines
 		);
 
 		// check if the buffer is empty
@@ -34,16 +96,35 @@ namespace XS {
 			void
 		) const;
 
-		// retrieve count lines from index start
-		std::vector<std::string> FetchLines(
-			uint32_t start,
-			uint32_t count
-		) const;
-
 		// query the number of lines the buffer contains
 		uint32_t GetNumLines(
 			void
 		) const;
+
+		// query the maximum number of lines the buffer can contain
+		inline uint32_t GetMaxLines( void ) const {
+			return static_cast<uint32_t>( lines.size() );
+		}
+
+		// number of the oldest line in the buffer
+		inline uint32_t GetFirstLine( void ) const {
+			return firstLine;
+		}
+
+		// number the next line appended will have, this changes on every Append
+		inline uint32_t GetEndLine( void ) const {
+			return firstLine + numLines;
+		}
+
+		// wait for everything appended so far to be written to the log
+		void FlushLog(
+			void
+		);
+
+		// view a line, which must be in [GetFirstLine(), GetEndLine())
+		messageLine_t GetLine(
+			uint32_t line
+		) const;
 	};
 
 } // namespace XS
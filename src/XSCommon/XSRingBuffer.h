@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+
+namespace XS {
+
+	// a fixed number of values handed from one producer thread to one consumer thread in order, without locking or
+	//	allocating
+	// the producer only writes tail and the consumer only writes head, each publishing what it's done to the other
+	// capacity must be a power of two, one slot is never used so a full ring can be told apart from an empty one
+	template<typename T, size_t capacity>
+	class RingBuffer {
+	private:
+		static_assert( capacity >= 2u && (capacity & (capacity - 1u)) == 0u, "capacity must be a power of two" );
+		static constexpr size_t mask = capacity - 1u;
+
+		// values are constructed when pushed and destroyed when popped, so T doesn't need a default constructor
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type slots[capacity];
+
+		// kept on separate cache lines so the two threads don't fight over them
+		alignas(64) std::atomic<size_t>	head; // next to pop, owned by the consumer
+		alignas(64) std::atomic<size_t>	tail; // next to push, owned by the producer
+
+		inline T *Slot( size_t index ) {
+			return reinterpret_cast<T *>( &slots[index & mask] );
+		}
+
+	public:
+		RingBuffer()
+		: head( 0u ), tail( 0u )
+		{
+		}
+
+		// don't allow copies, the ring is owned by two threads
+		RingBuffer( const RingBuffer& ) = delete;
+		RingBuffer& operator=( const RingBuffer& ) = delete;
+
+		~RingBuffer() {
+			while ( Front() ) {
+				Pop();
+			}
+		}
+
+		// copy a value onto the end, returns false if the ring is full
+		// producer only
+		inline bool Push( const T &value ) {
+			const size_t t = tail.load( std::memory_order_relaxed );
+			if ( ((t + 1u) & mask) == (head.load( std::memory_order_acquire ) & mask) ) {
+				return false;
+			}
+			new( Slot( t ) ) T( value );
+			tail.store( (t + 1u) & mask, std::memory_order_release );
+			return true;
+		}
+
+		// the oldest value, or nullptr if the ring is empty
+		// consumer only, it stays valid until it's popped
+		inline T *Front( void ) {
+			const size_t h = head.load( std::memory_order_relaxed );
+			if ( h == tail.load( std::memory_order_acquire ) ) {
+				return nullptr;
+			}
+			return Slot( h );
+		}
+
+		// drop the oldest value, there must be one
+		// consumer only
+		inline void Pop( void ) {
+			const size_t h = head.load( std::memory_order_relaxed );
+			Slot( h )->~T();
+			head.store( (h + 1u) & mask, std::memory_order_release );
+		}
+	};
+
+} // namespace XS
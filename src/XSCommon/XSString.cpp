@@ -2,6 +2,7 @@
 
 #include "XSCommon/XSCommon.h"
 #include "XSCommon/XSError.h"
+#include "XSCommon/XSFrameArena.h"
 #include "XSCommon/XSString.h"
 
 namespace XS {
@@ -128,30 +129,52 @@ namespace XS {
 			return 0;
 		}
 
-		// by Erik Aronesty http://stackoverflow.com/a/8098080
-		std::string Format( const char *fmt, ... ) {
-			size_t size = 128;
-			std::string str;
-			va_list ap;
+		const char *FormatTempV( const char *fmt, va_list ap, size_t *outLength ) {
+			static thread_local char buffers[FORMAT_TEMP_BUFFERS][FORMAT_TEMP_SIZE];
+			static thread_local uint32_t nextBuffer = 0u;
 
-			while ( 1 ) {
-				str.resize( size );
+			char *out = buffers[nextBuffer];
+			nextBuffer = (nextBuffer + 1u) % FORMAT_TEMP_BUFFERS;
 
-				va_start( ap, fmt );
-				int n = vsnprintf( (char *)str.c_str(), size, fmt, ap );
-				va_end( ap );
+			va_list retry;
+			va_copy( retry, ap );
+			int n = vsnprintf( out, FORMAT_TEMP_SIZE, fmt, ap );
+			if ( n < 0 ) {
+				out[0] = '\0';
+				n = 0;
+			}
+			else if ( static_cast<size_t>( n ) >= FORMAT_TEMP_SIZE ) {
+				out = static_cast<char *>( FrameArena::Allocate( n + 1 ) );
+				vsnprintf( out, n + 1, fmt, retry );
+			}
+			va_end( retry );
 
-				if ( n > -1 && n < (signed)size ) {
-					str.resize( n );
-					return str;
-				}
-				if ( n > -1 ) {
-					size = n + 1;
-				}
-				else {
-					size *= 2;
-				}
+			if ( outLength ) {
+				*outLength = static_cast<size_t>( n );
 			}
+			return out;
+		}
+
+		const char *FormatTemp( const char *fmt, ... ) {
+			va_list ap;
+
+			va_start( ap, fmt );
+			const char *out = FormatTempV( fmt, ap );
+			va_end( ap );
+
+			return out;
+		}
+
+		std::string Format( const char *fmt, ... ) {
+			va_list ap;
+			size_t length;
+
+			// the only allocation is the string itself
+			va_start( ap, fmt );
+			const char *out = FormatTempV( fmt, ap, &length );
+			va_end( ap );
+
+			return std::string( out, length );
 		}
 
 		// by Evan Teran http://stackoverflow.com/a/236803
@@ -188,6 +211,108 @@ namespace XS {
 			return ss.str();
 		}
 
+		static inline bool IsSpace( char c ) {
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		const char *Tokenizer::Tokenize( const char *text, const char *end ) {
+			tokens.clear();
+
+			// find the end of the line first, so the buffer only has to fit this line
+			const char *stop = text;
+			while ( stop != end && *stop != '\n' ) {
+				stop++;
+			}
+
+			// a token is never longer than the text it came from, plus its terminator
+			const size_t maxLength = 2u * static_cast<size_t>( stop - text ) + 1u;
+			if ( buffer.size() < maxLength ) {
+				buffer.resize( maxLength );
+			}
+
+			char *out = buffer.data();
+			const char *p = text;
+			while ( true ) {
+				while ( p != stop && IsSpace( *p ) ) {
+					p++;
+				}
+				if ( p == stop ) {
+					break;
+				}
+
+				// quotes can start and end anywhere in a token, e.g. "a b"c is one token: a bc
+				token_t token;
+				token.text = out;
+				bool quoted = false;
+				for ( ; p != stop && (quoted || !IsSpace( *p )); p++ ) {
+					if ( *p == '"' ) {
+						quoted = !quoted;
+					}
+					else {
+						*out++ = *p;
+					}
+				}
+				token.length = static_cast<uint32_t>( out - token.text );
+				*out++ = '\0';
+				tokens.push_back( token );
+			}
+
+			return (stop != end) ? stop + 1 : end;
+		}
+
+		uint32_t DecodeUTF8( const char **p, const char *end ) {
+			static const uint32_t replacement = 0xFFFDu;
+			const uint8_t *in = reinterpret_cast<const uint8_t *>( *p );
+			const uint8_t lead = *in;
+
+			// leading byte gives the length, and the smallest codepoint that needs that length
+			uint32_t length, codepoint, minimum;
+			if ( lead < 0x80u ) {
+				*p += 1;
+				return lead;
+			}
+			else if ( (lead & 0xE0u) == 0xC0u ) {
+				length = 2u;
+				codepoint = lead & 0x1Fu;
+				minimum = 0x80u;
+			}
+			else if ( (lead & 0xF0u) == 0xE0u ) {
+				length = 3u;
+				codepoint = lead & 0x0Fu;
+				minimum = 0x800u;
+			}
+			else if ( (lead & 0xF8u) == 0xF0u ) {
+				length = 4u;
+				codepoint = lead & 0x07u;
+				minimum = 0x10000u;
+			}
+			else {
+				*p += 1;
+				return replacement;
+			}
+
+			if ( end - *p < static_cast<ptrdiff_t>( length ) ) {
+				*p += 1;
+				return replacement;
+			}
+			for ( uint32_t i = 1u; i < length; i++ ) {
+				if ( (in[i] & 0xC0u) != 0x80u ) {
+					*p += 1;
+					return replacement;
+				}
+				codepoint = (codepoint << 6) | (in[i] & 0x3Fu);
+			}
+
+			// overlong encodings, surrogates and anything past the last plane are invalid
+			if ( codepoint < minimum || codepoint > 0x10FFFFu || (codepoint >= 0xD800u && codepoint <= 0xDFFFu) ) {
+				*p += 1;
+				return replacement;
+			}
+
+			*p += length;
+			return codepoint;
+		}
+
 	} // namespace String
 
 } // namespace XS
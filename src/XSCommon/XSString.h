@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdarg>
 #include <string>
 #include <vector>
 
@@ -7,6 +8,9 @@ namespace XS {
 
 	namespace String {
 
+		#define FORMAT_TEMP_SIZE (1024u)
+		#define FORMAT_TEMP_BUFFERS (4u)
+
 		// C string manipulation
 
 		void Concatenate(
@@ -40,6 +44,24 @@ namespace XS {
 			size_t len = 4096
 		);
 
+		// format into one of a few thread-local buffers, so nothing is allocated
+		// the buffer is reused FORMAT_TEMP_BUFFERS calls to FormatTemp, FormatTempV or Format later on the same
+		//	thread, so use the result straight away or copy it rather than keep the pointer across those calls
+		// anything longer than FORMAT_TEMP_SIZE is formatted into the frame arena instead, and lasts until the end
+		//	of the frame
+		const char *FormatTemp(
+			const char *fmt,
+			...
+		);
+
+		// as FormatTemp, with the arguments already started, ap is consumed
+		// returns the length of the formatted string in outLength if it's set
+		const char *FormatTempV(
+			const char *fmt,
+			va_list ap,
+			size_t *outLength = nullptr
+		);
+
 		// std::string manipulation
 		std::string Format(
 			const char *fmt,
@@ -62,6 +84,62 @@ namespace XS {
 			const std::string &separator
 		);
 
+		// tokenizing
+
+		// a token produced by a Tokenizer, pointing into the tokenizer's buffer
+		struct token_t {
+			const char	*text; // null-terminated
+			uint32_t	 length;
+
+			inline const char *c_str( void ) const {
+				return text;
+			}
+		};
+
+		// splits a line into whitespace separated tokens
+		// text in double quotes is part of the same token even if it contains whitespace, and the quotes are dropped
+		//	e.g. set name "hello world" is three tokens: set, name and hello world
+		// tokens are copied into a buffer that's reused, so nothing is allocated once it has grown to fit, and they
+		//	stay valid until the next call to Tokenize
+		class Tokenizer {
+		private:
+			std::vector<char>		buffer;
+			std::vector<token_t>	tokens;
+
+		public:
+			// tokenize text up to the first linefeed or end, whichever comes first
+			// returns where the next line starts, i.e. just past the linefeed, or end
+			const char *Tokenize(
+				const char *text,
+				const char *end
+			);
+
+			inline size_t size( void ) const {
+				return tokens.size();
+			}
+			inline bool empty( void ) const {
+				return tokens.empty();
+			}
+			inline const token_t &operator[]( size_t index ) const {
+				return tokens[index];
+			}
+			inline const token_t *begin( void ) const {
+				return tokens.data();
+			}
+			inline const token_t *end( void ) const {
+				return tokens.data() + tokens.size();
+			}
+		};
+
+		// UTF-8
+
+		// decode the codepoint starting at *p and move *p past it, never reading at or beyond end
+		// malformed sequences decode to U+FFFD, skipping one byte at a time
+		uint32_t DecodeUTF8(
+			const char **p,
+			const char *end
+		);
+
 	} // namespace String
 
 } // namespace XS
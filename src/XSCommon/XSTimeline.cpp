@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "XSCommon/XSCommon.h"
+#include "XSCommon/XSCommand.h"
+#include "XSCommon/XSConsole.h"
+#include "XSCommon/XSJob.h"
+#include "XSCommon/XSString.h"
+#include "XSCommon/XSTimeline.h"
+#include "XSCommon/XSTimer.h"
+
+namespace XS {
+
+	namespace Timeline {
+
+		#define TIMELINE_BAR_WIDTH (40u)
+
+		struct span_t {
+			char				name[TIMELINE_NAME_SIZE];
+			uint64_t			start, end; // nanoseconds since launch
+			uint32_t			thread; // job system thread index
+			std::atomic<bool>	done; // the rest has been written
+		};
+
+		// close enough to launch, it's set while the executable's globals are initialised
+		static const uint64_t origin = Timer::GetNanoseconds();
+
+		static span_t spans[TIMELINE_MAX_SPANS];
+		static std::atomic<uint32_t> numSpans( 0u );
+		static std::atomic<bool> recording( true );
+		static uint64_t firstFrame = 0u;
+
+		Span::Span( const char *spanName )
+		: start( 0u )
+		{
+			if ( recording.load( std::memory_order_relaxed ) ) {
+				start = Timer::GetNanoseconds();
+				String::Copy( name, spanName, sizeof(name) );
+			}
+		}
+
+		Span::~Span() {
+			if ( !start || !recording.load( std::memory_order_relaxed ) ) {
+				return;
+			}
+
+			const uint32_t index = numSpans.fetch_add( 1u, std::memory_order_relaxed );
+			if ( index >= TIMELINE_MAX_SPANS ) {
+				return;
+			}
+
+			span_t &span = spans[index];
+			std::memcpy( span.name, name, sizeof(span.name) );
+			span.start = start - origin;
+			span.end = Timer::GetNanoseconds() - origin;
+			span.thread = Job::GetThreadIndex();
+			span.done.store( true, std::memory_order_release );
+		}
+
+		// every span of the same name on the same thread, e.g. one per glyph, is shown as one row
+		struct row_t {
+			const char	*name;
+			uint32_t	thread;
+			uint64_t	start, end;
+			uint64_t	busy;
+			uint32_t	count;
+		};
+
+		// show what every thread was doing until the first frame
+		//	timeline
+		static void Cmd_Timeline( const commandContext_t * const context ) {
+			if ( recording.load( std::memory_order_relaxed ) ) {
+				console.Print( "The first frame hasn't been presented yet\n" );
+				return;
+			}
+
+			std::vector<row_t> rows;
+			const uint32_t count = std::min( numSpans.load( std::memory_order_relaxed ), TIMELINE_MAX_SPANS );
+			for ( uint32_t i = 0u; i < count; i++ ) {
+				const span_t &span = spans[i];
+				if ( !span.done.load( std::memory_order_acquire ) ) {
+					continue;
+				}
+
+				auto row = std::find_if( rows.begin(), rows.end(), [&span]( const row_t &r ) {
+					return r.thread == span.thread && !strcmp( r.name, span.name );
+				} );
+				if ( row == rows.end() ) {
+					rows.push_back( { span.name, span.thread, span.start, span.end, 0u, 0u } );
+					row = rows.end() - 1;
+				}
+				row->start = std::min( row->start, span.start );
+				row->end = std::max( row->end, span.end );
+				row->busy += span.end - span.start;
+				row->count++;
+			}
+			std::sort( rows.begin(), rows.end(), []( const row_t &a, const row_t &b ) {
+				return a.start < b.start;
+			} );
+
+			console.Print( "Startup timeline, first frame presented after %.1f ms\n", firstFrame * 0.000001 );
+			Indent indent( 1 );
+			console.Print( "%-8s %-32s %9s %9s %9s\n", "thread", "span", "start ms", "end ms", "busy ms" );
+			const real64_t columnsPerNsec = static_cast<real64_t>( TIMELINE_BAR_WIDTH )
+				/ std::max<uint64_t>( firstFrame, 1u );
+			for ( const auto &row : rows ) {
+				char thread[16];
+				if ( row.thread == 0u ) {
+					String::Copy( thread, "main", sizeof(thread) );
+				}
+				else if ( row.thread == JOB_NO_THREAD ) {
+					String::Copy( thread, "other", sizeof(thread) );
+				}
+				else {
+					String::FormatBuffer( thread, sizeof(thread), "job %u", row.thread );
+				}
+
+				// where the span sits between launch and the first frame
+				char bar[TIMELINE_BAR_WIDTH + 1u];
+				const uint32_t first = std::min( static_cast<uint32_t>( row.start * columnsPerNsec ),
+					TIMELINE_BAR_WIDTH - 1u );
+				const uint32_t last = std::max( std::min( static_cast<uint32_t>( row.end * columnsPerNsec ),
+					TIMELINE_BAR_WIDTH - 1u ), first );
+				for ( uint32_t i = 0u; i < TIMELINE_BAR_WIDTH; i++ ) {
+					bar[i] = (i >= first && i <= last) ? '#' : '.';
+				}
+				bar[TIMELINE_BAR_WIDTH] = '\0';
+
+				const char *name = (row.count > 1u) ? String::FormatTemp( "%s x%u", row.name, row.count ) : row.name;
+				console.Print( "%-8s %-32s %9.1f %9.1f %9.1f %s\n", thread, name, row.start * 0.000001,
+					row.end * 0.000001, row.busy * 0.000001, bar );
+			}
+		}
+
+		void Init( void ) {
+			Command::AddCommand( "timeline", Cmd_Timeline );
+		}
+
+		void EndStartup( void ) {
+			bool expected = true;
+			if ( !recording.compare_exchange_strong( expected, false ) ) {
+				return;
+			}
+
+			firstFrame = Timer::GetNanoseconds() - origin;
+			console.DebugPrint( "First frame presented %.0f milliseconds after launch\n", firstFrame * 0.000001 );
+		}
+
+	} // namespace Timeline
+
+} // namespace XS
@@ -0,0 +1,44 @@
+#pragma once
+
+namespace XS {
+
+	// what each thread spent its time on from launch until the first frame was presented, to see what overlaps
+	// spans are recorded from any thread without locking, anything after the first frame isn't kept
+	namespace Timeline {
+
+		#define TIMELINE_MAX_SPANS (1024u)
+		#define TIMELINE_NAME_SIZE (48u)
+
+		// times the scope it lives in, e.g.
+		//	Timeline::Span span( "shaders" );
+		class Span {
+		private:
+			uint64_t	start;
+			char		name[TIMELINE_NAME_SIZE];
+
+		public:
+			// don't allow default instantiation
+			Span() = delete;
+			Span( const Span& ) = delete;
+			Span& operator=( const Span& ) = delete;
+
+			Span(
+				const char *name
+			);
+
+			~Span();
+		};
+
+		// register the timeline command
+		void Init(
+			void
+		);
+
+		// stop recording once the first frame has been presented, only the first call does anything
+		void EndStartup(
+			void
+		);
+
+	} // namespace Timeline
+
+} // namespace XS
@@ -1,3 +1,9 @@
+#if defined(XS_OS_WINDOWS)
+	#include <Windows.h>
+#elif defined(XS_OS_LINUX) || defined(XS_OS_MAC)
+	#include <time.h>
+#endif
+
 #include "XSCommon/XSCommon.h"
 #include "XSCommon/XSTimer.h"
 
@@ -11,48 +17,37 @@ namespace XS {
 	}
 
 	void Timer::Start( void ) {
-	#if defined(XS_OS_WINDOWS)
-		QueryPerformanceCounter( &start );
-	#elif defined(XS_OS_LINUX) || defined(XS_OS_MAC)
-		gettimeofday( &start, nullptr );
-	#endif
+		start = GetNanoseconds();
 	}
 
 	void Timer::Stop( void ) {
-	#if defined(XS_OS_WINDOWS)
-		QueryPerformanceCounter( &stop );
-	#elif defined(XS_OS_LINUX) || defined(XS_OS_MAC)
-		gettimeofday( &stop, nullptr );
-	#endif
+		stop = GetNanoseconds();
 	}
 
-	double Timer::GetTiming( bool restart, Resolution resolution ) {
+	uint64_t Timer::GetElapsed( bool restart ) {
 		Stop();
-
-	#if defined(XS_OS_WINDOWS)
-		timeVal_t frequency;
-		QueryPerformanceFrequency( &frequency );
-
-		double startTime = start.QuadPart * (1000000.0 / frequency.QuadPart);
-		double stopTime = stop.QuadPart * (1000000.0 / frequency.QuadPart);
-	#elif defined(XS_OS_LINUX) || defined(XS_OS_MAC)
-		double startTime = (start.tv_sec * 1000000.0) + start.tv_usec;
-		double stopTime = (stop.tv_sec * 1000000.0) + stop.tv_usec;
-	#endif
+		const uint64_t elapsed = stop - start;
 
 		if ( restart ) {
-			Start();
+			start = stop;
 		}
 
+		return elapsed;
+	}
+
+	double Timer::GetTiming( bool restart, Resolution resolution ) {
+		// only the difference is converted, so there's no precision lost however long the clock has been running
+		const double elapsed = static_cast<double>( GetElapsed( restart ) );
+
 		switch ( resolution ) {
 		case Resolution::SECONDS: {
-			return (stopTime - startTime) * 0.000001;
+			return elapsed * 0.000000001;
 		} break;
 		case Resolution::MILLISECONDS: {
-			return (stopTime - startTime) * 0.001;
+			return elapsed * 0.000001;
 		} break;
 		case Resolution::MICROSECONDS: {
-			return (stopTime - startTime);
+			return elapsed * 0.001;
 		} break;
 		default: {
 			SDL_assert( !"Invalid timer resolution" );
@@ -61,4 +56,24 @@ namespace XS {
 		}
 	}
 
+	uint64_t Timer::GetNanoseconds( void ) {
+	#if defined(XS_OS_WINDOWS)
+		static LARGE_INTEGER frequency = {};
+		if ( !frequency.QuadPart ) {
+			QueryPerformanceFrequency( &frequency );
+		}
+
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter( &counter );
+
+		// split up so the multiply can't overflow
+		const uint64_t ticks = counter.QuadPart, hz = frequency.QuadPart;
+		return ((ticks / hz) * 1000000000u) + (((ticks % hz) * 1000000000u) / hz);
+	#elif defined(XS_OS_LINUX) || defined(XS_OS_MAC)
+		struct timespec ts;
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+		return (static_cast<uint64_t>( ts.tv_sec ) * 1000000000u) + static_cast<uint64_t>( ts.tv_nsec );
+	#endif
+	}
+
 } // namespace XS
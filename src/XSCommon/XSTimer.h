@@ -1,22 +1,11 @@
 #pragma once
 
-#if defined(XS_OS_WINDOWS)
-	#include <Windows.h>
-#elif defined(XS_OS_LINUX) || defined(XS_OS_MAC)
-	#include <sys/time.h>
-#endif
-
 namespace XS {
 
-	#if defined(XS_OS_WINDOWS)
-		typedef LARGE_INTEGER timeVal_t;
-	#elif defined(XS_OS_LINUX) || defined(XS_OS_MAC)
-		typedef struct timeval timeVal_t;
-	#endif
-
+	// measures time on a monotonic clock in integer nanoseconds, so it never jumps when the system time changes
 	class Timer {
 	private:
-		timeVal_t start, stop;
+		uint64_t start, stop; // nanoseconds on the monotonic clock
 
 	public:
 		enum class Resolution {
@@ -37,11 +26,21 @@ namespace XS {
 			void
 		);
 
+		// get the current elapsed time in nanoseconds, optionally resetting the timer to the current time
+		uint64_t GetElapsed(
+			bool restart = false
+		);
+
 		// get the current elapsed time, optionally resetting the timer to the current time
 		double GetTiming(
 			bool restart = false,
 			Resolution resolution = Resolution::MICROSECONDS
 		);
+
+		// the current time on the monotonic clock in nanoseconds, from an arbitrary starting point
+		static uint64_t GetNanoseconds(
+			void
+		);
 	};
 
 } // namespace XS
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+
+namespace XS {
+
+	// hands the latest of a stream of values from one producer thread to one consumer thread without locking
+	// the producer always has a slot of its own to write, the consumer always has the most recently published slot
+	//	to read, and the third slot is swapped between them, so neither ever waits on the other
+	// a slot handed back to the producer holds an old value, so it must be completely rewritten before publishing
+	template<typename T>
+	class TripleBuffer {
+	private:
+		// set on the shared slot index when it holds a value the consumer hasn't seen yet
+		static constexpr uint8_t fresh = 0x4u;
+		static constexpr uint8_t indexMask = 0x3u;
+
+		T						slots[3];
+		std::atomic<uint8_t>	shared;
+		uint8_t					back; // owned by the producer
+		uint8_t					front; // owned by the consumer
+
+	public:
+		TripleBuffer()
+		: shared( 1u ), back( 0u ), front( 2u )
+		{
+		}
+
+		// don't allow copies, the slots are owned by two threads
+		TripleBuffer( const TripleBuffer& ) = delete;
+		TripleBuffer& operator=( const TripleBuffer& ) = delete;
+
+		// the slot to fill in before calling Publish, producer only
+		inline T &Back( void ) {
+			return slots[back];
+		}
+
+		// hand the back slot to the consumer, dropping any value it didn't get to
+		inline void Publish( void ) {
+			back = shared.exchange( back | fresh, std::memory_order_acq_rel ) & indexMask;
+		}
+
+		// swap in the latest published value, returns false if nothing was published since the last call
+		// consumer only
+		inline bool Acquire( void ) {
+			if ( !(shared.load( std::memory_order_relaxed ) & fresh) ) {
+				return false;
+			}
+			front = shared.exchange( front, std::memory_order_acq_rel ) & indexMask;
+			return true;
+		}
+
+		// the latest value taken by Acquire, consumer only
+		inline const T &Front( void ) const {
+			return slots[front];
+		}
+	};
+
+} // namespace XS
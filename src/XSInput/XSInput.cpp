@@ -1,11 +1,16 @@
+#include <mutex>
+#include <thread>
+
 #include <SDL2/SDL.h>
 
 #include "XSCommon/XSCommon.h"
+#include "XSCommon/XSCommand.h"
 #include "XSCommon/XSError.h"
 #include "XSCommon/XSEvent.h"
 #include "XSCommon/XSConsole.h"
 #include "XSInput/XSInput.h"
 #include "XSInput/XSKeys.h"
+#include "XSRenderer/XSRenderer.h"
 
 namespace XS {
 
@@ -20,7 +25,57 @@ namespace XS {
 			SDL_SetRelativeMouseMode( SDL_TRUE );
 		}
 
+		// lines read from stdin when running headless, appended to the command buffer by Poll
+		static std::mutex stdinMutex;
+		static std::string stdinText;
+
+		// fgets blocks, so stdin is read on its own thread and the main loop never waits on it
+		// the thread is left detached, it stops at the end of the input or with the process
+		static void ReadStdin( void ) {
+			char line[1024];
+			while ( fgets( line, sizeof(line), stdin ) ) {
+				std::lock_guard<std::mutex> lock( stdinMutex );
+				stdinText += line;
+			}
+
+			// run the last line even if it wasn't terminated
+			std::lock_guard<std::mutex> lock( stdinMutex );
+			stdinText += '\n';
+		}
+
+		static void PollStdin( void ) {
+			static bool reading = false;
+			if ( !reading ) {
+				reading = true;
+				std::thread( ReadStdin ).detach();
+			}
+
+			static std::string text;
+			{
+				std::lock_guard<std::mutex> lock( stdinMutex );
+				text.swap( stdinText );
+			}
+			if ( !text.empty() ) {
+				// a line can be split over two reads if it's too long for the buffer, it's only run once it's whole
+				const size_t end = text.rfind( '\n' );
+				if ( end != std::string::npos ) {
+					text[end] = '\0';
+					Command::Append( text.c_str() );
+					text.erase( 0, end + 1 );
+				}
+				std::lock_guard<std::mutex> lock( stdinMutex );
+				stdinText.insert( 0, text );
+				text.clear();
+			}
+		}
+
 		void Input::Poll( void ) const {
+			// there's no window to take events from, commands come from the command line and stdin
+			if ( Renderer::IsHeadless() ) {
+				PollStdin();
+				return;
+			}
+
 			SDL_Event e;
 			while ( SDL_PollEvent( &e ) ) {
 				switch ( e.type ) {
@@ -191,7 +191,7 @@ namespace XS {
 			const size_t size = context->size();
 			std::string value;
 			for ( size_t i = 1; i < size; i++ ) {
-				value += (*context)[i];
+				value.append( (*context)[i].text, (*context)[i].length );
 				if ( i != size-1 ) {
 					value += " ";
 				}
@@ -1,4 +1,9 @@
+#include <mutex>
+#include <string>
+#include <thread>
+
 #include "XSCommon/XSCommon.h"
+#include "XSCommon/XSConsole.h"
 #include "XSCommon/XSCvar.h"
 #include "XSCommon/XSCommand.h"
 #include "XSRenderer/XSRenderer.h"
@@ -14,7 +19,15 @@ namespace XS {
 			GLuint defaultVao = 0u;
 			GLuint defaultPbo = 0u;
 
+			frameStats_t frameStats = {};
+
+			static std::thread::id mainThread;
+			static std::mutex printMutex;
+			static std::string pendingPrints;
+
 			void Init( void ) {
+				mainThread = std::this_thread::get_id();
+
 				Command::AddCommand( "screenshot", Cmd_Screenshot );
 
 				glClearColor( 0.0f, 0.0f, 0.0f, 1.0f );
@@ -47,6 +60,36 @@ namespace XS {
 			void Shutdown( void ) {
 				glDeleteVertexArrays( 1, &defaultVao );
 				glDeleteBuffers( 1, &defaultPbo );
+
+				FlushPrints();
+			}
+
+			void Print( const char *fmt, ... ) {
+				char text[1024];
+				va_list ap;
+				va_start( ap, fmt );
+				vsnprintf( text, sizeof(text), fmt, ap );
+				va_end( ap );
+
+				if ( std::this_thread::get_id() == mainThread ) {
+					console.Print( "%s", text );
+					return;
+				}
+
+				std::lock_guard<std::mutex> lock( printMutex );
+				pendingPrints += text;
+			}
+
+			void FlushPrints( void ) {
+				std::string text;
+				{
+					std::lock_guard<std::mutex> lock( printMutex );
+					text.swap( pendingPrints );
+				}
+
+				if ( !text.empty() ) {
+					console.Print( "%s", text.c_str() );
+				}
 			}
 
 		} // namespace Backend
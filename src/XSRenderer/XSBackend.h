@@ -11,6 +11,9 @@ namespace XS {
 			extern GLuint defaultVao;
 			extern GLuint defaultPbo;
 
+			// counters for the frame being rendered, reset by Renderer::Update
+			extern frameStats_t frameStats;
+
 			void Init(
 				void
 			);
@@ -19,6 +22,18 @@ namespace XS {
 				void
 			);
 
+			// print to the console from the backend
+			// the console belongs to the main thread, so prints from the render thread are held until FlushPrints
+			void Print(
+				const char *fmt,
+				...
+			);
+
+			// pass on anything printed by the render thread, called by the main thread
+			void FlushPrints(
+				void
+			);
+
 		} // namespace Backend
 
 	} // namespace Renderer
@@ -1,5 +1,6 @@
 #include "XSCommon/XSCommon.h"
 #include "XSRenderer/XSRenderer.h"
+#include "XSRenderer/XSBackend.h"
 #include "XSRenderer/XSBuffer.h"
 
 namespace XS {
@@ -28,20 +29,83 @@ namespace XS {
 				}
 			}
 
+			// slot in Buffer::boundBuffers
+			static size_t GetBindingSlot( GLenum type ) {
+				switch ( type ) {
+				default:
+				case GL_ARRAY_BUFFER: {
+					return 0u;
+				} break;
+
+				case GL_ELEMENT_ARRAY_BUFFER: {
+					return 1u;
+				} break;
+
+				case GL_UNIFORM_BUFFER: {
+					return 2u;
+				} break;
+				}
+			}
+
+			GLuint Buffer::boundBuffers[3] = {};
+			Buffer::boundRange_t Buffer::boundRanges[BUFFER_MAX_BINDINGS] = {};
+
 			GLuint Buffer::GetID( void ) const {
 				return id;
 			}
 
 			Buffer::Buffer( Type type, const void *data, size_t size )
-			: type( GetGLBufferType( type ) ), size( size )
+			: type( GetGLBufferType( type ) ), size( size ), streaming( false ), persistentData( nullptr ),
+				segmentSize( 0u ), segment( 0u ), writeOffset( 0u ), fences()
 			{
 				glGenBuffers( 1, &id );
-				glBindBuffer( this->type, id );
+				Bind();
 				glBufferData( this->type, size, data, GL_STREAM_DRAW );
 			}
 
+			Buffer::Buffer( Type type, size_t segmentSize )
+			: type( GetGLBufferType( type ) ), size( segmentSize * BUFFER_STREAM_SEGMENTS ), streaming( true ),
+				persistentData( nullptr ), segmentSize( segmentSize ), segment( 0u ), writeOffset( 0u ), fences()
+			{
+				glGenBuffers( 1, &id );
+				Bind();
+
+				if ( GLEW_ARB_buffer_storage ) {
+					// coherent, so writes are visible to the GPU without flushing or unmapping
+					const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+					glBufferStorage( this->type, size, nullptr, flags );
+					persistentData = static_cast<uint8_t *>( glMapBufferRange( this->type, 0, size, flags ) );
+				}
+				else {
+					glBufferData( this->type, size, nullptr, GL_STREAM_DRAW );
+				}
+			}
+
 			Buffer::~Buffer() {
+				for ( auto &fence : fences ) {
+					if ( fence ) {
+						glDeleteSync( fence );
+					}
+				}
+
+				if ( persistentData ) {
+					Bind();
+					glUnmapBuffer( type );
+				}
+
 				glDeleteBuffers( 1, &id );
+
+				// deleting a buffer unbinds it everywhere
+				for ( auto &bound : boundBuffers ) {
+					if ( bound == id ) {
+						bound = 0u;
+					}
+				}
+				for ( auto &range : boundRanges ) {
+					if ( range.id == id ) {
+						range = {};
+					}
+				}
 			}
 
 			void *Buffer::Map( void ) {
@@ -49,16 +113,96 @@ namespace XS {
 				return glMapBufferRange( type, 0, size, GL_MAP_WRITE_BIT );
 			}
 
+			void Buffer::Update( const void *data, size_t dataSize ) {
+				SDL_assert( !streaming && dataSize <= size && "Buffer::Update: invalid update" );
+
+				Bind();
+				// orphan the old storage first, so a draw that's still reading it doesn't make the write wait
+				glBufferData( type, size, nullptr, GL_STREAM_DRAW );
+				glBufferSubData( type, 0, dataSize, data );
+			}
+
+			void *Buffer::MapStream( size_t size, size_t *outOffset ) {
+				SDL_assert( streaming && size <= segmentSize && "Buffer::MapStream: invalid allocation" );
+
+				if ( writeOffset + size > segmentSize ) {
+					NextSegment();
+				}
+
+				const size_t offset = (segment * segmentSize) + writeOffset;
+				writeOffset = (writeOffset + size + BUFFER_STREAM_ALIGNMENT - 1) & ~(BUFFER_STREAM_ALIGNMENT - 1);
+				*outOffset = offset;
+
+				Bind();
+				if ( persistentData ) {
+					return persistentData + offset;
+				}
+
+				// nothing the GPU may still be reading is handed out, so there's no need for the driver to sync
+				return glMapBufferRange( type, offset, size,
+					GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
+			}
+
 			void Buffer::Unmap( void ) {
+				if ( persistentData ) {
+					return;
+				}
 				glUnmapBuffer( type );
 			}
 
+			void Buffer::NextSegment( void ) {
+				fences[segment] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+				segment = (segment + 1u) % BUFFER_STREAM_SEGMENTS;
+				writeOffset = 0u;
+
+				GLsync &fence = fences[segment];
+				if ( fence ) {
+					GLenum result;
+					do {
+						result = glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000u );
+					} while ( result == GL_TIMEOUT_EXPIRED );
+					glDeleteSync( fence );
+					fence = nullptr;
+				}
+			}
+
+			void Buffer::EndFrame( void ) {
+				SDL_assert( streaming && "Buffer::EndFrame: not a streaming buffer" );
+
+				// nothing to fence if nothing was written
+				if ( writeOffset ) {
+					NextSegment();
+				}
+			}
+
 			void Buffer::BindRange( int index ) const {
+				if ( index >= 0 && index < BUFFER_MAX_BINDINGS ) {
+					boundRange_t &range = boundRanges[index];
+					if ( range.id == id && range.offset == 0u && range.size == size ) {
+						Backend::frameStats.bindsSkipped++;
+						return;
+					}
+					range.id = id;
+					range.offset = 0u;
+					range.size = size;
+				}
+
+				// also binds the generic binding point
 				glBindBufferRange( type, index, id, 0, size );
+				boundBuffers[GetBindingSlot( type )] = id;
+				Backend::frameStats.bindsIssued++;
 			}
 
 			void Buffer::Bind( void ) const {
+				GLuint &bound = boundBuffers[GetBindingSlot( type )];
+				if ( bound == id ) {
+					Backend::frameStats.bindsSkipped++;
+					return;
+				}
+
 				glBindBuffer( type, id );
+				bound = id;
+				Backend::frameStats.bindsIssued++;
 			}
 
 		} // namespace Backend
@@ -6,6 +6,15 @@ namespace XS {
 
 		namespace Backend {
 
+			// streaming buffers are a ring of segments, a frame writes into one segment which is then fenced
+			// a segment is only written again once the GPU has signalled its fence, so mapping never waits on the
+			//	driver unless the CPU gets this many frames ahead
+			#define BUFFER_STREAM_SEGMENTS (3u)
+			#define BUFFER_STREAM_ALIGNMENT (16u)
+
+			// indexed binding points tracked by the state cache
+			#define BUFFER_MAX_BINDINGS (16)
+
 			class Buffer {
 			public:
 				enum class Type {
@@ -15,10 +24,31 @@ namespace XS {
 				};
 
 			private:
+				// what's bound to each buffer type and uniform block binding point
+				struct boundRange_t {
+					GLuint	id;
+					size_t	offset, size;
+				};
+				static GLuint		boundBuffers[3];
+				static boundRange_t	boundRanges[BUFFER_MAX_BINDINGS];
+
 				GLuint	id;
 				GLenum	type;
 				size_t	size;
 
+				// streaming only
+				bool	 streaming;
+				uint8_t	*persistentData; // mapped for the buffer's lifetime when ARB_buffer_storage is available
+				size_t	 segmentSize;
+				uint32_t	 segment;
+				size_t	 writeOffset; // within the current segment
+				GLsync	 fences[BUFFER_STREAM_SEGMENTS];
+
+				// fence the current segment and wait until the GPU has finished with the next one
+				void NextSegment(
+					void
+				);
+
 			public:
 				// don't allow default instantiation
 				Buffer() = delete;
@@ -31,16 +61,43 @@ namespace XS {
 					size_t dataSize
 				);
 
+				// create a streaming buffer, each frame can write segmentSize bytes before it has to wait on the GPU
+				Buffer(
+					Type type,
+					size_t segmentSize
+				);
+
 				~Buffer();
 
 				void *Map(
 					void
 				);
 
+				// static buffers only
+				// replace the first dataSize bytes, the rest is left undefined
+				void Update(
+					const void *data,
+					size_t dataSize
+				);
+
+				// streaming buffers only
+				// hand out size bytes of the current segment, its offset into the buffer is returned in outOffset
+				// the buffer is left bound, call Unmap once the data is written
+				void *MapStream(
+					size_t size,
+					size_t *outOffset
+				);
+
 				void Unmap(
 					void
 				);
 
+				// streaming buffers only
+				// fence everything written this frame, call once the commands reading it have been issued
+				void EndFrame(
+					void
+				);
+
 				GLuint GetID(
 					void
 				) const;
@@ -1,34 +1,81 @@
+#include <algorithm>
+#include <atomic>
 #include <unordered_map>
 
 #include "XSCommon/XSCommon.h"
+#include "XSCommon/XSAsyncFile.h"
 #include "XSCommon/XSString.h"
 #include "XSCommon/XSFile.h"
 #include "XSCommon/XSConsole.h"
 #include "XSCommon/XSGlobals.h"
 #include "XSCommon/XSCvar.h"
 #include "XSCommon/XSError.h"
+#include "XSCommon/XSJob.h"
+#include "XSCommon/XSTimeline.h"
 #include "XSRenderer/XSRenderer.h"
 #include "XSRenderer/XSFont.h"
 #include "XSRenderer/XSShaderProgram.h"
 #include "XSRenderer/XSVertexAttributes.h"
 #include "XSRenderer/XSMaterial.h"
-#include "XSRenderer/XSImagePNG.h"
 #include "XSRenderer/XSTexture.h"
+#include "XSSystem/XSOS.h"
+
+// references:
+//	Green, "Improved alpha-tested magnification for vector textures and special effects" (2007)
+//	Felzenszwalb & Huttenlocher, "Distance transforms of sampled functions" (2012)
 
 namespace XS {
 
 	namespace Renderer {
 
-		static FT_Library								 ft;
-		static std::unordered_map<std::string, Font *>	 fonts;
-		static ShaderProgram							*fontProgram = nullptr;
-
-		Font::Font( const char *name, uint16_t size )
-		: name( name ), size( size )
-		{
-			file = String::Format( "fonts/%s.ttf", name );
-			std::memset( data, 0u, sizeof(data) );
-		}
+		#define FONT_SDF_SIZE (32u) // every face is rasterised at this size and scaled from there
+		#define FONT_SDF_SPREAD (4u) // texels either side of the edge the distance field covers
+		#define FONT_SDF_UPSCALE (4u) // glyphs are rasterised this much larger, then the distances are sampled down
+		#define FONT_SDF_CELL (64u) // largest glyph in texels in each direction
+		#define FONT_SDF_FAR (1e20)
+
+		#define FONT_PAGE_SIZE (1024u)
+		#define FONT_MAX_PAGES (4u) // per face, 1MB each
+		#define FONT_SHELF_ROUND (8u) // shelf heights are rounded up to this, so similar glyphs share shelves
+		#define FONT_GLYPH_GAP (1u) // texels between glyphs, so filtering doesn't bleed into a neighbour
+
+		#define FONT_CACHE_MAGIC (0x544E4658u) // "XFNT"
+		#define FONT_CACHE_VERSION (2u)
+
+		// a glyph cache is this header, numGlyphs fontCacheGlyph_t, then the R8 distance fields they point to
+		struct fontCacheHeader_t {
+			uint32_t	magic;
+			uint32_t	version;
+			int32_t		ttfTime; // last modified time of the TTF the glyphs were rendered from
+			uint32_t	ttfLength;
+			uint32_t	sdfSize, sdfSpread, sdfUpscale; // the settings the fields were rendered with
+			uint32_t	fontDataSize; // sizeof(FontData), in case the layout changes
+			uint32_t	numGlyphs;
+		};
+
+		struct fontCacheGlyph_t {
+			uint32_t	codepoint;
+			FontData	data; // s and t aren't used, the field is size.x by size.y texels
+			uint32_t	fieldOffset; // from the start of the cache, 0 if there's nothing to draw
+		};
+
+		static FT_Library									 ft;
+		static std::unordered_map<std::string, FontFace *>	 faces;
+		static std::vector<Font *>							 fonts; // every size of every face
+		static ShaderProgram								*fontProgram = nullptr;
+		static std::unordered_map<std::string, std::unique_ptr<AsyncFile>>	 prefetched; // TTFs being read, by path
+
+		// a glyph's distance field being rendered by a job, FreeType isn't touched off the main thread so the
+		//	bitmap is copied out of it first
+		struct fontRaster_t {
+			uint32_t				page, x, y;
+			uint32_t				width, height; // of the field
+			std::vector<uint8_t>	bitmap; // upscaled glyph, tightly packed
+			uint32_t				bitmapWidth, bitmapRows;
+			std::vector<uint8_t>	field;
+			std::atomic<bool>		ready; // field has been written
+			Job::job_t				*job;
+		};
 
 		static Material *CreateFontMaterial( Texture& fontTexture ) {
 			Material *fontMaterial = new Material();
@@ -39,204 +86,692 @@ namespace XS {
 
 			fontMaterial->samplerBindings.push_back( samplerBinding );
 			fontMaterial->shaderProgram = fontProgram;
+			fontMaterial->opaque = true;
 
 			return fontMaterial;
 		}
 
-		void Font::RenderGlyphs( void ) {
-			FT_Face face = nullptr;
+		// squared distance from each of the n samples of f to the nearest zero sample, writing over f
+		// v and z are scratch space for n and n + 1 elements
+		static void DistanceTransform( double *f, size_t n, size_t stride, std::vector<uint32_t> &v,
+			std::vector<double> &z, std::vector<double> &column )
+		{
+			for ( size_t q = 0u; q < n; q++ ) {
+				column[q] = f[q * stride];
+			}
+
+			// lower envelope of the parabolas rooted at each sample
+			size_t k = 0u;
+			v[0] = 0u;
+			z[0] = -FONT_SDF_FAR;
+			z[1] = FONT_SDF_FAR;
+			for ( size_t q = 1u; q < n; q++ ) {
+				double s;
+				while ( true ) {
+					const size_t r = v[k];
+					// difference the samples first, they're both FONT_SDF_FAR away from any edge more often than not
+					s = ((column[q] - column[r]) + static_cast<double>( (q * q) - (r * r) )) / (2.0 * (q - r));
+					if ( s > z[k] || k == 0u ) {
+						break;
+					}
+					k--;
+				}
+				k++;
+				v[k] = static_cast<uint32_t>( q );
+				z[k] = s;
+				z[k + 1] = FONT_SDF_FAR;
+			}
 
-			const File ttf( file.c_str(), FileMode::READ_BINARY );
-			if ( !ttf.open ) {
-				console.Print( "WARNING: Could not load font file \"%s\"\n", ttf.path );
-				return;
+			k = 0u;
+			for ( size_t q = 0u; q < n; q++ ) {
+				while ( z[k + 1] < q ) {
+					k++;
+				}
+				const double delta = static_cast<double>( q ) - v[k];
+				f[q * stride] = (delta * delta) + column[v[k]];
+			}
+		}
+
+		// squared euclidean distance to the nearest zero, separably over columns then rows
+		static void DistanceTransform( std::vector<double> &grid, size_t width, size_t height ) {
+			const size_t n = std::max( width, height );
+			std::vector<uint32_t> v( n );
+			std::vector<double> z( n + 1u );
+			std::vector<double> column( n );
+			for ( size_t x = 0u; x < width; x++ ) {
+				DistanceTransform( &grid[x], height, width, v, z, column );
+			}
+			for ( size_t y = 0u; y < height; y++ ) {
+				DistanceTransform( &grid[y * width], width, 1u, v, z, column );
+			}
+		}
+
+		// write the signed distance field of an upscaled glyph bitmap, tightly packed
+		// 0.5 is the edge, higher values are inside the glyph
+		static void RenderDistanceField( const uint8_t *bitmap, uint32_t bitmapWidth, uint32_t bitmapRows, uint8_t *out,
+			uint32_t outWidth, uint32_t outHeight )
+		{
+			const size_t pad = FONT_SDF_SPREAD * FONT_SDF_UPSCALE;
+			const size_t width = bitmapWidth + (2u * pad);
+			const size_t height = bitmapRows + (2u * pad);
+
+			// distance to the nearest inside texel, and to the nearest outside texel
+			std::vector<double> outside( width * height, FONT_SDF_FAR );
+			std::vector<double> inside( width * height, 0.0 );
+			for ( size_t y = 0u; y < bitmapRows; y++ ) {
+				for ( size_t x = 0u; x < bitmapWidth; x++ ) {
+					if ( bitmap[(y * bitmapWidth) + x] >= 0x80u ) {
+						const size_t index = ((y + pad) * width) + x + pad;
+						outside[index] = 0.0;
+						inside[index] = FONT_SDF_FAR;
+					}
+				}
 			}
+			DistanceTransform( outside, width, height );
+			DistanceTransform( inside, width, height );
+
+			// sample the middle of each upscaled texel
+			const double range = 2.0 * FONT_SDF_SPREAD * FONT_SDF_UPSCALE;
+			const size_t middle = FONT_SDF_UPSCALE / 2u;
+			for ( uint32_t y = 0u; y < outHeight; y++ ) {
+				for ( uint32_t x = 0u; x < outWidth; x++ ) {
+					const size_t sampleX = std::min<size_t>( (x * FONT_SDF_UPSCALE) + middle, width - 1u );
+					const size_t sampleY = std::min<size_t>( (y * FONT_SDF_UPSCALE) + middle, height - 1u );
+					const size_t index = (sampleY * width) + sampleX;
+					const double distance = std::sqrt( inside[index] ) - std::sqrt( outside[index] );
+					const double value = std::min( std::max( 0.5 + (distance / range), 0.0 ), 1.0 );
+					out[(y * outWidth) + x] = static_cast<uint8_t>( value * 255.0 + 0.5 );
+				}
+			}
+		}
+
+		static void RenderGlyph( Job::job_t *job, const void *data ) {
+			fontRaster_t *raster = *static_cast<fontRaster_t * const *>( data );
+			Timeline::Span span( "glyph distance fields" );
+
+			RenderDistanceField( raster->bitmap.data(), raster->bitmapWidth, raster->bitmapRows, raster->field.data(),
+				raster->width, raster->height );
+			raster->ready.store( true, std::memory_order_release );
+		}
 
-			uint8_t *contents = new uint8_t[ttf.length];
-			std::memset( contents, 0, ttf.length );
-			ttf.Read( contents );
+		FontFace::FontFace( const char *name )
+		: face( nullptr ), cache(), ttfTime( 0 ), ttfLength( 0u ), name( name ), lineHeight( 0.0f )
+		{
+			Timeline::Span span( String::FormatTemp( "font %s", name ) );
+
+			file = String::Format( "fonts/%s.ttf", name );
 
-			if ( FT_New_Memory_Face( ft, contents, ttf.length, 0, &face ) ) {
+			// FreeType reads glyphs from the contents for as long as the face is open
+			// the line height is needed to lay out text straight away, so a TTF still being read is waited on
+			bool opened = false;
+			auto it = prefetched.find( file );
+			if ( it != prefetched.end() ) {
+				opened = it->second->Wait();
+				contents.swap( it->second->GetContents() );
+				prefetched.erase( it );
+			}
+			else {
+				const File ttf( file.c_str(), FileMode::READ_BINARY );
+				if ( ttf.open ) {
+					contents.resize( ttf.length );
+					ttf.Read( contents.data() );
+					opened = true;
+				}
+			}
+			if ( !opened ) {
+				console.Print( "WARNING: Could not load font file \"%s\"\n", file.c_str() );
+				return;
+			}
+
+			if ( FT_New_Memory_Face( ft, contents.data(), contents.size(), 0, &face ) ) {
 				console.Print( "WARNING: Could not register font \"%s\"\n", file.c_str() );
-				delete[] contents;
+				face = nullptr;
 				return;
 			}
 
 			const uint32_t dpi = 96;
-			if ( FT_Set_Char_Size( face, size << 6, size << 6, dpi, dpi ) ) {
-				//TODO: appropriate warning message
-				delete[] contents;
+			const uint32_t rasterSize = FONT_SDF_SIZE * FONT_SDF_UPSCALE;
+			if ( FT_Set_Char_Size( face, rasterSize << 6, rasterSize << 6, dpi, dpi ) ) {
+				console.Print( "WARNING: Could not set the size of font \"%s\"\n", file.c_str() );
+				FT_Done_Face( face );
+				face = nullptr;
 				return;
 			}
 
-			const size_t numChars = 256u;
-			const size_t skip = 0x20u;
-			const size_t atlasSize = numChars * size * size;
-			uint8_t *atlas = new uint8_t[atlasSize];
-			std::memset( atlas, 0u, atlasSize );
+			// metrics are in upscaled pixels, 26.6 fixed point
+			lineHeight = static_cast<float>( face->size->metrics.height ) / (64.0f * FONT_SDF_UPSCALE);
 
-			if ( Common::com_developer->GetBool() ) {
-				console.Print( "Generating font atlas for '%s' (%ix%i)\n", name.c_str(), size * 16, size * 16 );
+			char path[XS_MAX_FILENAME];
+			ttfTime = 0;
+			ttfLength = static_cast<uint32_t>( contents.size() );
+			if ( File::GetFullPath( file.c_str(), path, sizeof(path) ) ) {
+				OS::GetFileTime( path, &ttfTime );
 			}
+			LoadCache();
+		}
 
-			lineHeight = static_cast<float>( face->size->metrics.height ) / 64.0f;
+		FontFace::~FontFace() {
+			// once the job system has shut down every job has either finished or been dropped
+			for ( const auto &it : rasters ) {
+				if ( !it.second->ready.load( std::memory_order_acquire ) && Job::GetNumThreads() ) {
+					Job::Wait( it.second->job );
+				}
+			}
+			if ( face ) {
+				WriteCache();
+			}
+			if ( cache.Data() ) {
+				OS::UnmapFile( &cache );
+			}
+			for ( auto &page : pages ) {
+				delete page.material;
+				delete page.texture;
+			}
+			if ( face ) {
+				FT_Done_Face( face );
+			}
+		}
 
-			// load the printable characters
-			for ( char c = skip; c < numChars; c++ ) {
-				const uint32_t index = FT_Get_Char_Index( face, c );
-				if ( !index ) {
-					continue;
+		fontGlyph_t *FontFace::LoadGlyph( uint32_t codepoint ) {
+			auto it = glyphs.find( codepoint );
+			if ( it != glyphs.end() ) {
+				return &it->second;
+			}
+
+			fontGlyph_t &glyph = glyphs[codepoint];
+			std::memset( &glyph.data, 0, sizeof(glyph.data) );
+			glyph.page = FONT_NO_PAGE;
+			glyph.shelf = 0u;
+			glyph.pending = false;
+
+			// control characters have nothing to draw
+			if ( !face || codepoint < 0x20u ) {
+				return &glyph;
+			}
+
+			// a previous run already loaded it
+			auto cached = cachedGlyphs.find( codepoint );
+			if ( cached != cachedGlyphs.end() ) {
+				glyph.data = cached->second->data;
+				glyph.data.s = glyph.data.t = vector2( 0.0f, 0.0f );
+				return &glyph;
+			}
+
+			// characters the face doesn't have get glyph 0, its missing glyph
+			if ( FT_Load_Glyph( face, FT_Get_Char_Index( face, codepoint ), FT_LOAD_FORCE_AUTOHINT ) ) {
+				return &glyph;
+			}
+
+			// metrics are in upscaled pixels, 26.6 fixed point
+			const float metricScale = 1.0f / (64.0f * FONT_SDF_UPSCALE);
+			const FT_Glyph_Metrics &metrics = face->glyph->metrics;
+			FontData &fd = glyph.data;
+			fd.advance = static_cast<float>( face->glyph->advance.x ) * metricScale;
+			if ( metrics.width <= 0 || metrics.height <= 0 ) {
+				return &glyph;
+			}
+
+			// the quad covers the glyph and the spread around it
+			fd.size.x = std::min( std::ceil( metrics.width * metricScale ) + (2u * FONT_SDF_SPREAD),
+				static_cast<float>( FONT_SDF_CELL ) );
+			fd.size.y = std::min( std::ceil( metrics.height * metricScale ) + (2u * FONT_SDF_SPREAD),
+				static_cast<float>( FONT_SDF_CELL ) );
+			fd.offset.x = (static_cast<float>( metrics.horiBearingX ) * metricScale) - FONT_SDF_SPREAD;
+			fd.offset.y = lineHeight - (static_cast<float>( metrics.horiBearingY ) * metricScale) - FONT_SDF_SPREAD;
+
+			return &glyph;
+		}
+
+		bool FontFace::Allocate( uint32_t width, uint32_t height, uint32_t *outPage, uint32_t *outShelf ) {
+			const uint32_t shelfHeight = ((height + FONT_GLYPH_GAP + FONT_SHELF_ROUND - 1u) / FONT_SHELF_ROUND)
+				* FONT_SHELF_ROUND;
+			const uint32_t shelfWidth = width + FONT_GLYPH_GAP;
+
+			// a shelf of the same height with room left on it
+			for ( uint32_t p = 0u; p < pages.size(); p++ ) {
+				for ( uint32_t s = 0u; s < pages[p].shelves.size(); s++ ) {
+					const fontShelf_t &shelf = pages[p].shelves[s];
+					if ( shelf.height == shelfHeight && shelf.x + shelfWidth <= FONT_PAGE_SIZE ) {
+						*outPage = p;
+						*outShelf = s;
+						return true;
+					}
 				}
+			}
 
-				// render the character's glyph
-				FT_Load_Glyph( face, index, FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT );
-				if ( FT_Render_Glyph( face->glyph, FT_RENDER_MODE_NORMAL ) ) {
-					continue;
+			// a new shelf, on a new page if need be
+			uint32_t newPage = FONT_NO_PAGE;
+			for ( uint32_t p = 0u; p < pages.size(); p++ ) {
+				if ( pages[p].nextShelfY + shelfHeight <= FONT_PAGE_SIZE ) {
+					newPage = p;
+					break;
 				}
-				FT_Glyph glyph;
-				FT_Get_Glyph( face->glyph, &glyph );
-
-				FT_GlyphSlot slot = face->glyph;
-				FT_Bitmap& bitmap = slot->bitmap;
-				const int32_t width = bitmap.width ? bitmap.width : static_cast<float>( slot->advance.x ) / 64.0f;
-				const int32_t height = bitmap.rows;
-
-				// atlas will be 16 chars by 16 chars, where chars are WxH but spaced by size*size
-				const uint32_t col = c % 16;
-				const uint32_t row = c / 16;
-				const float colPos = static_cast<float>( col ) / 16.0f;
-				const float rowPos = static_cast<float>( row ) / 16.0f;
-				const size_t rowSize = size * 16;
-				const size_t x = col * size; // horizontal position
-				const size_t y = row * size * rowSize; // vertical position
-
-				// calculate glyph metrics
-				FontData &fd = data[c];
-				fd.size = vector2( width, height );
-				fd.s = vector2( colPos, colPos + (static_cast<float>( width ) / 256.0f) );
-				fd.t = vector2( rowPos, rowPos + (static_cast<float>( height ) / 256.0f) );
-				fd.advance = static_cast<float>( slot->advance.x ) / 64.0f;
-				fd.offset.x = static_cast<float>( slot->metrics.horiBearingX ) / 64.0f;
-				fd.offset.y = lineHeight + -(static_cast<float>( slot->metrics.horiBearingY ) / 64.0f);
-
-				if ( !bitmap.buffer ) {
-					FT_Done_Glyph( glyph );
-					continue;
+			}
+			if ( newPage == FONT_NO_PAGE && pages.size() < FONT_MAX_PAGES ) {
+				fontPage_t page;
+				// start from a blank page, the texels around each glyph must read as outside
+				const std::vector<uint8_t> blank( FONT_PAGE_SIZE * FONT_PAGE_SIZE, 0u );
+				RunOnRenderThread( [&page, &blank]( void ) {
+					page.texture = new Texture( FONT_PAGE_SIZE, FONT_PAGE_SIZE, InternalFormat::R8, blank.data() );
+				}, true );
+				SDL_assert( page.texture );
+				page.material = CreateFontMaterial( *page.texture );
+				page.nextShelfY = 0u;
+
+				if ( Common::com_developer->GetBool() ) {
+					console.Print( "Adding font atlas page %u for '%s' (%ix%i)\n",
+						static_cast<uint32_t>( pages.size() ), name.c_str(), FONT_PAGE_SIZE, FONT_PAGE_SIZE );
 				}
+				newPage = static_cast<uint32_t>( pages.size() );
+				pages.push_back( page );
+			}
+			if ( newPage != FONT_NO_PAGE ) {
+				fontPage_t &page = pages[newPage];
+				fontShelf_t shelf;
+				shelf.y = page.nextShelfY;
+				shelf.height = shelfHeight;
+				shelf.x = 0u;
+				shelf.lastUsed = 0u;
+				shelf.generation = 0u;
+				shelf.pending = 0u;
+				page.nextShelfY += shelfHeight;
+				page.shelves.push_back( shelf );
+
+				*outPage = newPage;
+				*outShelf = static_cast<uint32_t>( page.shelves.size() - 1u );
+				return true;
+			}
 
-				// generate an RGBA texture from the 8bpp glyph
-				const size_t topLeft = y + x; // row + column
-			//	const size_t topRight = y + x + size; // (row + column) + charWidth
-			//	const size_t bottomLeft = y + x + (size * rowSize);
-			//	const size_t bottomRight = y + x + (size * rowSize) + size;
-
-				for ( size_t y = 0; y < static_cast<size_t>( height ); y++ ) {
-					for ( size_t x = 0; x < static_cast<size_t>( width ); x++ ) {
-						atlas[topLeft + (y * rowSize) + x] = bitmap.buffer[y * width + x];
+			// every page is full, try a taller shelf with room left on it, then reuse the least recently used shelf
+			//	that's tall enough
+			// shelves used this frame are left alone, as quads already queued may read them, as are shelves with
+			//	glyphs still to be uploaded
+			const uint64_t frameNum = GetFrameNum();
+			uint32_t bestPage = FONT_NO_PAGE, bestShelf = 0u;
+			for ( uint32_t p = 0u; p < pages.size(); p++ ) {
+				for ( uint32_t s = 0u; s < pages[p].shelves.size(); s++ ) {
+					const fontShelf_t &shelf = pages[p].shelves[s];
+					if ( shelf.height >= shelfHeight && shelf.x + shelfWidth <= FONT_PAGE_SIZE ) {
+						*outPage = p;
+						*outShelf = s;
+						return true;
+					}
+					if ( shelf.height < shelfHeight || shelf.lastUsed >= frameNum || shelf.pending ) {
+						continue;
+					}
+					if ( bestPage == FONT_NO_PAGE ) {
+						bestPage = p;
+						bestShelf = s;
+						continue;
+					}
+					const fontShelf_t &best = pages[bestPage].shelves[bestShelf];
+					if ( shelf.lastUsed < best.lastUsed
+						|| (shelf.lastUsed == best.lastUsed && shelf.height < best.height) )
+					{
+						bestPage = p;
+						bestShelf = s;
 					}
 				}
+			}
+			if ( bestPage == FONT_NO_PAGE ) {
+				return false;
+			}
+
+			fontShelf_t &shelf = pages[bestPage].shelves[bestShelf];
+			for ( const auto &codepoint : shelf.codepoints ) {
+				glyphs[codepoint].page = FONT_NO_PAGE;
+			}
+			shelf.codepoints.clear();
+			shelf.x = 0u;
+			shelf.generation++;
+
+			*outPage = bestPage;
+			*outShelf = bestShelf;
+			return true;
+		}
+
+		const uint8_t *FontFace::GetStoredField( uint32_t codepoint ) const {
+			auto rendered = renderedFields.find( codepoint );
+			if ( rendered != renderedFields.end() ) {
+				return rendered->second.data();
+			}
 
-				FT_Done_Glyph( glyph );
+			auto cached = cachedGlyphs.find( codepoint );
+			if ( cached != cachedGlyphs.end() && cached->second->fieldOffset ) {
+				return cache.Data() + cached->second->fieldOffset;
 			}
 
-			FT_Done_Face( face );
-			delete[] contents;
+			return nullptr;
+		}
 
-			// save out the font atlas
-			WritePNG( String::Format( "cache/fonts/%s_%i.png", name.c_str(), size ).c_str(), atlas, size * 16,
-				size * 16, 1 );
+		bool FontFace::Rasterise( uint32_t codepoint, fontGlyph_t *glyph ) {
+			FontData &fd = glyph->data;
+
+			// render the character's glyph, unless it's already been rendered
+			const uint8_t *field = GetStoredField( codepoint );
+			if ( !field
+				&& (FT_Load_Glyph( face, FT_Get_Char_Index( face, codepoint ), FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT )
+					|| FT_Render_Glyph( face->glyph, FT_RENDER_MODE_NORMAL ) || !face->glyph->bitmap.buffer) )
+			{
+				// don't try again
+				fd.size = vector2( 0.0f, 0.0f );
+				return false;
+			}
 
-			// and now the glyph metrics
-			const File fontdat( String::Format( "cache/fonts/%s_%i.fontdat", name.c_str(), size ).c_str(),
-				FileMode::WRITE_BINARY );
-			fontdat.Write( &data[skip], sizeof(data) - (sizeof(*data) * skip) );
+			const uint32_t width = static_cast<uint32_t>( fd.size.x );
+			const uint32_t height = static_cast<uint32_t>( fd.size.y );
+			uint32_t pageIndex, shelfIndex;
+			if ( !Allocate( width, height, &pageIndex, &shelfIndex ) ) {
+				return false;
+			}
+			fontShelf_t &shelf = pages[pageIndex].shelves[shelfIndex];
+
+			fd.s = vector2( static_cast<float>( shelf.x ) / FONT_PAGE_SIZE,
+				static_cast<float>( shelf.x + width ) / FONT_PAGE_SIZE );
+			fd.t = vector2( static_cast<float>( shelf.y ) / FONT_PAGE_SIZE,
+				static_cast<float>( shelf.y + height ) / FONT_PAGE_SIZE );
+			glyph->page = pageIndex;
+			glyph->shelf = shelfIndex;
+
+			if ( field ) {
+				UpdateTexture( pages[pageIndex].texture, shelf.x, shelf.y, width, height, field );
+				shelf.x += width + FONT_GLYPH_GAP;
+				shelf.codepoints.push_back( codepoint );
+				return true;
+			}
 
-			texture = new Texture( size * 16, size * 16, InternalFormat::R8, atlas );
-			SDL_assert( texture );
-			material = CreateFontMaterial( *texture );
-			SDL_assert( material );
+			// the room is taken now, the field is uploaded once a job has rendered it
+			const FT_Bitmap &bitmap = face->glyph->bitmap;
+			std::unique_ptr<fontRaster_t> &raster = rasters[codepoint];
+			raster.reset( new fontRaster_t() );
+			raster->page = pageIndex;
+			raster->x = shelf.x;
+			raster->y = shelf.y;
+			raster->width = width;
+			raster->height = height;
+			raster->bitmapWidth = bitmap.width;
+			raster->bitmapRows = bitmap.rows;
+			raster->bitmap.resize( bitmap.width * bitmap.rows );
+			for ( uint32_t y = 0u; y < bitmap.rows; y++ ) {
+				std::memcpy( &raster->bitmap[y * bitmap.width], bitmap.buffer + (y * bitmap.pitch), bitmap.width );
+			}
+			raster->field.resize( width * height );
+			raster->ready = false;
 
-			delete[] atlas;
+			fontRaster_t *data = raster.get();
+			raster->job = Job::Create( RenderGlyph, &data, sizeof(data) );
+			Job::Run( raster->job );
+
+			glyph->pending = true;
+
+			shelf.x += width + FONT_GLYPH_GAP;
+			shelf.codepoints.push_back( codepoint );
+			shelf.pending++;
+			return true;
 		}
 
-		void Font::Draw( const vector2 &pos, const std::string &text ) {
-			if ( text.empty() ) {
-				return;
+		bool FontFace::Upload( uint32_t codepoint, fontGlyph_t *glyph ) {
+			auto it = rasters.find( codepoint );
+			fontRaster_t &raster = *it->second;
+			if ( !raster.ready.load( std::memory_order_acquire ) ) {
+				return false;
 			}
 
-			const uint32_t screenWidth = vid_width->GetInt();
-			vector2 currentPos = pos;
-			size_t len = text.length();
+			fontPage_t &page = pages[raster.page];
+			UpdateTexture( page.texture, raster.x, raster.y, raster.width, raster.height, raster.field.data() );
+			page.shelves[glyph->shelf].pending--;
+			glyph->pending = false;
 
-			for ( size_t i = 0; i < len; i++ ) {
-				const char c = text[i];
-				const FontData &fd = data[c];
+			// kept for when it's evicted and drawn again, and for the cache
+			renderedFields[codepoint].swap( raster.field );
+			rasters.erase( it );
+			return true;
+		}
 
-				// check for overflow
-				if ( currentPos.x + fd.advance >= screenWidth ) {
-					currentPos.x = pos.x;
-					currentPos.y += lineHeight;
+		bool FontFace::LoadCache( void ) {
+			char path[XS_MAX_FILENAME];
+			const std::string cachePath = String::Format( "cache/fonts/%s.glyphcache", name.c_str() );
+			if ( !File::GetFullPath( cachePath.c_str(), path, sizeof(path) ) || !OS::MapFile( path, &cache ) ) {
+				return false;
+			}
+
+			const fontCacheHeader_t *header = reinterpret_cast<const fontCacheHeader_t *>( cache.Data() );
+			bool valid = cache.length >= sizeof(*header)
+				&& header->magic == FONT_CACHE_MAGIC
+				&& header->version == FONT_CACHE_VERSION
+				&& header->ttfTime == ttfTime
+				&& header->ttfLength == ttfLength
+				&& header->sdfSize == FONT_SDF_SIZE
+				&& header->sdfSpread == FONT_SDF_SPREAD
+				&& header->sdfUpscale == FONT_SDF_UPSCALE
+				&& header->fontDataSize == sizeof(FontData)
+				&& cache.length >= sizeof(*header) + (header->numGlyphs * sizeof(fontCacheGlyph_t));
+
+			const fontCacheGlyph_t *cachedGlyph = reinterpret_cast<const fontCacheGlyph_t *>( header + 1 );
+			for ( uint32_t i = 0u; valid && i < header->numGlyphs; i++, cachedGlyph++ ) {
+				const size_t fieldSize = static_cast<size_t>( cachedGlyph->data.size.x )
+					* static_cast<size_t>( cachedGlyph->data.size.y );
+				if ( cachedGlyph->fieldOffset && cachedGlyph->fieldOffset + fieldSize > cache.length ) {
+					valid = false;
+					break;
 				}
+				cachedGlyphs[cachedGlyph->codepoint] = cachedGlyph;
+			}
 
-				DrawQuad( currentPos.x + fd.offset.x, currentPos.y + fd.offset.y, // x, y
-					fd.size.x, fd.size.y, // width, height
-					fd.s.x, fd.t.x, fd.s.y, fd.t.y, // st coords
-					nullptr, material );
+			if ( !valid ) {
+				cachedGlyphs.clear();
+				OS::UnmapFile( &cache );
+				cache = OS::mappedFile_t();
+				return false;
+			}
 
-				// increase by glyph width
-				currentPos.x += fd.advance;
+			return true;
+		}
 
-				// check for line-feeds
-				if ( c == '\n' ) {
-					currentPos.x = pos.x;
-					currentPos.y += lineHeight;
+		void FontFace::WriteCache( void ) {
+			// only glyphs whose field is known, or that have nothing to draw
+			std::vector<fontCacheGlyph_t> entries;
+			std::vector<uint8_t> fields;
+			bool modified = false;
+			for ( const auto &it : glyphs ) {
+				const uint32_t codepoint = it.first;
+				const FontData &fd = it.second.data;
+				if ( codepoint < 0x20u ) {
+					continue;
 				}
-				//TODO: handle \r? do we just write on top of the previous characters?
-				//TODO: handle tabs correctly with tab-stops aligned to 4 spaces - from the window's position, or the
-				//	current line's position? use space for alignment? what is the correct behaviour?
+
+				const size_t fieldSize = static_cast<size_t>( fd.size.x ) * static_cast<size_t>( fd.size.y );
+				const uint8_t *field = GetStoredField( codepoint );
+				auto raster = rasters.find( codepoint );
+				if ( !field && raster != rasters.end() && raster->second->ready.load( std::memory_order_acquire ) ) {
+					field = raster->second->field.data();
+				}
+				if ( fieldSize && !field ) {
+					continue;
+				}
+
+				fontCacheGlyph_t entry;
+				entry.codepoint = codepoint;
+				entry.data = fd;
+				entry.data.s = entry.data.t = vector2( 0.0f, 0.0f );
+				entry.fieldOffset = 0u;
+				if ( fieldSize ) {
+					entry.fieldOffset = static_cast<uint32_t>( fields.size() );
+					fields.insert( fields.end(), field, field + fieldSize );
+				}
+				entries.push_back( entry );
+
+				auto cached = cachedGlyphs.find( codepoint );
+				if ( cached == cachedGlyphs.end() || (fieldSize && !cached->second->fieldOffset) ) {
+					modified = true;
+				}
+			}
+
+			// glyphs from the cache that weren't used this run
+			for ( const auto &it : cachedGlyphs ) {
+				if ( glyphs.find( it.first ) != glyphs.end() ) {
+					continue;
+				}
+
+				fontCacheGlyph_t entry = *it.second;
+				if ( entry.fieldOffset ) {
+					const size_t fieldSize = static_cast<size_t>( entry.data.size.x )
+						* static_cast<size_t>( entry.data.size.y );
+					const uint8_t *field = cache.Data() + entry.fieldOffset;
+					entry.fieldOffset = static_cast<uint32_t>( fields.size() );
+					fields.insert( fields.end(), field, field + fieldSize );
+				}
+				entries.push_back( entry );
 			}
 
-			return;
+			if ( !modified ) {
+				return;
+			}
+
+			// the old cache is still mapped, and everything needed from it has been copied
+			if ( cache.Data() ) {
+				OS::UnmapFile( &cache );
+				cache = OS::mappedFile_t();
+				cachedGlyphs.clear();
+			}
+
+			const std::string cachePath = String::Format( "cache/fonts/%s.glyphcache", name.c_str() );
+			const File f( cachePath.c_str(), FileMode::WRITE_BINARY );
+			if ( !f.open ) {
+				console.Print( "WARNING: Could not write glyph cache \"%s\"\n", cachePath.c_str() );
+				return;
+			}
+
+			fontCacheHeader_t header;
+			header.magic = FONT_CACHE_MAGIC;
+			header.version = FONT_CACHE_VERSION;
+			header.ttfTime = ttfTime;
+			header.ttfLength = ttfLength;
+			header.sdfSize = FONT_SDF_SIZE;
+			header.sdfSpread = FONT_SDF_SPREAD;
+			header.sdfUpscale = FONT_SDF_UPSCALE;
+			header.fontDataSize = sizeof(FontData);
+			header.numGlyphs = static_cast<uint32_t>( entries.size() );
+
+			// field offsets are from the start of the file
+			const uint32_t fieldsOffset = static_cast<uint32_t>( sizeof(header)
+				+ (entries.size() * sizeof(fontCacheGlyph_t)) );
+			for ( auto &entry : entries ) {
+				if ( entry.data.size.x >= 1.0f && entry.data.size.y >= 1.0f ) {
+					entry.fieldOffset += fieldsOffset;
+				}
+			}
+
+			f.Write( &header, sizeof(header) );
+			f.Write( entries.data(), entries.size() * sizeof(fontCacheGlyph_t) );
+			f.Write( fields.data(), fields.size() );
 		}
 
-		uint32_t Font::GetTextLineCount( const vector2 &pos, const std::string &text ) {
-			uint32_t numLines = 0u;
+		const FontData &FontFace::GetMetrics( uint32_t codepoint ) {
+			return LoadGlyph( codepoint )->data;
+		}
 
-			if ( text.empty() ) {
-				return numLines;
+		const fontGlyph_t *FontFace::GetGlyph( uint32_t codepoint ) {
+			fontGlyph_t *glyph = LoadGlyph( codepoint );
+			if ( glyph->data.size.x <= 0.0f ) {
+				return nullptr;
+			}
+			if ( glyph->page == FONT_NO_PAGE && !Rasterise( codepoint, glyph ) ) {
+				return nullptr;
 			}
 
-			vector2 currentPos = pos;
-			size_t len = text.length();
+			pages[glyph->page].shelves[glyph->shelf].lastUsed = GetFrameNum();
+			if ( glyph->pending && !Upload( codepoint, glyph ) ) {
+				return nullptr;
+			}
+			return glyph;
+		}
+
+		bool FontFace::TouchShelf( uint32_t page, uint32_t shelf, uint32_t generation ) {
+			fontShelf_t &s = pages[page].shelves[shelf];
+			if ( s.generation != generation ) {
+				return false;
+			}
+			s.lastUsed = GetFrameNum();
+			return true;
+		}
+
+		Font::Font( FontFace *face, uint16_t size )
+		: face( face ), name( face->name ), size( size )
+		{
+			scale = static_cast<float>( size ) / FONT_SDF_SIZE;
+			lineHeight = face->lineHeight * scale;
+		}
+
+		uint32_t Font::Layout( const vector2 &pos, const char *text, size_t length,
+			const std::function<void( uint32_t codepoint, const vector2 &pen )> &emit ) const
+		{
+			uint32_t numLines = 0u;
+
 			const uint32_t screenWidth = vid_width->GetInt();
+			vector2 currentPos = pos;
+			const char *p = text;
+			const char *end = text + length;
 
-			for ( size_t i = 0; i < len; i++ ) {
-				const char c = text[i];
-				const FontData &fd = data[c];
+			while ( p < end ) {
+				const uint32_t codepoint = String::DecodeUTF8( &p, end );
+				const FontData &fd = face->GetMetrics( codepoint );
+				const float advance = fd.advance * scale;
 
 				// check for overflow
-				if ( currentPos.x + fd.advance >= screenWidth ) {
+				if ( currentPos.x + advance >= screenWidth ) {
 					currentPos.x = pos.x;
 					currentPos.y += lineHeight;
 					numLines++;
 				}
 
-				currentPos.x += fd.advance;
+				// whitespace has nothing to draw
+				if ( emit && fd.size.x > 0.0f ) {
+					emit( codepoint, currentPos );
+				}
+
+				// increase by glyph width
+				currentPos.x += advance;
 
 				// check for line-feeds
-				if ( c == '\n' ) {
+				if ( codepoint == '\n' ) {
 					currentPos.x = pos.x;
 					currentPos.y += lineHeight;
 					numLines++;
 				}
+				//TODO: handle \r? do we just write on top of the previous characters?
+				//TODO: handle tabs correctly with tab-stops aligned to 4 spaces - from the window's position, or the
+				//	current line's position? use space for alignment? what is the correct behaviour?
 			}
 
 			return numLines;
 		}
 
-		float Font::GetGlyphWidth( char c ) const {
-			const FontData &fd = data[c];
-			return fd.advance;
+		void Font::Draw( const vector2 &pos, const std::string &text ) {
+			Layout( pos, text.c_str(), text.length(), [this]( uint32_t codepoint, const vector2 &pen ) {
+				const fontGlyph_t *glyph = face->GetGlyph( codepoint );
+				if ( !glyph ) {
+					return;
+				}
+
+				const FontData &fd = glyph->data;
+				DrawQuad( pen.x + (fd.offset.x * scale), pen.y + (fd.offset.y * scale), // x, y
+					fd.size.x * scale, fd.size.y * scale, // width, height
+					fd.s.x, fd.t.x, fd.s.y, fd.t.y, // st coords
+					nullptr, face->GetPageMaterial( glyph->page ) );
+			} );
+		}
+
+		uint32_t Font::GetTextLineCount( const vector2 &pos, const std::string &text ) {
+			return Layout( pos, text.c_str(), text.length(), nullptr );
+		}
+
+		uint32_t Font::GetTextLineCount( const vector2 &pos, const char *text, size_t length ) const {
+			return Layout( pos, text, length, nullptr );
+		}
+
+		float Font::GetGlyphWidth( uint32_t codepoint ) const {
+			return face->GetMetrics( codepoint ).advance * scale;
 		}
 
 		void Font::Init( void ) {
@@ -244,9 +779,6 @@ namespace XS {
 				throw( XSError( "Could not initialise freetype library" ) );
 			}
 
-			fonts["menu"] = new Font( "menu", 24 );
-			fonts["console"] = new Font( "console", 12 );
-
 			static const VertexAttribute attributes[] = {
 				{ 0, "in_Position" },
 				{ 1, "in_TexCoord" },
@@ -255,36 +787,57 @@ namespace XS {
 
 			fontProgram = new ShaderProgram( "text", "text", attributes, ARRAY_LEN( attributes ) );
 
-			for ( const auto &it: fonts ) {
-				it.second->RenderGlyphs();
+			// open the faces we know we'll need up front
+			Register( "menu", 24 );
+			Register( "console", 12 );
+		}
+
+		void Font::Prefetch( const char *name ) {
+			if ( faces.find( name ) != faces.end() ) {
+				return;
+			}
+
+			const std::string path = String::Format( "fonts/%s.ttf", name );
+			std::unique_ptr<AsyncFile> &file = prefetched[path];
+			if ( !file ) {
+				file.reset( new AsyncFile( path.c_str() ) );
 			}
 		}
 
 		void Font::Shutdown( void ) {
+			prefetched.clear();
 			for ( const auto &it : fonts ) {
+				delete it;
+			}
+			fonts.clear();
+			for ( const auto &it : faces ) {
 				delete it.second;
 			}
+			faces.clear();
 
 			delete fontProgram;
+
+			FT_Done_FreeType( ft );
 		}
 
 		Font *Font::Register( const char *name, uint16_t size ) {
-			Font *font = fonts[name];
-			if ( font ) {
-				if ( font->size == size ) {
-					return font;
-				}
-				else {
-					// size mismatch, we need to regenerate it
-					delete font;
+			FontFace *&face = faces[name];
+			if ( !face ) {
+				face = new FontFace( name );
+			}
+
+			for ( const auto &it : fonts ) {
+				if ( it->face == face && it->size == size ) {
+					return it;
 				}
 			}
 
+			// every size shares the face's atlas pages, so this only scales the metrics
 			if ( Common::com_developer->GetBool() ) {
-				console.Print( "Generating new font '%s' at size %i\n", name, size );
+				console.Print( "Registering font '%s' at size %i\n", name, size );
 			}
-			font = fonts[name] = new Font( name, size );
-			font->RenderGlyphs();
+			Font *font = new Font( face, size );
+			fonts.push_back( font );
 			return font;
 		}
 
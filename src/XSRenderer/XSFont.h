@@ -1,12 +1,17 @@
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include "freetype/ftglyph.h"
 
 #include "XSCommon/XSVector.h"
+#include "XSSystem/XSOS.h"
 
 namespace XS {
 
@@ -14,6 +19,10 @@ namespace XS {
 
 		class Texture;
 		struct Material;
+		struct fontRaster_t;
+		struct fontCacheGlyph_t;
+
+		#define FONT_NO_PAGE (UINT32_MAX)
 
 		struct FontData {
 			vector2		size;
@@ -22,35 +31,177 @@ namespace XS {
 			float		advance;
 		};
 
+		// metrics are in texels of the atlas, i.e. at FONT_SDF_SIZE, and are kept when the glyph is evicted
+		struct fontGlyph_t {
+			FontData	data; // s and t are only valid while the glyph is on a page
+			uint32_t	page; // FONT_NO_PAGE if it isn't in an atlas page
+			uint32_t	shelf;
+			bool		pending; // has room on its page, but the distance field is still being rendered
+		};
+
+		// a row of an atlas page, glyphs are packed along it left to right
+		// a shelf is the unit of eviction, all of its glyphs are dropped together when it's reused
+		struct fontShelf_t {
+			uint32_t				y, height;
+			uint32_t				x; // next free column
+			uint64_t				lastUsed; // renderer frame number
+			uint32_t				generation; // incremented every time the shelf is evicted
+			uint32_t				pending; // glyphs waiting to be uploaded, the shelf isn't evicted until they are
+			std::vector<uint32_t>	codepoints; // glyphs on this shelf
+		};
+
+		struct fontPage_t {
+			Texture						*texture;
+			Material					*material;
+			std::vector<fontShelf_t>	 shelves;
+			uint32_t					 nextShelfY;
+		};
+
+		// a TTF whose glyphs are rasterised into signed distance field atlas pages the first time they're drawn, and
+		//	shared by every size
+		// there are at most FONT_MAX_PAGES pages, once they're full the least recently used shelf is reused
+		// distance fields are rendered on worker threads, a glyph isn't drawn until its field has been uploaded
+		// every glyph's metrics and distance field are written to cache/fonts on shutdown, so the next run can upload
+		//	them without going through FreeType again
+		class FontFace {
+		private:
+			std::vector<uint8_t>						 contents; // FreeType reads the face from here
+			FT_Face										 face;
+			std::unordered_map<uint32_t, fontGlyph_t>	 glyphs; // by codepoint
+			std::vector<fontPage_t>						 pages;
+			std::unordered_map<uint32_t, std::unique_ptr<fontRaster_t>>	 rasters; // pending glyphs by codepoint
+			OS::mappedFile_t											 cache; // written by a previous run
+			std::unordered_map<uint32_t, const fontCacheGlyph_t *>		 cachedGlyphs; // by codepoint, in the cache
+			std::unordered_map<uint32_t, std::vector<uint8_t>>			 renderedFields; // by codepoint, this run
+			int32_t														 ttfTime; // cache is only valid for this TTF
+			uint32_t													 ttfLength;
+
+			// map the glyphs written by a previous run, returns false if there are none or they're from a different
+			//	TTF or different distance field settings
+			bool LoadCache(
+				void
+			);
+
+			// write every glyph with known metrics and distance field, along with what's already in the cache
+			void WriteCache(
+				void
+			);
+
+			// a glyph's distance field rendered by this or a previous run, nullptr if there isn't one
+			const uint8_t *GetStoredField(
+				uint32_t codepoint
+			) const;
+
+			// look up or load a glyph's metrics, nothing is rasterised
+			fontGlyph_t *LoadGlyph(
+				uint32_t codepoint
+			);
+
+			// find room for a width x height glyph, evicting a shelf that hasn't been used this frame if need be
+			// returns false if there is no room
+			bool Allocate(
+				uint32_t width,
+				uint32_t height,
+				uint32_t *outPage,
+				uint32_t *outShelf
+			);
+
+			// make room for a glyph on a page and start rendering its distance field, returns false if there was no
+			//	room
+			bool Rasterise(
+				uint32_t codepoint,
+				fontGlyph_t *glyph
+			);
+
+			// upload a pending glyph's distance field to its page, returns false if it hasn't been rendered yet
+			bool Upload(
+				uint32_t codepoint,
+				fontGlyph_t *glyph
+			);
+
+		public:
+			std::string	 file;
+			std::string	 name;
+			float		 lineHeight;
+
+			// don't allow default instantiation
+			FontFace() = delete;
+			FontFace( const FontFace& ) = delete;
+			FontFace& operator=( const FontFace& ) = delete;
+
+			// open the TTF, glyphs aren't rasterised until they're drawn
+			FontFace(
+				const char *name
+			);
+
+			~FontFace();
+
+			// metrics of a glyph, loading them if this is the first time it's been seen
+			const FontData &GetMetrics(
+				uint32_t codepoint
+			);
+
+			// a glyph ready to be drawn, rasterised into a page if it isn't on one
+			// its shelf is marked as used, so it stays where it is for the rest of the frame
+			// new glyphs are uploaded through the current view
+			// returns nullptr if there's nothing to draw, no room to rasterise it this frame, or its distance field
+			//	isn't ready yet
+			const fontGlyph_t *GetGlyph(
+				uint32_t codepoint
+			);
+
+			// mark a shelf as used this frame, returns false if it was evicted since generation
+			bool TouchShelf(
+				uint32_t page,
+				uint32_t shelf,
+				uint32_t generation
+			);
+
+			inline uint32_t GetShelfGeneration( uint32_t page, uint32_t shelf ) const {
+				return pages[page].shelves[shelf].generation;
+			}
+
+			inline const Material *GetPageMaterial( uint32_t page ) const {
+				return pages[page].material;
+			}
+		};
+
+		// a face drawn at one size, the metrics are scaled from the face's and the atlas pages are shared
 		class Font {
 		private:
-			Texture		*texture;
-			Material	*material;
+			FontFace	*face;
 
 		public:
-			std::string	file;
-			std::string	name;
-			uint16_t	size;
-			FontData	data[256];
-			float		lineHeight;
+			std::string		name;
+			uint16_t		size;
+			float			scale; // from the face's metrics
+			float			lineHeight;
 
 			// don't allow default instantiation
 			Font() = delete;
 			Font( const Font& ) = delete;
 			Font& operator=( const Font& ) = delete;
 
-			// register a new font
 			Font(
-				const char *name,
+				FontFace *face,
 				uint16_t size
 			);
 
-			// generate a glyph atlas for the font at the current size.
-			void RenderGlyphs(
-				void
-			);
+			inline FontFace *GetFace( void ) const {
+				return face;
+			}
+
+			// walk a UTF-8 string as it would be drawn at the given position, wrapping against vid_width
+			// emit, if set, is called with each glyph that has something to draw and where its pen is
+			// return the number of lines it would take to draw (for linefeeds and wrapping)
+			uint32_t Layout(
+				const vector2 &pos,
+				const char *text,
+				size_t length,
+				const std::function<void( uint32_t codepoint, const vector2 &pen )> &emit
+			) const;
 
-			// draw a string at the given position
+			// draw a UTF-8 string at the given position
 			void Draw(
 				const vector2 &pos,
 				const std::string &text
@@ -62,9 +213,16 @@ namespace XS {
 				const std::string &text
 			);
 
+			// as above, for a string that isn't null-terminated
+			uint32_t GetTextLineCount(
+				const vector2 &pos,
+				const char *text,
+				size_t length
+			) const;
+
 			// return the pixel width of the specified character
 			float GetGlyphWidth(
-				char c
+				uint32_t codepoint
 			) const;
 
 			// initialise the font system (i.e. freetype)
@@ -72,12 +230,18 @@ namespace XS {
 				void
 			);
 
+			// start reading a face's TTF on a worker thread, registering it later uses what was read
+			static void Prefetch(
+				const char *name
+			);
+
 			// free all font resources
 			static void Shutdown(
 				void
 			);
 
 			// register a new font, or be returned an existing one
+			// a face is only opened the first time it's registered, every size after that is a lookup
 			static Font *Register(
 				const char *name,
 				uint16_t size
@@ -87,6 +87,24 @@ namespace XS {
 			}
 		}
 
+		size_t GetBytesPerPixel( InternalFormat format ) {
+			switch ( format ) {
+			// single channel, uploaded as GL_UNSIGNED_BYTE
+			default: {
+				return 1u;
+			} break;
+
+			case InternalFormat::RGBA8:
+			case InternalFormat::DEPTH24_STENCIL8: {
+				return 4u;
+			} break;
+
+			case InternalFormat::RGBA16F: {
+				return 4u * sizeof(float);
+			} break;
+			}
+		}
+
 	} // namespace Renderer
 
 } // namespace XS
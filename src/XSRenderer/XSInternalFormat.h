@@ -31,6 +31,11 @@ namespace XS {
 			InternalFormat internalFormat
 		);
 
+		// size of one pixel of data in the format and data type above
+		size_t GetBytesPerPixel(
+			InternalFormat internalFormat
+		);
+
 	} // namespace Renderer
 
 } // namespace XS
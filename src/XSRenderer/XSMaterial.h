@@ -27,6 +27,8 @@ namespace XS {
 			ShaderProgram				*shaderProgram;
 			std::vector<SamplerBinding>	 samplerBindings;
 			std::vector<BufferBinding>	 bufferBindings;
+			// order doesn't matter within a layer, so it can be sorted by state
+			bool						 opaque = false;
 
 			// use this material for subsequent rendering
 			void Bind(
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <SDL2/SDL.h>
 
 #include "XSCommon/XSCommon.h"
@@ -5,6 +7,7 @@
 #include "XSCommon/XSMatrix.h"
 #include "XSCommon/XSConsole.h"
 #include "XSRenderer/XSRenderer.h"
+#include "XSRenderer/XSBackend.h"
 #include "XSRenderer/XSBuffer.h"
 #include "XSRenderer/XSRenderCommand.h"
 #include "XSRenderer/XSMaterial.h"
@@ -21,6 +24,10 @@ namespace XS {
 		// render commands are actually backend
 		using namespace Backend;
 
+		// quads sharing a material are drawn with one glDrawElements, up to this many at a time
+		// 4 vertices per quad must stay addressable by 16 bit indices
+		#define MAX_BATCH_QUADS (4096u)
+
 		static Buffer *quadsVertexBuffer;
 		static Buffer *quadsIndexBuffer;
 
@@ -28,20 +35,32 @@ namespace XS {
 		static Material *quadMaterial = nullptr;
 		static Texture *quadTexture = nullptr;
 
+		// quads waiting to be drawn
+		static quadVertex_t batchVertices[MAX_BATCH_QUADS * 4];
+		static uint32_t batchQuads = 0u;
+		static const Material *batchMaterial = nullptr;
+
 		void RenderCommand::Init( void ) {
-			static const uint16_t quadIndices[6] = { 0, 2, 1, 1, 2, 3 };
+			// every batch uses the same index pattern, so it's only generated once
+			std::vector<uint16_t> quadIndices( MAX_BATCH_QUADS * 6 );
+			for ( uint32_t quad = 0u; quad < MAX_BATCH_QUADS; quad++ ) {
+				static const uint16_t pattern[6] = { 0, 2, 1, 1, 2, 3 };
+				for ( uint32_t i = 0u; i < 6; i++ ) {
+					quadIndices[(quad * 6) + i] = static_cast<uint16_t>( (quad * 4) + pattern[i] );
+				}
+			}
 
-			// v1(2), v2(2), v3(2), v4(2), st1(2), st2(2), st3(2), st4(2), c1(4) == 20 bytes
+			// v(2), st(2), c(4) per vertex == 32 bytes
+			// streamed, with room for a few full batches each frame
 			quadsVertexBuffer = new Buffer(
 				Buffer::Type::VERTEX,
-				nullptr,
-				sizeof(vector2) + sizeof(vector2) + sizeof(vector4)
+				sizeof(batchVertices) * 4
 			);
 
 			quadsIndexBuffer = new Buffer(
 				Buffer::Type::INDEX,
-				quadIndices,
-				sizeof(quadIndices)
+				quadIndices.data(),
+				quadIndices.size() * sizeof(uint16_t)
 			);
 
 			// create null quad material
@@ -67,6 +86,7 @@ namespace XS {
 			samplerBinding.texture = quadTexture;
 			quadMaterial->samplerBindings.push_back( samplerBinding );
 			quadMaterial->shaderProgram = quadProgram;
+			quadMaterial->opaque = true;
 		}
 
 		void RenderCommand::Shutdown( void ) {
@@ -74,78 +94,162 @@ namespace XS {
 			delete quadsIndexBuffer;
 		}
 
-		static void DrawQuad( const rcDrawQuad_t *quad ) {
-			if ( quad->material ) {
-				quad->material->Bind();
+		// draw numQuads quads from the bound vertex buffer, starting offset bytes in
+		// the shared index buffer only covers a batch, so longer runs are split into several draws
+		static void DrawQuads( size_t offset, uint32_t numQuads ) {
+			quadsIndexBuffer->Bind();
+
+			glEnableVertexAttribArray( 0 );
+			glEnableVertexAttribArray( 1 );
+			glEnableVertexAttribArray( 2 );
+				const GLsizei stride = sizeof(quadVertex_t);
+
+				for ( uint32_t first = 0u; first < numQuads; first += MAX_BATCH_QUADS ) {
+					const size_t base = offset + (first * 4 * sizeof(quadVertex_t));
+					glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, stride,
+						reinterpret_cast<const GLvoid *>( base + offsetof( quadVertex_t, position ) ) );
+					glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, stride,
+						reinterpret_cast<const GLvoid *>( base + offsetof( quadVertex_t, texCoord ) ) );
+					glVertexAttribPointer( 2, 4, GL_FLOAT, GL_FALSE, stride,
+						reinterpret_cast<const GLvoid *>( base + offsetof( quadVertex_t, colour ) ) );
+
+					const uint32_t count = std::min( numQuads - first, MAX_BATCH_QUADS );
+					glDrawElements( GL_TRIANGLES, count * 6, GL_UNSIGNED_SHORT, 0 );
+					frameStats.drawCalls++;
+				}
+			glDisableVertexAttribArray( 2 );
+			glDisableVertexAttribArray( 1 );
+			glDisableVertexAttribArray( 0 );
+		}
+
+		void RenderCommand::Flush( void ) {
+			if ( !batchQuads ) {
+				return;
 			}
-			else {
-				quadMaterial->Bind();
+
+			batchMaterial->Bind();
+
+			const size_t bytes = batchQuads * 4 * sizeof(quadVertex_t);
+			size_t offset = 0u;
+			void *vertexBuffer = quadsVertexBuffer->MapStream( bytes, &offset );
+			std::memcpy( vertexBuffer, batchVertices, bytes );
+			quadsVertexBuffer->Unmap();
+
+			DrawQuads( offset, batchQuads );
+
+			frameStats.batches++;
+			batchQuads = 0u;
+			batchMaterial = nullptr;
+		}
+
+		// objects don't carry small ids, so pointers are folded down to the field width
+		// a collision only means two materials are grouped together, the stable sort keeps it correct
+		static uint64_t SortField( const void *p, uint32_t bits ) {
+			const uintptr_t value = reinterpret_cast<uintptr_t>( p ) >> 4;
+			return static_cast<uint64_t>( value ^ (value >> bits) ) & ((1u << bits) - 1u);
+		}
+
+		uint64_t RenderCommand::SortKey( uint8_t layer, const Material *material, bool translucent ) {
+			if ( !material ) {
+				material = quadMaterial;
 			}
 
-			vector2 vertices[4];
-			vector2 texcoords[4];
+			uint64_t key = static_cast<uint64_t>( layer ) << SORT_LAYER_SHIFT;
+			if ( translucent || !material->opaque ) {
+				return key | (1ull << SORT_TRANSLUCENT_SHIFT);
+			}
+
+			key |= SortField( material->shaderProgram, 10u ) << SORT_SHADER_SHIFT;
+			key |= SortField( material, 12u ) << SORT_MATERIAL_SHIFT;
+			if ( !material->samplerBindings.empty() ) {
+				key |= static_cast<uint64_t>( material->samplerBindings[0].texture->id & 0xFFFu ) << SORT_TEXTURE_SHIFT;
+			}
+			return key;
+		}
+
+		void RenderCommand::EndFrame( void ) {
+			quadsVertexBuffer->EndFrame();
+		}
+
+		static void DrawQuad( const rcDrawQuad_t *quad ) {
+			const Material *material = quad->material ? quad->material : quadMaterial;
+			if ( batchQuads == MAX_BATCH_QUADS || (batchQuads && material != batchMaterial) ) {
+				RenderCommand::Flush();
+			}
+			batchMaterial = material;
+
 			vector4 colour( 1.0f, 1.0f, 1.0f, 1.0f );
 			if ( quad->colour ) {
 				colour = *quad->colour;
 			}
 
+			quadVertex_t *vertices = &batchVertices[batchQuads * 4];
+
 			// Top-left
-			vertices[0].x = quad->x;
-			vertices[0].y = quad->y;
-			texcoords[0].x = quad->s1;
-			texcoords[0].y = quad->t1;
+			vertices[0].position.x = quad->x;
+			vertices[0].position.y = quad->y;
+			vertices[0].texCoord.x = quad->s1;
+			vertices[0].texCoord.y = quad->t1;
 
 			// Top-right
-			vertices[1].x = quad->x + quad->w;
-			vertices[1].y = quad->y;
-			texcoords[1].x = quad->s2;
-			texcoords[1].y = quad->t1;
+			vertices[1].position.x = quad->x + quad->w;
+			vertices[1].position.y = quad->y;
+			vertices[1].texCoord.x = quad->s2;
+			vertices[1].texCoord.y = quad->t1;
 
 			// Bottom-left
-			vertices[2].x = quad->x;
-			vertices[2].y = quad->y + quad->h;
-			texcoords[2].x = quad->s1;
-			texcoords[2].y = quad->t2;
+			vertices[2].position.x = quad->x;
+			vertices[2].position.y = quad->y + quad->h;
+			vertices[2].texCoord.x = quad->s1;
+			vertices[2].texCoord.y = quad->t2;
 
 			// Bottom-right
-			vertices[3].x = quad->x + quad->w;
-			vertices[3].y = quad->y + quad->h;
-			texcoords[3].x = quad->s2;
-			texcoords[3].y = quad->t2;
-			real32_t *vertexBuffer = static_cast<real32_t *>( quadsVertexBuffer->Map() );
+			vertices[3].position.x = quad->x + quad->w;
+			vertices[3].position.y = quad->y + quad->h;
+			vertices[3].texCoord.x = quad->s2;
+			vertices[3].texCoord.y = quad->t2;
+
 			for ( size_t i = 0u; i < 4; i++ ) {
-				*vertexBuffer++ = vertices[i].x;
-				*vertexBuffer++ = vertices[i].y;
-				*vertexBuffer++ = texcoords[i].x;
-				*vertexBuffer++ = texcoords[i].y;
-				*vertexBuffer++ = colour.r;
-				*vertexBuffer++ = colour.g;
-				*vertexBuffer++ = colour.b;
-				*vertexBuffer++ = colour.a;
+				vertices[i].colour = colour;
 			}
-			quadsVertexBuffer->Unmap();
 
-			quadsIndexBuffer->Bind();
+			batchQuads++;
+			frameStats.quads++;
+		}
 
-			glEnableVertexAttribArray( 0 );
-			glEnableVertexAttribArray( 1 );
-			glEnableVertexAttribArray( 2 );
-				intptr_t offset = 0;
-				const GLsizei stride = sizeof(vector2) + sizeof(vector2) + sizeof(vector4);
+		static void UpdateTextMesh( const rcUpdateTextMesh_t *update ) {
+			textMeshBuffer_t *mesh = update->mesh;
+			mesh->numQuads = update->numQuads;
+			if ( !update->numQuads ) {
+				return;
+			}
 
-				glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, stride, 0 );
-				offset += sizeof(vector2);
+			// text that changes every frame, like the HUD, keeps writing into the same buffer
+			if ( update->numQuads > mesh->capacity ) {
+				delete mesh->buffer;
+				mesh->capacity = std::max( update->numQuads, mesh->capacity * 2u );
+				mesh->buffer = new Buffer( Buffer::Type::VERTEX, nullptr, mesh->capacity * 4 * sizeof(quadVertex_t) );
+			}
+			mesh->buffer->Update( update->uploadData->data() + update->offset,
+				update->numQuads * 4 * sizeof(quadVertex_t) );
+		}
 
-				glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>( offset ) );
-				offset += sizeof(vector2);
+		static void DrawTextMesh( const rcDrawTextMesh_t *draw ) {
+			const textMeshBuffer_t *mesh = draw->mesh;
+			if ( !mesh->buffer || !mesh->numQuads ) {
+				return;
+			}
 
-				glVertexAttribPointer( 2, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>( offset ) );
-				offset += sizeof(vector4);
+			// anything batched before this has to be drawn first
+			RenderCommand::Flush();
 
-				glDrawElements( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0 );
-			glDisableVertexAttribArray( 2 );
-			glDisableVertexAttribArray( 1 );
-			glDisableVertexAttribArray( 0 );
+			const Material *material = draw->material ? draw->material : quadMaterial;
+			material->Bind();
+			mesh->buffer->Bind();
+			DrawQuads( 0u, mesh->numQuads );
+
+			frameStats.batches++;
+			frameStats.quads += mesh->numQuads;
 		}
 
 		static void Screenshot( const rcScreenshot_t *ss ) {
@@ -162,7 +266,7 @@ namespace XS {
 				glDeleteSync( ss->sync );
 				glBindBuffer( GL_PIXEL_PACK_BUFFER, ss->pbo );
 				void *data = glMapBuffer( GL_PIXEL_PACK_BUFFER, GL_READ_ONLY );
-					console.Print( "Writing screenshot %s (%ix%i)...\n", ss->name, ss->width, ss->height );
+					Backend::Print( "Writing screenshot %s (%ix%i)...\n", ss->name, ss->width, ss->height );
 					WritePNG( ss->name, (uint8_t*)data, ss->width, ss->height, 4 );
 				glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
 			}
@@ -173,7 +277,19 @@ namespace XS {
 			case Type::DRAWQUAD: {
 				DrawQuad( &drawQuad );
 			} break;
+			case Type::UPDATETEXTURE: {
+				updateTexture.texture->Update( updateTexture.x, updateTexture.y, updateTexture.width,
+					updateTexture.height, updateTexture.uploadData->data() + updateTexture.offset );
+			} break;
+			case Type::UPDATETEXTMESH: {
+				UpdateTextMesh( &updateTextMesh );
+			} break;
+			case Type::DRAWTEXTMESH: {
+				DrawTextMesh( &drawTextMesh );
+			} break;
 			case Type::SCREENSHOT: {
+				// the screenshot has to include any quads submitted before it
+				Flush();
 				Screenshot( &screenshot );
 			} break;
 			default: {
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <vector>
+
+#include "XSCommon/XSVector.h"
 #include "XSRenderer/XSRenderer.h"
 
 namespace XS {
@@ -8,6 +11,24 @@ namespace XS {
 
 		struct Material;
 		class Model;
+		class Texture;
+
+		namespace Backend {
+			class Buffer;
+		} // namespace Backend
+
+		struct quadVertex_t {
+			vector2	position;
+			vector2	texCoord;
+			vector4	colour;
+		};
+
+		// the backend's copy of a text mesh, only touched by render commands and render thread tasks
+		struct textMeshBuffer_t {
+			Backend::Buffer	*buffer;
+			uint32_t		 numQuads;
+			uint32_t		 capacity; // quads the buffer has room for, it's only replaced when a mesh outgrows it
+		};
 
 		struct rcDrawQuad_t {
 			real32_t		 x;
@@ -22,6 +43,26 @@ namespace XS {
 			const Material	*material;
 		};
 
+		struct rcUpdateTexture_t {
+			Texture						*texture;
+			uint32_t					 x, y;
+			uint32_t					 width, height;
+			const std::vector<uint8_t>	*uploadData; // owned by the view frame the command was added to
+			size_t						 offset;
+		};
+
+		struct rcUpdateTextMesh_t {
+			textMeshBuffer_t			*mesh;
+			const std::vector<uint8_t>	*uploadData; // owned by the view frame the command was added to
+			size_t						 offset;
+			uint32_t					 numQuads;
+		};
+
+		struct rcDrawTextMesh_t {
+			const textMeshBuffer_t	*mesh;
+			const Material			*material;
+		};
+
 		struct rcScreenshot_t {
 			int			 width;
 			int			 height;
@@ -30,17 +71,34 @@ namespace XS {
 			const char	*name;
 		};
 
+		// render commands are sorted per view by a 64 bit key, most significant field first
+		//	layer (8) | translucent (1) | shader (10) | material (12) | texture (12) | depth (21)
+		// translucent commands only fill in their layer, so the stable sort leaves them in submission order
+		// depth is reserved, 2d quads are all drawn at the same depth
+		#define SORT_LAYER_SHIFT		(56)
+		#define SORT_TRANSLUCENT_SHIFT	(55)
+		#define SORT_SHADER_SHIFT		(45)
+		#define SORT_MATERIAL_SHIFT		(33)
+		#define SORT_TEXTURE_SHIFT		(21)
+
 		struct RenderCommand {
 		public:
 			enum class Type {
 				DRAWQUAD = 0,
+				UPDATETEXTURE,
+				UPDATETEXTMESH,
+				DRAWTEXTMESH,
 				SCREENSHOT,
 				NUM_RENDER_CMDS
 			};
 			union {
-				rcDrawQuad_t	drawQuad;
-				rcScreenshot_t	screenshot;
+				rcDrawQuad_t		drawQuad;
+				rcUpdateTexture_t	updateTexture;
+				rcUpdateTextMesh_t	updateTextMesh;
+				rcDrawTextMesh_t	drawTextMesh;
+				rcScreenshot_t		screenshot;
 			};
+			uint64_t	sortKey;
 
 			// don't allow default instantiation
 			RenderCommand() = delete;
@@ -57,15 +115,34 @@ namespace XS {
 			);
 
 			RenderCommand( Type type )
-			: type( type )
+			: sortKey( 0u ), type( type )
 			{
 			}
 
+			// build the sort key for a command drawn with material, a null material is the default quad material
+			// translucent overrides an opaque material, e.g. for a quad drawn with a translucent colour
+			static uint64_t SortKey(
+				uint8_t layer,
+				const Material *material,
+				bool translucent = false
+			);
+
 			// dispatch the render command to the associated function
+			// consecutive quads with the same material are batched up and drawn together
 			void Execute(
 				void
 			) const;
 
+			// draw any quads still waiting to be batched, must be called after the last command of a view
+			static void Flush(
+				void
+			);
+
+			// fence the vertex data streamed this frame, call after every view has been rendered
+			static void EndFrame(
+				void
+			);
+
 		private:
 			Type type;
 		};
@@ -1,3 +1,7 @@
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include <SDL2/SDL.h>
 
 #include "XSCommon/XSCommon.h"
@@ -5,10 +9,15 @@
 #include "XSCommon/XSString.h"
 #include "XSCommon/XSError.h"
 #include "XSCommon/XSCvar.h"
+#include "XSCommon/XSTimeline.h"
+#include "XSCommon/XSTimer.h"
+#include "XSCommon/XSVector.h"
 #include "XSRenderer/XSRenderer.h"
 #include "XSRenderer/XSView.h"
 #include "XSRenderer/XSRenderCommand.h"
 #include "XSRenderer/XSBackend.h"
+#include "XSRenderer/XSInternalFormat.h"
+#include "XSRenderer/XSMaterial.h"
 #include "XSRenderer/XSFramebuffer.h"
 #include "XSRenderer/XSShaderProgram.h"
 #include "XSRenderer/XSTexture.h"
@@ -20,11 +29,15 @@ namespace XS {
 
 		static SDL_Window *window = nullptr;
 		static SDL_GLContext context;
+		static bool headless = false;
 
+		Cvar *r_backend = nullptr;
 		Cvar *r_clear = nullptr;
 		Cvar *r_debug = nullptr;
 		Cvar *r_multisample = nullptr;
 		Cvar *r_skipRender = nullptr;
+		Cvar *r_speeds = nullptr;
+		Cvar *r_thread = nullptr;
 		Cvar *r_swapInterval = nullptr;
 		Cvar *vid_height = nullptr;
 		Cvar *vid_noBorder = nullptr;
@@ -32,6 +45,29 @@ namespace XS {
 
 		std::vector<View *> views;
 		static View *currentView = nullptr;
+		static uint8_t currentLayer = 0u;
+
+		// cvars belong to the main thread, so anything the backend needs is copied when the frame is submitted
+		struct frameParams_t {
+			vector4	clear;
+			bool	skipRender;
+		};
+
+		// everything shared with the render thread is guarded by frameMutex
+		static std::thread renderThread;
+		static std::mutex frameMutex;
+		static std::condition_variable frameCondition;
+		static bool framePending = false; // submitted, but not rendered yet
+		static bool renderThreadQuit = false;
+		static bool renderThreadFailed = false;
+		static std::string renderThreadError;
+		static frameParams_t submittedParams;
+		static frameStats_t renderedStats = {}; // stats of the last frame the render thread finished
+		static std::vector<std::function<void( void )>> renderTasks;
+
+		static Timer frontendTimer;
+		static uint64_t frameNum = 0u;
+		static frameStats_t completedStats = {};
 
 		static const char *GLErrSeverityToString( GLenum severity ) {
 			switch ( severity ) {
@@ -125,28 +161,47 @@ namespace XS {
 				return;
 			}
 
-			console.Print( "[%s] [%s] %s: %s\n", GLErrSeverityToString( severity ), GLErrSourceToString( source ),
+			Backend::Print( "[%s] [%s] %s: %s\n", GLErrSeverityToString( severity ), GLErrSourceToString( source ),
 				GLErrTypeToString( type ), message );
 		}
 
 		void Init( void ) {
 			RegisterCvars();
 
-			CreateDisplay();
-
-			glewExperimental = GL_TRUE;
-			GLenum error = glewInit();
-			if ( error != GLEW_OK ) {
-				throw( XSError( String::Format( "Failed to initialise GLEW: %s\n",
-					glewGetErrorString( error ) ).c_str() ) );
+			// the null backend keeps the frontend's bookkeeping but never touches SDL video or GL
+			headless = !String::Compare( r_backend->GetCString(), "null" );
+			if ( headless ) {
+				console.Print( "Using the null renderer, nothing will be drawn\n" );
+				return;
 			}
-
-			if ( GLEW_ARB_debug_output ) {
-				glEnable( GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB );
-				glDebugMessageCallbackARB( OnGLError, nullptr );
+			else if ( String::Compare( r_backend->GetCString(), "gl" ) ) {
+				console.Print( "Unknown r_backend \"%s\", using gl\n", r_backend->GetCString() );
 			}
 
-			Backend::Init();
+			// the files needed before the first frame are read while the display is being created
+			ShaderProgram::Prefetch( "quad", "quad" );
+			ShaderProgram::Prefetch( "text", "text" );
+			Font::Prefetch( "menu" );
+			Font::Prefetch( "console" );
+
+			{
+				Timeline::Span span( "display" );
+				CreateDisplay();
+
+				glewExperimental = GL_TRUE;
+				GLenum error = glewInit();
+				if ( error != GLEW_OK ) {
+					throw( XSError( String::Format( "Failed to initialise GLEW: %s\n",
+						glewGetErrorString( error ) ).c_str() ) );
+				}
+
+				if ( GLEW_ARB_debug_output ) {
+					glEnable( GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB );
+					glDebugMessageCallbackARB( OnGLError, nullptr );
+				}
+
+				Backend::Init();
+			}
 
 			Texture::Init();
 			ShaderProgram::Init();
@@ -160,6 +215,13 @@ namespace XS {
 		void Shutdown( void ) {
 			console.Print( "Shutting down renderer...\n" );
 
+			if ( headless ) {
+				views.clear();
+				return;
+			}
+
+			JoinRenderThread();
+
 			RenderCommand::Shutdown();
 			Font::Shutdown();
 			Backend::Shutdown();
@@ -167,11 +229,24 @@ namespace XS {
 			DestroyDisplay();
 		}
 
+		bool IsHeadless( void ) {
+			return headless;
+		}
+
 		void RegisterCvars( void ) {
+			r_backend = Cvar::Create( "r_backend", "gl", "Render backend (gl, null)", CVAR_INIT );
 			r_clear = Cvar::Create( "r_clear", "0.5 0.0 0.0 1.0", "Colour of the backbuffer", CVAR_ARCHIVE );
 			r_debug = Cvar::Create( "r_debug", "0", "Enable debugging information", CVAR_ARCHIVE );
 			r_multisample = Cvar::Create( "r_multisample", "2", "Multisample Anti-Aliasing (MSAA) level", CVAR_ARCHIVE );
 			r_skipRender = Cvar::Create( "r_skipRender", "0", "skip rendering", CVAR_ARCHIVE );
+			r_speeds = Cvar::Create( "r_speeds", "0", "Show the number of quads, batches and draw calls per frame",
+				CVAR_ARCHIVE );
+		#ifdef XS_OS_MAC
+			// the window can only be presented from the main thread
+			r_thread = Cvar::Create( "r_thread", "0", "Render on a separate thread", CVAR_ARCHIVE );
+		#else
+			r_thread = Cvar::Create( "r_thread", "1", "Render on a separate thread", CVAR_ARCHIVE );
+		#endif
 			r_swapInterval = Cvar::Create( "r_swapInterval", "0", "Enable vertical sync", CVAR_ARCHIVE );
 			vid_height = Cvar::Create( "vid_height", "720", "Window height", CVAR_ARCHIVE );
 			vid_noBorder = Cvar::Create( "vid_noBorder", "0", "Disable window border", CVAR_ARCHIVE );
@@ -230,26 +305,238 @@ namespace XS {
 			SDL_Quit();
 		}
 
-		void Update( void ) {
-			const vector4 clear = { r_clear->GetFloat( 0 ), r_clear->GetFloat( 1 ), r_clear->GetFloat( 2 ),
-				r_clear->GetFloat( 3 ) };
-			glClearColor( clear.r, clear.g, clear.b, clear.a );
+		// run anything queued by RunOnRenderThread
+		static void RunRenderTasks( void ) {
+			std::vector<std::function<void( void )>> tasks;
+			{
+				std::lock_guard<std::mutex> lock( frameMutex );
+				tasks.swap( renderTasks );
+			}
+
+			for ( const auto &task : tasks ) {
+				task();
+			}
+		}
+
+		// execute every view's backend frame and present it
+		static void RenderFrame( const frameParams_t &params ) {
+			Timer backendTimer;
+			Backend::frameStats = {};
+
+			glClearColor( params.clear.r, params.clear.g, params.clear.b, params.clear.a );
 			glClear( GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT );
 
 			for ( const auto &view : views ) {
-				if ( r_skipRender->GetBool() ) {
-					continue;
+				viewFrame_t &frame = view->BackendFrame();
+				if ( !params.skipRender ) {
+					view->PreRender();
+					for ( const auto &cmd : frame.commands ) {
+						cmd.Execute();
+					}
+					RenderCommand::Flush();
+					view->PostRender();
 				}
+				frame.commands.clear();
+				frame.uploadData.clear();
+			}
+			RenderCommand::EndFrame();
+
+			RunRenderTasks();
+
+			SDL_GL_SwapWindow( window );
+			Timeline::EndStartup(); // the first frame is on screen
+
+			Backend::frameStats.backendMsec = backendTimer.GetTiming( false, Timer::Resolution::MILLISECONDS );
+		}
 
-				view->PreRender();
-				for ( const auto &cmd : view->renderCommands ) {
-					cmd.Execute();
+		static void RenderThread( void ) {
+			SDL_GL_MakeCurrent( window, context );
+
+			try {
+				while ( true ) {
+					frameParams_t params;
+					bool haveFrame = false;
+					{
+						std::unique_lock<std::mutex> lock( frameMutex );
+						frameCondition.wait( lock, [] {
+							return framePending || renderThreadQuit || !renderTasks.empty();
+						} );
+						// finish anything already submitted before quitting
+						if ( renderThreadQuit && !framePending && renderTasks.empty() ) {
+							break;
+						}
+						haveFrame = framePending;
+						params = submittedParams;
+					}
+
+					if ( haveFrame ) {
+						RenderFrame( params );
+					}
+					else {
+						RunRenderTasks();
+					}
+
+					{
+						std::lock_guard<std::mutex> lock( frameMutex );
+						if ( haveFrame ) {
+							framePending = false;
+							renderedStats = Backend::frameStats;
+						}
+					}
+					frameCondition.notify_all();
+				}
+			}
+			catch ( const XSError &e ) {
+				{
+					std::lock_guard<std::mutex> lock( frameMutex );
+					renderThreadError = e.what();
+					renderThreadFailed = true;
+					framePending = false;
 				}
-				view->PostRender();
-				view->renderCommands.clear();
+				frameCondition.notify_all();
 			}
 
-			SDL_GL_SwapWindow( window );
+			SDL_GL_MakeCurrent( window, nullptr );
+		}
+
+		// rethrow an error from the render thread on the main thread
+		// frameMutex must be held
+		static void CheckRenderThread( void ) {
+			if ( renderThreadFailed ) {
+				renderThreadFailed = false;
+				throw( XSError( renderThreadError.c_str() ) );
+			}
+		}
+
+		static void StartRenderThread( void ) {
+			// the context can only be current on one thread at a time
+			SDL_GL_MakeCurrent( window, nullptr );
+
+			renderThreadQuit = false;
+			renderThreadFailed = false;
+			renderThread = std::thread( RenderThread );
+		}
+
+		void JoinRenderThread( void ) {
+			if ( !renderThread.joinable() ) {
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock( frameMutex );
+				renderThreadQuit = true;
+			}
+			frameCondition.notify_all();
+			renderThread.join();
+
+			SDL_GL_MakeCurrent( window, context );
+			Backend::FlushPrints();
+		}
+
+		void RunOnRenderThread( const std::function<void( void )> &task, bool wait ) {
+			if ( !renderThread.joinable() ) {
+				task();
+				return;
+			}
+
+			if ( !wait ) {
+				{
+					std::lock_guard<std::mutex> lock( frameMutex );
+					renderTasks.push_back( task );
+				}
+				frameCondition.notify_all();
+				return;
+			}
+
+			bool done = false;
+			{
+				std::unique_lock<std::mutex> lock( frameMutex );
+				renderTasks.push_back( [&task, &done]( void ) {
+					task();
+					std::lock_guard<std::mutex> doneLock( frameMutex );
+					done = true;
+				} );
+				frameCondition.notify_all();
+				frameCondition.wait( lock, [&done] {
+					return done || renderThreadFailed;
+				} );
+				CheckRenderThread();
+			}
+		}
+
+		void BeginFrame( void ) {
+			frontendTimer.Start();
+			frameNum++;
+		}
+
+		uint64_t GetFrameNum( void ) {
+			return frameNum;
+		}
+
+		void Update( void ) {
+			const real64_t frontendMsec = frontendTimer.GetTiming( false, Timer::Resolution::MILLISECONDS );
+
+			// nothing to render or swap, just drop whatever was submitted so it doesn't pile up
+			if ( headless ) {
+				for ( const auto &view : views ) {
+					view->Flip();
+					viewFrame_t &frame = view->BackendFrame();
+					frame.commands.clear();
+					frame.uploadData.clear();
+				}
+				completedStats = {};
+				completedStats.frontendMsec = frontendMsec;
+				Timeline::EndStartup(); // nothing is presented, the first frame is done once it's dropped
+				return;
+			}
+
+			Backend::FlushPrints();
+
+			if ( r_thread->GetBool() && !renderThread.joinable() ) {
+				StartRenderThread();
+			}
+			else if ( !r_thread->GetBool() && renderThread.joinable() ) {
+				JoinRenderThread();
+			}
+
+			frameParams_t params;
+			params.clear = vector4( r_clear->GetFloat( 0 ), r_clear->GetFloat( 1 ), r_clear->GetFloat( 2 ),
+				r_clear->GetFloat( 3 ) );
+			params.skipRender = r_skipRender->GetBool();
+
+			if ( !renderThread.joinable() ) {
+				for ( const auto &view : views ) {
+					view->Flip();
+				}
+				RenderFrame( params );
+				completedStats = Backend::frameStats;
+				completedStats.frontendMsec = frontendMsec;
+				return;
+			}
+
+			{
+				std::unique_lock<std::mutex> lock( frameMutex );
+
+				// the backend must be done with the previous frame before its command lists can be reused
+				frameCondition.wait( lock, [] {
+					return !framePending || renderThreadFailed;
+				} );
+				CheckRenderThread();
+
+				completedStats = renderedStats;
+				completedStats.frontendMsec = frontendMsec;
+
+				for ( const auto &view : views ) {
+					view->Flip();
+				}
+				submittedParams = params;
+				framePending = true;
+			}
+			frameCondition.notify_all();
+		}
+
+		const frameStats_t &GetFrameStats( void ) {
+			return completedStats;
 		}
 
 		void RegisterView( View *view ) {
@@ -258,6 +545,11 @@ namespace XS {
 
 		void BindView( View *view ) {
 			currentView = view;
+			currentLayer = 0u;
+		}
+
+		void SetLayer( uint8_t layer ) {
+			currentLayer = layer;
 		}
 
 		static void AssertView( void ) {
@@ -282,8 +574,63 @@ namespace XS {
 			cmd.drawQuad.t2 = t2;
 			cmd.drawQuad.colour = colour;
 			cmd.drawQuad.material = material;
+			cmd.sortKey = RenderCommand::SortKey( currentLayer, material, colour && colour->a < 1.0f );
+
+			currentView->FrontendFrame().commands.push_back( cmd );
+		}
+
+		void UpdateTexture( Texture *texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+			const uint8_t *data )
+		{
+			AssertView();
+
+			viewFrame_t &frame = currentView->FrontendFrame();
+			const size_t bytes = width * height * GetBytesPerPixel( texture->internalFormat );
+			const size_t offset = frame.uploadData.size();
+			frame.uploadData.insert( frame.uploadData.end(), data, data + bytes );
+
+			// sorts ahead of anything in the layer that could be drawn with the texture
+			RenderCommand cmd( RenderCommand::Type::UPDATETEXTURE );
+			cmd.updateTexture.texture = texture;
+			cmd.updateTexture.x = x;
+			cmd.updateTexture.y = y;
+			cmd.updateTexture.width = width;
+			cmd.updateTexture.height = height;
+			cmd.updateTexture.uploadData = &frame.uploadData;
+			cmd.updateTexture.offset = offset;
+			cmd.sortKey = static_cast<uint64_t>( currentLayer ) << SORT_LAYER_SHIFT;
+
+			frame.commands.push_back( cmd );
+		}
+
+		void UpdateTextMesh( textMeshBuffer_t *mesh, const quadVertex_t *vertices, uint32_t numQuads ) {
+			AssertView();
+
+			viewFrame_t &frame = currentView->FrontendFrame();
+			const uint8_t *data = reinterpret_cast<const uint8_t *>( vertices );
+			const size_t offset = frame.uploadData.size();
+			frame.uploadData.insert( frame.uploadData.end(), data, data + (numQuads * 4 * sizeof(quadVertex_t)) );
+
+			// sorts ahead of anything in the layer, like texture updates
+			RenderCommand cmd( RenderCommand::Type::UPDATETEXTMESH );
+			cmd.updateTextMesh.mesh = mesh;
+			cmd.updateTextMesh.uploadData = &frame.uploadData;
+			cmd.updateTextMesh.offset = offset;
+			cmd.updateTextMesh.numQuads = numQuads;
+			cmd.sortKey = static_cast<uint64_t>( currentLayer ) << SORT_LAYER_SHIFT;
+
+			frame.commands.push_back( cmd );
+		}
+
+		void DrawTextMesh( const textMeshBuffer_t *mesh, const Material *material ) {
+			AssertView();
+
+			RenderCommand cmd( RenderCommand::Type::DRAWTEXTMESH );
+			cmd.drawTextMesh.mesh = mesh;
+			cmd.drawTextMesh.material = material;
+			cmd.sortKey = RenderCommand::SortKey( currentLayer, material );
 
-			currentView->renderCommands.push_back( cmd );
+			currentView->FrontendFrame().commands.push_back( cmd );
 		}
 
 	} // namespace Renderer
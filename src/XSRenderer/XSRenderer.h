@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+
 #include <GL/glew.h>
 
 namespace XS {
@@ -13,11 +15,28 @@ namespace XS {
 
 		struct Material;
 		struct View;
-
+		class Texture;
+		struct quadVertex_t;
+		struct textMeshBuffer_t;
+
+		// work done by the backend over one frame
+		struct frameStats_t {
+			uint32_t	quads; // quads submitted
+			uint32_t	batches; // runs of consecutive quads sharing a material
+			uint32_t	drawCalls; // glDraw* calls issued
+			uint32_t	bindsIssued; // program, texture and buffer binds that reached GL
+			uint32_t	bindsSkipped; // binds dropped because the object was already bound
+			real64_t	frontendMsec; // main thread, from BeginFrame to Update
+			real64_t	backendMsec; // executing the frame's commands and swapping
+		};
+
+		extern Cvar		*r_backend;
 		extern Cvar		*r_clear;
 		extern Cvar		*r_debug;
 		extern Cvar		*r_multisample;
 		extern Cvar		*r_skipRender;
+		extern Cvar		*r_speeds;
+		extern Cvar		*r_thread;
 		extern Cvar		*r_swapInterval;
 		extern Cvar		*vid_height;
 		extern Cvar		*vid_noBorder;
@@ -43,20 +62,57 @@ namespace XS {
 
 		// start up the renderer
 		// also creates a window and registers cvars
+		// with r_backend set to null there's no window or render context, and nothing is drawn
 		void Init(
 			void
 		);
 
+		// running with the null backend, so render resources must not be created
+		bool IsHeadless(
+			void
+		);
+
 		// shutdown the renderer
 		void Shutdown(
 			void
 		);
 
-		// render all views and flip the backbuffer
+		// mark the start of the frontend's work on a frame
+		void BeginFrame(
+			void
+		);
+
+		// hand the frame's render commands to the backend, which renders all views and flips the backbuffer
+		// with a render thread this returns once the previous frame has finished rendering, so the next frame can be
+		//	prepared while this one renders
 		void Update(
 			void
 		);
 
+		// stop the render thread and take the render context back on the calling thread, e.g. before releasing
+		//	render resources. the render thread is started again by the next Update if r_thread is set
+		void JoinRenderThread(
+			void
+		);
+
+		// run a function on the thread that owns the render context, after the next frame has been rendered
+		// runs straight away if there's no render thread
+		// when wait is set, doesn't return until it has run
+		void RunOnRenderThread(
+			const std::function<void( void )> &task,
+			bool wait
+		);
+
+		// counters for the most recently rendered frame
+		const frameStats_t &GetFrameStats(
+			void
+		);
+
+		// number of frames begun so far, i.e. the frame currently being built
+		uint64_t GetFrameNum(
+			void
+		);
+
 		//
 		// views
 		//
@@ -66,15 +122,45 @@ namespace XS {
 			View *view
 		);
 
-		// set the current view for subsequent rendering
+		// set the current view for subsequent rendering, resets the layer to 0
 		void BindView(
 			View *view
 		);
 
+		// subsequent render commands for the current view are drawn after those of lower layers
+		void SetLayer(
+			uint8_t layer
+		);
+
 		//
 		// render commands
 		//
 
+		// replace a region of a texture with tightly packed data in the texture's format
+		// the data is copied, so it can be changed as soon as this returns
+		void UpdateTexture(
+			Texture *texture,
+			uint32_t x,
+			uint32_t y,
+			uint32_t width,
+			uint32_t height,
+			const uint8_t *data
+		);
+
+		// replace the backend's copy of a text mesh with numQuads quads
+		// the vertices are copied, so they can be changed as soon as this returns
+		void UpdateTextMesh(
+			textMeshBuffer_t *mesh,
+			const quadVertex_t *vertices,
+			uint32_t numQuads
+		);
+
+		// draw every quad of a text mesh in one go, a null material will use the default quad material
+		void DrawTextMesh(
+			const textMeshBuffer_t *mesh,
+			const Material *material
+		);
+
 		// when called with a null material, will use default quad material
 		// when called with a null colour, will use white
 		void DrawQuad(
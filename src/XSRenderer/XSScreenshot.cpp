@@ -28,19 +28,24 @@ namespace XS {
 
 			void Cmd_Screenshot( const commandContext_t * const context ) {
 				const int32_t w = vid_width->GetInt(), h = vid_height->GetInt();
-				glBindBuffer( GL_PIXEL_PACK_BUFFER, defaultPbo );
-				glReadPixels( 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
-				GLsync sync = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
-
-				RenderCommand cmd( RenderCommand::Type::SCREENSHOT );
-				cmd.screenshot.name = GetScreenshotName();
-				cmd.screenshot.width = w;
-				cmd.screenshot.height = h;
-				cmd.screenshot.pbo = defaultPbo;
-				cmd.screenshot.sync = sync;
-
-				//TODO: wait until next frame
-				cmd.Execute();
+				const char *name = GetScreenshotName();
+
+				// read back once the next frame has been rendered
+				RunOnRenderThread( [w, h, name]( void ) {
+					glBindBuffer( GL_PIXEL_PACK_BUFFER, defaultPbo );
+					glReadPixels( 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+					GLsync sync = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+
+					RenderCommand cmd( RenderCommand::Type::SCREENSHOT );
+					cmd.screenshot.name = name;
+					cmd.screenshot.width = w;
+					cmd.screenshot.height = h;
+					cmd.screenshot.pbo = defaultPbo;
+					cmd.screenshot.sync = sync;
+
+					//TODO: wait until next frame
+					cmd.Execute();
+				}, false );
 			}
 
 		} // namespace Backend
@@ -1,9 +1,15 @@
+#include <memory>
+#include <unordered_map>
+
 #include "XSCommon/XSCommon.h"
+#include "XSCommon/XSAsyncFile.h"
 #include "XSCommon/XSConsole.h"
 #include "XSCommon/XSString.h"
 #include "XSCommon/XSFile.h"
 #include "XSCommon/XSError.h"
+#include "XSCommon/XSTimeline.h"
 #include "XSRenderer/XSRenderer.h"
+#include "XSRenderer/XSBackend.h"
 #include "XSRenderer/XSShaderProgram.h"
 #include "XSRenderer/XSVertexAttributes.h"
 
@@ -15,9 +21,31 @@ namespace XS {
 
 		const ShaderProgram *ShaderProgram::lastProgramUsed = nullptr;
 
-		void ShaderProgram::Init( void ) {
-			lastProgramUsed = nullptr;
-		}
+		// shader sources being read ahead of their ShaderProgram, by path
+		static std::unordered_map<std::string, std::unique_ptr<AsyncFile>> prefetched;
+
+		// drawn with by programs still waiting for their sources, the same as the quad shaders
+		static uint32_t fallbackProgram = 0u;
+		static const char *fallbackVertexSource =
+			"#version 140\n"
+			"uniform PerFrame {\n"
+			"	mat4 u_ProjectionMatrix;\n"
+			"	mat4 u_ViewMatrix;\n"
+			"};\n"
+			"in vec2 in_Position;\n"
+			"in vec4 in_Colour;\n"
+			"out vec4 colour;\n"
+			"void main() {\n"
+			"	gl_Position = u_ProjectionMatrix * vec4( in_Position, 0.0, 1.0 );\n"
+			"	colour = in_Colour;\n"
+			"}\n";
+		static const char *fallbackFragmentSource =
+			"#version 140\n"
+			"in vec4 colour;\n"
+			"out vec4 out_FragColor;\n"
+			"void main() {\n"
+			"	out_FragColor = colour;\n"
+			"}\n";
 
 		static void OutputProgramInfoLog( int program ) {
 			int logLength = 0;
@@ -110,25 +138,28 @@ namespace XS {
 			OutputShaderInfoLog (id);
 		}
 
-		Shader::Shader( ShaderType type, const char *name ) {
-			char path[XS_MAX_FILENAME] = { '\0' };
-
+		static void GetShaderPath( ShaderType type, const char *name, char *path, size_t pathLen ) {
 			switch ( type ) {
 			case ShaderType::VERTEX: {
-				String::FormatBuffer( path, sizeof(path), "shaders/v_%s.glsl", name );
+				String::FormatBuffer( path, pathLen, "shaders/v_%s.glsl", name );
 			} break;
 
 			case ShaderType::GEOMETRY: {
-				String::FormatBuffer( path, sizeof(path), "shaders/g_%s.glsl", name );
+				String::FormatBuffer( path, pathLen, "shaders/g_%s.glsl", name );
 			} break;
 
 			case ShaderType::FRAGMENT: {
-				String::FormatBuffer( path, sizeof(path), "shaders/f_%s.glsl", name );
+				String::FormatBuffer( path, pathLen, "shaders/f_%s.glsl", name );
 			} break;
 			default: {
 				throw( XSError( String::Format( "Shader(): Unknown shader type for \"%s\"", name ).c_str() ) );
 			} break;
 			}
+		}
+
+		Shader::Shader( ShaderType type, const char *name ) {
+			char path[XS_MAX_FILENAME] = { '\0' };
+			GetShaderPath( type, name, path, sizeof(path) );
 
 			const File f( path, FileMode::READ );
 			if ( !f.open ) {
@@ -142,6 +173,10 @@ namespace XS {
 			Create( name, contents.c_str(), type );
 		}
 
+		Shader::Shader( ShaderType type, const char *name, const char *source ) {
+			Create( name, source, type );
+		}
+
 		Shader::~Shader() {
 			glDeleteShader( id );
 		}
@@ -150,24 +185,117 @@ namespace XS {
 		// Shader Programs
 		//
 
+		void ShaderProgram::Init( void ) {
+			lastProgramUsed = nullptr;
+
+			static const VertexAttribute attributes[] = {
+				{ 0, "in_Position" },
+				{ 2, "in_Colour" }
+			};
+
+			const Shader vertexShader( ShaderType::VERTEX, "fallback", fallbackVertexSource );
+			const Shader fragmentShader( ShaderType::FRAGMENT, "fallback", fallbackFragmentSource );
+
+			fallbackProgram = glCreateProgram();
+			if ( !fallbackProgram ) {
+				throw( XSError( "Failed to create fallback shader program" ) );
+			}
+			glAttachShader( fallbackProgram, vertexShader.id );
+			glAttachShader( fallbackProgram, fragmentShader.id );
+			for ( const auto &attribute : attributes ) {
+				glBindAttribLocation( fallbackProgram, attribute.location, attribute.name );
+			}
+
+			int statusCode = 0;
+			glLinkProgram( fallbackProgram );
+			glGetProgramiv( fallbackProgram, GL_LINK_STATUS, &statusCode );
+			if ( statusCode == GL_FALSE ) {
+				console.Print( "Failed to link fallback program %d\n", fallbackProgram );
+				OutputProgramInfoLog( fallbackProgram );
+			}
+
+			GLint perFrame = glGetUniformBlockIndex( fallbackProgram, "PerFrame" );
+			if ( perFrame >= 0 ) {
+				glUniformBlockBinding( fallbackProgram, perFrame, 6 );
+			}
+
+			glDetachShader( fallbackProgram, vertexShader.id );
+			glDetachShader( fallbackProgram, fragmentShader.id );
+		}
+
+		// take over a source being read ahead, so only the program checks on it from then on
+		static std::unique_ptr<AsyncFile> TakePrefetched( ShaderType type, const char *name ) {
+			std::unique_ptr<AsyncFile> file;
+			if ( !name ) {
+				return file;
+			}
+
+			char path[XS_MAX_FILENAME] = { '\0' };
+			GetShaderPath( type, name, path, sizeof(path) );
+			auto it = prefetched.find( path );
+			if ( it != prefetched.end() ) {
+				file.swap( it->second );
+				prefetched.erase( it );
+			}
+			return file;
+		}
+
+		// compile a shader from its prefetched source if it has one, otherwise read it now
+		static Shader *CreateShader( ShaderType type, const char *name, std::unique_ptr<AsyncFile> &source ) {
+			if ( !source ) {
+				return new Shader( type, name );
+			}
+
+			// already read, so this doesn't block
+			if ( !source->Wait() ) {
+				throw( XSError( String::Format( "Shader(): Could not open file \"%s\"", name ).c_str() ) );
+			}
+			const std::vector<uint8_t> &bytes = source->GetContents();
+			const std::string contents( bytes.begin(), bytes.end() );
+			source.reset();
+
+			return new Shader( type, name, contents.c_str() );
+		}
+
 		// save some typing..
 		ShaderProgram::ShaderProgram( const char *vertexShaderName, const char *fragmentShaderName,
 			const VertexAttribute *attributes, int numAttributes )
+		: id( 0u ), vertexShaderName( vertexShaderName ? vertexShaderName : "" ),
+			fragmentShaderName( fragmentShaderName ? fragmentShaderName : "" ), attributes( attributes ),
+			numAttributes( numAttributes )
 		{
-			id = glCreateProgram();
-			if ( !id ) {
+			vertexSource = TakePrefetched( ShaderType::VERTEX, vertexShaderName );
+			fragmentSource = TakePrefetched( ShaderType::FRAGMENT, fragmentShaderName );
+
+			// don't wait on sources that are still being read, the first Bind after they are will link it
+			if ( IsReady() ) {
+				Create();
+			}
+		}
+
+		bool ShaderProgram::IsReady( void ) const {
+			return (!vertexSource || vertexSource->IsReady()) && (!fragmentSource || fragmentSource->IsReady());
+		}
+
+		void ShaderProgram::Create( void ) {
+			Timeline::Span span( String::FormatTemp( "shader %s/%s", vertexShaderName.c_str(),
+				fragmentShaderName.c_str() ) );
+
+			const uint32_t program = glCreateProgram();
+			if ( !program ) {
 				throw( XSError( "Failed to create shader program" ) );
 			}
+			id = program;
 
 			Shader *vertexShader = nullptr;
-			if ( vertexShaderName && !vertexShader ) {
-				vertexShader = new Shader( ShaderType::VERTEX, vertexShaderName );
+			if ( !vertexShaderName.empty() ) {
+				vertexShader = CreateShader( ShaderType::VERTEX, vertexShaderName.c_str(), vertexSource );
 				glAttachShader( id, vertexShader->id );
 			}
 
 			Shader *fragmentShader = nullptr;
-			if ( fragmentShaderName && !fragmentShader ) {
-				fragmentShader = new Shader( ShaderType::FRAGMENT, fragmentShaderName );
+			if ( !fragmentShaderName.empty() ) {
+				fragmentShader = CreateShader( ShaderType::FRAGMENT, fragmentShaderName.c_str(), fragmentSource );
 				glAttachShader( id, fragmentShader->id );
 			}
 
@@ -193,6 +321,34 @@ namespace XS {
 				glDetachShader( id, fragmentShader->id );
 				delete fragmentShader;
 			}
+
+			// the program is bound, so anything set while it was waiting can be applied
+			for ( const auto &setUniform : pendingUniforms ) {
+				setUniform();
+			}
+			pendingUniforms.clear();
+		}
+
+		void ShaderProgram::Prefetch( const char *vertexShaderName, const char *fragmentShaderName ) {
+			const struct {
+				ShaderType	type;
+				const char	*name;
+			} shaders[] = {
+				{ ShaderType::VERTEX, vertexShaderName },
+				{ ShaderType::FRAGMENT, fragmentShaderName },
+			};
+			for ( const auto &shader : shaders ) {
+				if ( !shader.name ) {
+					continue;
+				}
+
+				char path[XS_MAX_FILENAME] = { '\0' };
+				GetShaderPath( shader.type, shader.name, path, sizeof(path) );
+				std::unique_ptr<AsyncFile> &file = prefetched[path];
+				if ( !file ) {
+					file.reset( new AsyncFile( path ) );
+				}
+			}
 		}
 
 		ShaderProgram::~ShaderProgram() {
@@ -235,30 +391,75 @@ namespace XS {
 			}
 		}
 
-		void ShaderProgram::Bind( void ) const {
+		void ShaderProgram::Bind( void ) {
+			if ( !id ) {
+				if ( !IsReady() ) {
+					// the next Bind of any program has to be issued
+					glUseProgram( fallbackProgram );
+					lastProgramUsed = nullptr;
+					Backend::frameStats.bindsIssued++;
+					return;
+				}
+				Create();
+			}
+
 			if ( lastProgramUsed != this ) {
 				glUseProgram( id );
 				lastProgramUsed = this;
+				Backend::frameStats.bindsIssued++;
+			}
+			else {
+				Backend::frameStats.bindsSkipped++;
 			}
 		}
 
 		void ShaderProgram::SetUniform1( const char *name, int i ) {
+			if ( !id ) {
+				pendingUniforms.push_back( [this, name, i]( void ) {
+					SetUniform1( name, i );
+				} );
+				return;
+			}
 			glUniform1i( GetUniform( name ).location, i );
 		}
 
 		void ShaderProgram::SetUniform1( const char *name, float f ) {
+			if ( !id ) {
+				pendingUniforms.push_back( [this, name, f]( void ) {
+					SetUniform1( name, f );
+				} );
+				return;
+			}
 			glUniform1f( GetUniform( name ).location, f );
 		}
 
 		void ShaderProgram::SetUniform2( const char *name, float f1, float f2 ) {
+			if ( !id ) {
+				pendingUniforms.push_back( [this, name, f1, f2]( void ) {
+					SetUniform2( name, f1, f2 );
+				} );
+				return;
+			}
 			glUniform2f( GetUniform( name ).location, f1, f2 );
 		}
 
 		void ShaderProgram::SetUniform3( const char *name, float f1, float f2, float f3 ) {
+			if ( !id ) {
+				pendingUniforms.push_back( [this, name, f1, f2, f3]( void ) {
+					SetUniform3( name, f1, f2, f3 );
+				} );
+				return;
+			}
 			glUniform3f( GetUniform( name ).location, f1, f2, f3 );
 		}
 
 		void ShaderProgram::SetUniform4( const char *name, float f1, float f2, float f3, float f4 ) {
+			if ( !id ) {
+				pendingUniforms.push_back( [this, name, f1, f2, f3, f4]( void ) {
+					SetUniform4( name, f1, f2, f3, f4 );
+				} );
+				return;
+			}
 			glUniform4f( GetUniform( name ).location, f1, f2, f3, f4 );
 		}
 
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace XS {
 
+	class AsyncFile;
+
 	namespace Renderer {
 
 		// forward declarations
@@ -36,11 +41,19 @@ namespace XS {
 			Shader( const Shader& ) = delete;
 			Shader& operator=( const Shader& ) = delete;
 
+			// read the source from shaders/
 			Shader(
 				ShaderType type,
 				const char *name
 			);
 
+			// compile source that has already been read
+			Shader(
+				ShaderType type,
+				const char *name,
+				const char *source
+			);
+
 			~Shader();
 		};
 
@@ -56,16 +69,35 @@ namespace XS {
 		};
 
 
+		// a program whose sources were prefetched but haven't been read yet isn't linked until the first Bind after
+		//	they have, which happens on whichever thread draws with it
+		// until then it draws with a flat colour fallback, and uniforms set on it are kept until it's linked, so they
+		//	must be set before it's first drawn
 		class ShaderProgram {
 		private:
-			uint32_t						id;
-			std::vector<ProgramVariable>	uniforms;
+			uint32_t									 id; // 0 until linked
+			std::vector<ProgramVariable>				 uniforms;
+			std::string									 vertexShaderName, fragmentShaderName;
+			const VertexAttribute						*attributes; // must outlive the program until it's linked
+			int											 numAttributes;
+			std::unique_ptr<AsyncFile>					 vertexSource, fragmentSource; // nullptr if not prefetched
+			std::vector<std::function<void( void )>>	 pendingUniforms; // set before it was linked
 
 			// ???
 			ProgramVariable &GetUniform(
 				const char *name
 			);
 
+			// the prefetched sources have been read, so linking won't block
+			bool IsReady(
+				void
+			) const;
+
+			// compile the shaders and link them
+			void Create(
+				void
+			);
+
 		public:
 			static const ShaderProgram *lastProgramUsed;
 
@@ -74,6 +106,12 @@ namespace XS {
 				void
 			);
 
+			// start reading a ShaderProgram's sources on a worker thread, constructing it later uses what was read
+			static void Prefetch(
+				const char *vertexShaderName,
+				const char *fragmentShaderName
+			);
+
 			// create a ShaderProgram with a vertex shader and/or a fragment shader and specify default attributes
 			//TODO: geometry shader?
 			ShaderProgram(
@@ -90,10 +128,10 @@ namespace XS {
 				void
 			) const;
 
-			// use this ShaderProgram for subsequent rendering
+			// use this ShaderProgram for subsequent rendering, linking it first if its sources have been read since
 			void Bind(
 				void
-			) const;
+			);
 
 			// set the specified uniform variable's value
 			//TODO: variadic arguments?
@@ -0,0 +1,157 @@
+#include "XSCommon/XSCommon.h"
+#include "XSCommon/XSCvar.h"
+#include "XSRenderer/XSRenderer.h"
+#include "XSRenderer/XSRenderCommand.h"
+#include "XSRenderer/XSBuffer.h"
+#include "XSRenderer/XSFont.h"
+#include "XSRenderer/XSTextMesh.h"
+
+namespace XS {
+
+	namespace Renderer {
+
+		TextMesh::TextMesh()
+		: font( nullptr ), numRuns( 0u ), laidOut( true ), incomplete( false )
+		{
+		}
+
+		TextMesh::~TextMesh() {
+			// frames already submitted may still draw them
+			for ( auto &page : pages ) {
+				textMeshBuffer_t *mesh = page.backendBuffer;
+				RunOnRenderThread( [mesh]( void ) {
+					delete mesh->buffer;
+					delete mesh;
+				}, false );
+			}
+		}
+
+		void TextMesh::Clear( const Font *newFont ) {
+			font = newFont;
+			text.clear();
+			numRuns = 0u;
+			shelves.clear();
+			laidOut = false;
+		}
+
+		void TextMesh::Add( const vector2 &newPos, const char *newText, size_t length ) {
+			// glyphs are only rasterised when it's drawn
+			if ( numRuns == runs.size() ) {
+				runs.push_back( textRun_t() );
+			}
+			textRun_t &run = runs[numRuns++];
+			run.pos = newPos;
+			run.text.assign( newText, length );
+			laidOut = false;
+		}
+
+		void TextMesh::Set( const Font *newFont, const vector2 &newPos, const char *newText ) {
+			if ( newFont == font && newPos.x == pos.x && newPos.y == pos.y && newText == text ) {
+				return;
+			}
+
+			Clear( newFont );
+			Add( newPos, newText, strlen( newText ) );
+			pos = newPos;
+			text = newText;
+		}
+
+		void TextMesh::Build( void ) {
+			for ( auto &page : pages ) {
+				page.vertices.clear();
+				page.modified = true;
+			}
+			shelves.clear();
+			incomplete = false;
+
+			FontFace *face = font->GetFace();
+			const float scale = font->scale;
+			const std::function<void( uint32_t, const vector2 & )> emit = [&]( uint32_t codepoint, const vector2 &pen )
+			{
+				const fontGlyph_t *glyph = face->GetGlyph( codepoint );
+				if ( !glyph ) {
+					incomplete = true;
+					return;
+				}
+
+				while ( pages.size() <= glyph->page ) {
+					textPage_t page;
+					page.modified = true;
+					page.backendBuffer = new textMeshBuffer_t();
+					page.backendBuffer->buffer = nullptr;
+					page.backendBuffer->numQuads = 0u;
+					page.backendBuffer->capacity = 0u;
+					pages.push_back( page );
+				}
+
+				// glyphs on a shelf tend to be laid out together, so only look back one
+				if ( shelves.empty() || shelves.back().page != glyph->page
+					|| shelves.back().shelf != glyph->shelf )
+				{
+					bool found = false;
+					for ( const auto &shelf : shelves ) {
+						if ( shelf.page == glyph->page && shelf.shelf == glyph->shelf ) {
+							found = true;
+							break;
+						}
+					}
+					if ( !found ) {
+						shelves.push_back( { glyph->page, glyph->shelf,
+							face->GetShelfGeneration( glyph->page, glyph->shelf ) } );
+					}
+				}
+
+				const FontData &fd = glyph->data;
+				const real32_t x1 = pen.x + (fd.offset.x * scale);
+				const real32_t y1 = pen.y + (fd.offset.y * scale);
+				const real32_t x2 = x1 + (fd.size.x * scale);
+				const real32_t y2 = y1 + (fd.size.y * scale);
+				const vector4 colour( 1.0f, 1.0f, 1.0f, 1.0f );
+
+				// top-left, top-right, bottom-left, bottom-right, as DrawQuad lays them out
+				std::vector<quadVertex_t> &vertices = pages[glyph->page].vertices;
+				vertices.push_back( { vector2( x1, y1 ), vector2( fd.s.x, fd.t.x ), colour } );
+				vertices.push_back( { vector2( x2, y1 ), vector2( fd.s.y, fd.t.x ), colour } );
+				vertices.push_back( { vector2( x1, y2 ), vector2( fd.s.x, fd.t.y ), colour } );
+				vertices.push_back( { vector2( x2, y2 ), vector2( fd.s.y, fd.t.y ), colour } );
+			};
+			for ( size_t i = 0u; i < numRuns; i++ ) {
+				const textRun_t &run = runs[i];
+				font->Layout( run.pos, run.text.c_str(), run.text.length(), emit );
+			}
+
+			laidOut = true;
+		}
+
+		void TextMesh::Draw( void ) {
+			if ( !font ) {
+				return;
+			}
+
+			// keep our shelves from being evicted this frame, and start again if any already were
+			FontFace *face = font->GetFace();
+			for ( const auto &shelf : shelves ) {
+				if ( !face->TouchShelf( shelf.page, shelf.shelf, shelf.generation ) ) {
+					laidOut = false;
+				}
+			}
+			if ( !laidOut || incomplete ) {
+				Build();
+			}
+
+			for ( uint32_t i = 0u; i < pages.size(); i++ ) {
+				textPage_t &page = pages[i];
+				if ( page.modified ) {
+					UpdateTextMesh( page.backendBuffer, page.vertices.data(),
+						static_cast<uint32_t>( page.vertices.size() / 4u ) );
+					page.modified = false;
+				}
+				if ( !page.vertices.empty() ) {
+					DrawTextMesh( page.backendBuffer, face->GetPageMaterial( i ) );
+				}
+			}
+		}
+
+	} // namespace Renderer
+
+} // namespace XS
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "XSRenderer/XSRenderCommand.h"
+
+namespace XS {
+
+	namespace Renderer {
+
+		class Font;
+
+		// a string laid out once into quads, then drawn from the same vertex buffers every frame until it changes
+		// a mesh only holds text in one font, with a vertex buffer for each of the face's atlas pages it uses
+		// the glyphs' shelves are checked every frame, and the text is laid out again if any have been evicted
+		class TextMesh {
+		private:
+			struct textRun_t {
+				vector2		pos;
+				std::string	text;
+			};
+
+			struct textPage_t {
+				std::vector<quadVertex_t>	 vertices;
+				bool						 modified; // since the last upload
+				textMeshBuffer_t			*backendBuffer;
+			};
+
+			// a shelf the vertices read from
+			struct textShelf_t {
+				uint32_t	page, shelf;
+				uint32_t	generation;
+			};
+
+			const Font					*font;
+			vector2						 pos; // where Set laid out text
+			std::string					 text;
+			std::vector<textRun_t>		 runs; // reused, so setting new text doesn't allocate once it's been seen
+			size_t						 numRuns; // added since the last Clear
+			std::vector<textPage_t>		 pages; // by the face's page index
+			std::vector<textShelf_t>	 shelves;
+			bool						 laidOut; // the vertices match the runs
+			bool						 incomplete; // a glyph couldn't be rasterised, try again next frame
+
+			// turn the runs into vertices, rasterising any glyphs that aren't in the atlas
+			void Build(
+				void
+			);
+
+		public:
+			TextMesh();
+			TextMesh( const TextMesh& ) = delete;
+			TextMesh& operator=( const TextMesh& ) = delete;
+
+			// the backend's copies are freed once the frames already submitted are done with them, but it must not
+			//	be drawn in the frame it's destroyed in
+			~TextMesh();
+
+			// forget everything added so far and start again with a font
+			void Clear(
+				const Font *font
+			);
+
+			// add a UTF-8 string, laid out as Font::Draw would, wrapping against vid_width
+			// nothing is measured until it's drawn, use Font::GetTextLineCount to find how many lines it takes
+			void Add(
+				const vector2 &pos,
+				const char *text,
+				size_t length
+			);
+
+			// lay out a single string, doing nothing if the font, position and text are unchanged
+			void Set(
+				const Font *font,
+				const vector2 &pos,
+				const char *text
+			);
+
+			// add the mesh to the current view, laying it out and uploading it first if it changed
+			void Draw(
+				void
+			);
+		};
+
+	} // namespace Renderer
+
+} // namespace XS
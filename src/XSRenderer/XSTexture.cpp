@@ -3,6 +3,7 @@
 #include "XSCommon/XSString.h"
 #include "XSCommon/XSError.h"
 #include "XSRenderer/XSRenderer.h"
+#include "XSRenderer/XSBackend.h"
 #include "XSRenderer/XSTexture.h"
 
 namespace XS {
@@ -54,8 +55,11 @@ namespace XS {
 			}
 		}
 
-		Texture::Texture( unsigned int width, unsigned int height, InternalFormat internalFormat, const uint8_t *data ) {
-			size_t filterMode = GetTextureFilter( r_textureFilter->GetCString() );
+		Texture::Texture( unsigned int width, unsigned int height, InternalFormat internalFormat, const uint8_t *data )
+		: mipmapped( false ), mipmapsDirty( false ), width( width ), height( height ), internalFormat( internalFormat )
+		{
+			// textures may be created on the render thread
+			size_t filterMode = GetTextureFilter( r_textureFilter->GetString().c_str() );
 
 			glGenTextures( 1, &id );
 			if ( !id ) {
@@ -93,13 +97,34 @@ namespace XS {
 				filterTable[filterMode].min == GL_LINEAR_MIPMAP_NEAREST )
 			{
 				glGenerateMipmap( GL_TEXTURE_2D );
+				mipmapped = true;
 			}
  		}
 
 		Texture::~Texture() {
+			// a new texture could be allocated at the same address
+			for ( auto &texture : lastUsedTexture ) {
+				if ( texture == this ) {
+					texture = nullptr;
+				}
+			}
+
 			glDeleteTextures( 1, &id );
 		}
 
+		void Texture::Update( uint32_t x, uint32_t y, uint32_t regionWidth, uint32_t regionHeight,
+			const uint8_t *data )
+		{
+			SDL_assert( x + regionWidth <= width && y + regionHeight <= height && "Texture::Update: out of bounds" );
+
+			Bind( 0 );
+
+			glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+			glTexSubImage2D( GL_TEXTURE_2D, 0, x, y, regionWidth, regionHeight, GetGLFormat( internalFormat ),
+				GetDataTypeForFormat( internalFormat ), data );
+			mipmapsDirty = mipmapped;
+		}
+
 		void Texture::Bind( int unit ) const {
 			if ( lastUsedTextureUnit != unit ) {
 				glActiveTexture( GL_TEXTURE0 + unit );
@@ -108,6 +133,17 @@ namespace XS {
 
 			if ( lastUsedTexture[unit] != this ) {
 				glBindTexture( GL_TEXTURE_2D, id );
+				lastUsedTexture[unit] = this;
+				Backend::frameStats.bindsIssued++;
+			}
+			else {
+				Backend::frameStats.bindsSkipped++;
+			}
+
+			// once per batch of updates rather than once per update
+			if ( mipmapsDirty ) {
+				glGenerateMipmap( GL_TEXTURE_2D );
+				mipmapsDirty = false;
 			}
 		}
 
@@ -14,8 +14,13 @@ namespace XS {
 			static const Texture	*lastUsedTexture[MAX_TEXTURE_UNITS];
 			static int				 lastUsedTextureUnit;
 
+			bool					 mipmapped;
+			mutable bool			 mipmapsDirty; // the base level was updated, regenerated on the next bind
+
 		public:
-			uint32_t	id;
+			uint32_t		id;
+			uint32_t		width, height;
+			InternalFormat	internalFormat;
 
 			// don't allow default instantiation
 			Texture() = delete;
@@ -36,6 +41,16 @@ namespace XS {
 
 			~Texture();
 
+			// replace a region of the base level with tightly packed data in the texture's format
+			// mipmaps are regenerated the next time the texture is bound
+			void Update(
+				uint32_t x,
+				uint32_t y,
+				uint32_t regionWidth,
+				uint32_t regionHeight,
+				const uint8_t *data
+			);
+
 			// bind the current texture to the specified unit for subsequent rendering
 			void Bind(
 				int unit
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "XSCommon/XSCommon.h"
 #include "XSCommon/XSCvar.h"
 #include "XSCommon/XSError.h"
@@ -10,8 +12,45 @@ namespace XS {
 
 	namespace Renderer {
 
+		// stable least significant digit radix sort, a byte at a time
+		// passes where every key has the same byte are skipped, most of a key is usually the same across a view
+		static void RadixSort( std::vector<sortItem_t> &items, std::vector<sortItem_t> &scratch ) {
+			const size_t count = items.size();
+			scratch.resize( count );
+
+			sortItem_t *src = items.data();
+			sortItem_t *dst = scratch.data();
+			for ( uint32_t shift = 0u; shift < 64u; shift += 8u ) {
+				size_t offsets[256] = {};
+				for ( size_t i = 0u; i < count; i++ ) {
+					offsets[(src[i].key >> shift) & 0xFFu]++;
+				}
+				if ( offsets[(src[0].key >> shift) & 0xFFu] == count ) {
+					continue;
+				}
+
+				size_t total = 0u;
+				for ( auto &offset : offsets ) {
+					const size_t bucketSize = offset;
+					offset = total;
+					total += bucketSize;
+				}
+
+				for ( size_t i = 0u; i < count; i++ ) {
+					dst[offsets[(src[i].key >> shift) & 0xFFu]++] = src[i];
+				}
+				std::swap( src, dst );
+			}
+
+			// an odd number of passes leaves the result in the scratch buffer
+			if ( src != items.data() ) {
+				items.swap( scratch );
+			}
+		}
+
 		View::View( uint32_t width, uint32_t height, renderCallback_t preRender, renderCallback_t postRender )
-		: width( width ), height( height ), callbackPreRender( preRender ), callbackPostRender( postRender )
+		: width( width ), height( height ), callbackPreRender( preRender ), callbackPostRender( postRender ),
+			frontendFrame( 0u )
 		{
 			if ( !width || !height ) {
 				throw( XSError( "Registered View with 0 width or 0 height" ) );
@@ -38,7 +77,27 @@ namespace XS {
 				callbackPreRender();
 			}
 
-			// sort surfaces etc?
+			SortCommands();
+		}
+
+		void View::SortCommands( void ) {
+			std::vector<RenderCommand> &renderCommands = BackendFrame().commands;
+			const size_t count = renderCommands.size();
+			if ( count < 2u ) {
+				return;
+			}
+
+			sortItems.clear();
+			for ( size_t i = 0u; i < count; i++ ) {
+				sortItems.push_back( { renderCommands[i].sortKey, static_cast<uint32_t>( i ) } );
+			}
+			RadixSort( sortItems, sortScratch );
+
+			sortedCommands.clear();
+			for ( const auto &item : sortItems ) {
+				sortedCommands.push_back( renderCommands[item.index] );
+			}
+			renderCommands.swap( sortedCommands );
 		}
 
 		void View::PostRender( void ) const {
@@ -15,16 +15,40 @@ namespace XS {
 		// used for pre/post render callbacks
 		typedef void (*renderCallback_t)( void );
 
+		// a render command's sort key and its position in the view's command list
+		struct sortItem_t {
+			uint64_t	key;
+			uint32_t	index;
+		};
+
+		// commands are double-buffered, the frontend fills one frame while the backend renders the other
+		#define NUM_VIEW_FRAMES (2u)
+
+		struct viewFrame_t {
+			std::vector<RenderCommand>	commands;
+			std::vector<uint8_t>		uploadData; // data for UPDATETEXTURE and UPDATETEXTMESH commands
+		};
+
 		struct View {
 		private:
-			uint32_t			width, height;
-			renderCallback_t	callbackPreRender, callbackPostRender;
+			uint32_t					width, height;
+			renderCallback_t			callbackPreRender, callbackPostRender;
+			uint32_t					frontendFrame; // index of the frame being filled by the frontend
+			viewFrame_t					frames[NUM_VIEW_FRAMES];
+
+			// scratch space for sorting, kept between frames
+			std::vector<sortItem_t>		sortItems, sortScratch;
+			std::vector<RenderCommand>	sortedCommands;
+
+			// reorder the backend frame's commands by sort key
+			void SortCommands(
+				void
+			);
 
 		public:
 			matrix4						 projectionMatrix;
 			matrix4						 viewMatrix;
 			Backend::Buffer				*perFrameData;
-			std::vector<RenderCommand>	 renderCommands;
 
 			// construct a view, specifying additional callbacks if necessary
 			View(
@@ -44,8 +68,25 @@ namespace XS {
 				void
 			);
 
+			// the frame render commands are currently added to
+			inline viewFrame_t &FrontendFrame( void ) {
+				return frames[frontendFrame];
+			}
+
+			// the frame being rendered
+			inline viewFrame_t &BackendFrame( void ) {
+				return frames[(frontendFrame + 1u) % NUM_VIEW_FRAMES];
+			}
+
+			// hand the frontend's frame over to the backend
+			// do not call externally, only valid while the backend is idle
+			inline void Flip( void ) {
+				frontendFrame = (frontendFrame + 1u) % NUM_VIEW_FRAMES;
+			}
+
 			// prepare the view for rendering, i.e. adding objects to the scene
 			// do not call externally, set callbacks via constructor
+			// runs on the render thread if there is one
 			void PreRender(
 				void
 			);
@@ -4,6 +4,17 @@ namespace XS {
 
 	namespace OS {
 
+		// a read-only view of a whole file, filled in by MapFile
+		struct mappedFile_t {
+			void		*base; // as the OS returned it, only MapFile/UnmapFile use this
+			size_t		 length;
+			intptr_t	 handle; // platform-specific
+
+			inline const uint8_t *Data( void ) const {
+				return static_cast<const uint8_t *>( base );
+			}
+		};
+
 		// retrieve the current working directory
 		void GetCurrentWorkingDirectory(
 			char *cwd,
@@ -17,6 +28,18 @@ namespace XS {
 			int32_t *outTime
 		);
 
+		// map the whole file at the full OS path into memory, read-only
+		// returns false if the file could not be opened or mapped, or is empty
+		bool MapFile(
+			const char *path,
+			mappedFile_t *outMapping
+		);
+
+		// release a mapping created by MapFile
+		void UnmapFile(
+			mappedFile_t *mapping
+		);
+
 		// returns true if file exists
 		bool MkDir(
 			const char *path
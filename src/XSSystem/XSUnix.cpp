@@ -1,6 +1,8 @@
 #if defined(XS_OS_LINUX) || defined(XS_OS_MAC)
 
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include "XSCommon/XSCommon.h"
@@ -35,6 +37,39 @@ namespace XS {
 			return true;
 		}
 
+		bool MapFile( const char *path, mappedFile_t *outMapping ) {
+			*outMapping = {};
+
+			const int fd = open( path, O_RDONLY );
+			if ( fd == -1 ) {
+				return false;
+			}
+
+			struct stat buf;
+			if ( fstat( fd, &buf ) || buf.st_size <= 0 ) {
+				close( fd );
+				return false;
+			}
+
+			void *data = mmap( nullptr, static_cast<size_t>( buf.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+			// the mapping keeps its own reference to the file
+			close( fd );
+			if ( data == MAP_FAILED ) {
+				return false;
+			}
+
+			outMapping->base = data;
+			outMapping->length = static_cast<size_t>( buf.st_size );
+			return true;
+		}
+
+		void UnmapFile( mappedFile_t *mapping ) {
+			if ( mapping->base ) {
+				munmap( mapping->base, mapping->length );
+			}
+			*mapping = {};
+		}
+
 		bool MkDir( const char *path ) {
 			if ( mkdir( path, S_IRWXU | S_IXGRP | S_IRGRP ) ) {
 				if ( errno != EEXIST ) {
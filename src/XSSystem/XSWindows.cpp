@@ -33,6 +33,48 @@ namespace XS {
 			return true;
 		}
 
+		bool MapFile( const char *path, mappedFile_t *outMapping ) {
+			*outMapping = {};
+
+			HANDLE file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+				FILE_ATTRIBUTE_NORMAL, nullptr );
+			if ( file == INVALID_HANDLE_VALUE ) {
+				return false;
+			}
+
+			LARGE_INTEGER size;
+			if ( !GetFileSizeEx( file, &size ) || size.QuadPart <= 0 ) {
+				CloseHandle( file );
+				return false;
+			}
+
+			HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+			// the mapping keeps its own reference to the file
+			CloseHandle( file );
+			if ( !mapping ) {
+				return false;
+			}
+
+			void *data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+			if ( !data ) {
+				CloseHandle( mapping );
+				return false;
+			}
+
+			outMapping->base = data;
+			outMapping->length = static_cast<size_t>( size.QuadPart );
+			outMapping->handle = reinterpret_cast<intptr_t>( mapping );
+			return true;
+		}
+
+		void UnmapFile( mappedFile_t *mapping ) {
+			if ( mapping->base ) {
+				UnmapViewOfFile( mapping->base );
+				CloseHandle( reinterpret_cast<HANDLE>( mapping->handle ) );
+			}
+			*mapping = {};
+		}
+
 		bool MkDir( const char *path ) {
 			if ( !CreateDirectory( path, nullptr ) ) {
 				if ( GetLastError() != ERROR_ALREADY_EXISTS ) {